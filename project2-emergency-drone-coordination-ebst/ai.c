@@ -3,115 +3,315 @@
 #include <unistd.h>
 #include <string.h>
 #include <limits.h>
+#include <inttypes.h>
 #include "headers/ai.h"
 #include "headers/drone.h"
 #include "headers/map.h"
 #include "headers/survivor.h"
 #include "headers/globals.h"
+#include "headers/tour.h"
+#include "headers/mission_index.h"
+#include "headers/sla.h"
+#include "headers/simclock.h"
+#include "headers/metrics.h"
+#include "headers/trace.h"
 
-void assign_mission(Drone *drone, Coord target, const char *mission_id) {
-    pthread_mutex_lock(&drone->lock);
-    drone->target = target;
+void assign_mission(Drone *drone, Coord target, uint64_t mission_id) {
+    Tour tour = { .count = 1 };
+    tour.stops[0].coord = target;
+    tour.stops[0].id = mission_id;
+    snprintf(tour.stops[0].mission_id, sizeof(tour.stops[0].mission_id), "%" PRIu64, mission_id);
+    assign_tour(drone, &tour);
+}
+
+void assign_tour(Drone *drone, const Tour *tour) {
+    uint64_t span = trace_start();
+    lock_acquire(&drone->lock);
+    drone->target = tour->stops[0].coord;
+    drone->tour = *tour;
+    drone->pending_stops = tour->count;
     drone->status = ON_MISSION;
+    drone->dispatch_coord = drone->coord;
+    drone->departed = 0;
+    for (int i = 0; i < tour->count; i++) {
+        mission_index_set_drone(tour->stops[i].id, drone);
+        trace_stage_end(STAGE_WAITING, tour->stops[i].id);
+        trace_stage_begin(STAGE_FLYING, tour->stops[i].id);
+    }
+    sla_mark_assigned(tour);
+    counter_add(metrics.stops_assigned, tour->count);
     
     // Create mission assignment message
     struct json_object *mission = json_object_new_object();
     json_object_object_add(mission, "type", json_object_new_string("ASSIGN_MISSION"));
-    json_object_object_add(mission, "mission_id", json_object_new_string(mission_id));
+    json_object_object_add(mission, "mission_id", json_object_new_string(tour->stops[0].mission_id));
     json_object_object_add(mission, "priority", json_object_new_string("high"));
     
-    // Add target coordinates
+    // Add target coordinates (first stop, for drones that ignore waypoints)
     struct json_object *target_obj = json_object_new_object();
-    json_object_object_add(target_obj, "x", json_object_new_int(target.x));
-    json_object_object_add(target_obj, "y", json_object_new_int(target.y));
+    json_object_object_add(target_obj, "x", json_object_new_int(tour->stops[0].coord.x));
+    json_object_object_add(target_obj, "y", json_object_new_int(tour->stops[0].coord.y));
     json_object_object_add(mission, "target", target_obj);
+
+    // Add the ordered stop list
+    struct json_object *waypoints = json_object_new_array();
+    for (int i = 0; i < tour->count; i++) {
+        struct json_object *wp = json_object_new_object();
+        json_object_object_add(wp, "mission_id", json_object_new_string(tour->stops[i].mission_id));
+        json_object_object_add(wp, "x", json_object_new_int(tour->stops[i].coord.x));
+        json_object_object_add(wp, "y", json_object_new_int(tour->stops[i].coord.y));
+        json_object_array_add(waypoints, wp);
+    }
+    json_object_object_add(mission, "waypoints", waypoints);
     
     // Add expiry and checksum
-    json_object_object_add(mission, "expiry", json_object_new_int64(time(NULL) + 3600));
+    json_object_object_add(mission, "expiry", json_object_new_int64(sim_time() + 3600));
     json_object_object_add(mission, "checksum", json_object_new_string("a1b2c3"));
     
     // Send mission to drone
+    uint64_t send_start = trace_start();
     send_json(drone->sock, mission);
-    printf("Assigned mission %s to drone %d: target=(%d,%d)\n", 
-           mission_id, drone->id, target.x, target.y);
+    trace_span("send_json", tour->stops[0].id, send_start);
+    printf("Assigned mission %s to drone %d: %d stop(s), first target=(%d,%d)\n", 
+           tour->stops[0].mission_id, drone->id, tour->count,
+           tour->stops[0].coord.x, tour->stops[0].coord.y);
     
     json_object_put(mission);
-    pthread_mutex_unlock(&drone->lock);
+    lock_release(&drone->lock);
+    trace_span("assign_tour", tour->stops[0].id, span);
+}
+
+// Seconds a drone needs to fly `cells` cells at its cruise speed
+double estimate_eta(const Drone *drone, int cells) {
+    int speed = drone->max_speed > 0 ? drone->max_speed : METERS_PER_CELL;
+    return (double)cells * METERS_PER_CELL / speed;
+}
+
+int remaining_energy(const Drone *drone) {
+    return drone->battery * drone->battery_capacity / 100;
+}
+
+// Cells the drone flies for this tour: out to the first stop, through the
+// stops in their current order, and on to the nearest charging station
+// (back to where it started if the map has none).
+static int mission_cells(const Drone *drone, const Tour *tour) {
+    Coord last = tour->stops[tour->count - 1].coord;
+    int station = nearest_station(last, 0);
+    Coord home = station >= 0 ? map.stations[station].coord : drone->coord;
+    return travel_distance(drone->coord, tour->stops[0].coord)
+         + tour_length(tour->stops[0].coord, tour)
+         + travel_distance(last, home);
+}
+
+// Right aid on board and enough battery for the round trip. Caller holds
+// drone->lock.
+int can_serve(const Drone *drone, const Tour *tour) {
+    if (drone->payload[0] && tour->payload[0] &&
+        strcmp(drone->payload, tour->payload) != 0) {
+        return 0;
+    }
+    return remaining_energy(drone) >=
+           mission_cells(drone, tour) * ENERGY_PER_CELL + BATTERY_RESERVE;
 }
 
-Drone *find_closest_idle_drone(Coord target) {
+// Idle drone with the earliest arrival at the tour's first stop, among
+// those that can carry the aid and make the round trip. The drone comes
+// back already claimed (ON_MISSION), so nobody else can hand it out before
+// the caller's assign_tour; NULL if the pick was taken meanwhile.
+Drone *find_closest_idle_drone(const Tour *tour) {
     Drone *closest = NULL;
-    int min_distance = INT_MAX;
+    double min_eta = 0;
+    Coord target = tour->stops[0].coord;
     
-    pthread_mutex_lock(&drones->lock);
+    lock_acquire(&drones->lock);
     Node *node = drones->head;
     while (node != NULL) {
         Drone *d = (Drone *)node->data;
-        pthread_mutex_lock(&d->lock);
-        if (d->status == IDLE) {
-            int dist = abs(d->coord.x - target.x) + abs(d->coord.y - target.y);
-            if (dist < min_distance) {
-                min_distance = dist;
+        lock_acquire(&d->lock);
+        if (d->status == IDLE && can_serve(d, tour)) {
+            double eta = estimate_eta(d, travel_distance(d->coord, target));
+            if (!closest || eta < min_eta) {
+                min_eta = eta;
                 closest = d;
             }
         }
-        pthread_mutex_unlock(&d->lock);
+        lock_release(&d->lock);
         node = node->next;
     }
-    pthread_mutex_unlock(&drones->lock);
+    lock_release(&drones->lock);
+
+    // Claim the pick, unless reoptimize_missions or a charger got it first
+    if (closest) {
+        Drone *pick = closest;
+        lock_acquire(&pick->lock);
+        if (pick->status == IDLE && can_serve(pick, tour)) {
+            pick->status = ON_MISSION;
+        } else {
+            closest = NULL;
+        }
+        lock_release(&pick->lock);
+    }
     
     if (closest) {
-        printf("Found closest idle drone at (%d,%d) for target (%d,%d)\n",
-               closest->coord.x, closest->coord.y, target.x, target.y);
+        printf("Found idle drone at (%d,%d) for target (%d,%d), ETA %.1fs\n",
+               closest->coord.x, closest->coord.y, target.x, target.y, min_eta);
     } else {
-        printf("No idle drones available for target (%d,%d)\n",
-               target.x, target.y);
+        printf("No capable idle drone available for target (%d,%d) needing '%s'\n",
+               target.x, target.y, tour->payload);
     }
     
     return closest;
 }
 
-void *ai_controller(void *arg) {
-    while (running) {
-        // First, get a survivor that needs help
-        Survivor *survivor_to_help = NULL;
-        Coord survivor_coord;
-        char survivor_info[25];
-        
-        pthread_mutex_lock(&survivors->lock);
-        Node *node = survivors->head;
-        if (node) {
-            Survivor *s = (Survivor *)node->data;
-            pthread_mutex_lock(&s->lock);
-            if (s->status == WAITING) {
-                survivor_to_help = s;
-                survivor_coord = s->coord;
-                strncpy(survivor_info, s->info, sizeof(survivor_info));
-                s->status = ASSIGNED;
+// Called when a drone turns idle. Only in-flight missions are checked, and
+// each only by the distance to its next stop: the rest of the tour is the
+// same whichever drone flies it. At most one mission is moved per call, so a
+// freed drone never sets off a chain of reassignments.
+void reoptimize_missions(Drone *idle_drone) {
+    lock_acquire(&idle_drone->lock);
+    if (idle_drone->status != IDLE) {
+        lock_release(&idle_drone->lock);
+        return;
+    }
+    Drone idle_copy = *idle_drone;
+    lock_release(&idle_drone->lock);
+    Coord idle_pos = idle_copy.coord;
+
+    Drone *victim = NULL;
+    int best_saving = REASSIGN_THRESHOLD;
+
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        if (d != idle_drone) {
+            lock_acquire(&d->lock);
+            if (d->status == ON_MISSION && d->pending_stops > 0) {
+                Tour rest = { .count = 0 };
+                memcpy(rest.payload, d->tour.payload, sizeof(rest.payload));
+                for (int i = d->tour.count - d->pending_stops; i < d->tour.count; i++) {
+                    rest.stops[rest.count++] = d->tour.stops[i];
+                }
+                Coord next = rest.stops[0].coord;
+                int saving = travel_distance(d->coord, next) - travel_distance(idle_pos, next);
+                if (saving > best_saving && can_serve(&idle_copy, &rest)) {
+                    best_saving = saving;
+                    victim = d;
+                }
             }
-            pthread_mutex_unlock(&s->lock);
+            lock_release(&d->lock);
         }
-        pthread_mutex_unlock(&survivors->lock);
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+
+    if (!victim) return;
+
+    // Claim the idle drone first so the AI controller can't hand it out
+    lock_acquire(&idle_drone->lock);
+    if (idle_drone->status != IDLE) {
+        lock_release(&idle_drone->lock);
+        return;
+    }
+    idle_drone->status = ON_MISSION;
+    lock_release(&idle_drone->lock);
+
+    Tour remaining = { .count = 0 };
+    lock_acquire(&victim->lock);
+    if (victim->status == ON_MISSION && victim->pending_stops > 0) {
+        memcpy(remaining.payload, victim->tour.payload, sizeof(remaining.payload));
+        int first = victim->tour.count - victim->pending_stops;
+        for (int i = first; i < victim->tour.count; i++) {
+            remaining.stops[remaining.count++] = victim->tour.stops[i];
+        }
+
+        struct json_object *cancel = json_object_new_object();
+        json_object_object_add(cancel, "type", json_object_new_string("MISSION_CANCEL"));
+        json_object_object_add(cancel, "mission_id", json_object_new_string(remaining.stops[0].mission_id));
+        // Every withdrawn stop, so the drone drops them all even if it has
+        // moved past the first one by the time this arrives
+        struct json_object *ids = json_object_new_array();
+        for (int i = 0; i < remaining.count; i++) {
+            json_object_array_add(ids, json_object_new_string(remaining.stops[i].mission_id));
+        }
+        json_object_object_add(cancel, "mission_ids", ids);
+        json_object_object_add(cancel, "reason", json_object_new_string("reassigned"));
+        json_object_object_add(cancel, "timestamp", json_object_new_int64(sim_time()));
+        send_json(victim->sock, cancel);
+        json_object_put(cancel);
+
+        counter_add(metrics.missions_reassigned, 1);
+        for (int i = 0; i < remaining.count; i++) {
+            trace_stage_end(STAGE_FLYING, remaining.stops[i].id);
+            trace_stage_begin(STAGE_WAITING, remaining.stops[i].id);
+        }
+        victim->status = IDLE;
+        victim->pending_stops = 0;
+        victim->target = victim->coord;
+        printf("Cancelled mission %s on drone %d: drone %d is %d cells closer\n",
+               remaining.stops[0].mission_id, victim->id, idle_drone->id, best_saving);
+    }
+    lock_release(&victim->lock);
+
+    if (remaining.count == 0) {
+        // Victim finished or was reassigned meanwhile, release the claim
+        lock_acquire(&idle_drone->lock);
+        idle_drone->status = IDLE;
+        lock_release(&idle_drone->lock);
+        return;
+    }
+
+    plan_tour(idle_pos, &remaining);
+    assign_tour(idle_drone, &remaining);
+}
+
+// Try waiting survivors in list order until one gets a drone. A survivor
+// nobody can serve right now (wrong aid, too far for any battery) must not
+// hold up the ones behind it.
+void ai_dispatch_pass() {
+    uint64_t pass_start = monotonic_ns();
+    uint64_t span = trace_start();
+    int collected = 0;
+    uint64_t assigned = 0;
+    for (int attempt = 0; attempt < MAX_DISPATCH_ATTEMPTS; attempt++) {
+        // Reserve a waiting survivor and its close neighbours
+        Tour tour;
+        if (collect_tour(&tour, attempt) == 0) break;
+        collected = 1;
+        Coord anchor = tour.stops[0].coord;
+
+        // Then, find and claim the idle drone that gets there first
+        Drone *closest_drone = find_closest_idle_drone(&tour);
         
-        if (survivor_to_help) {
-            // Then, find the closest idle drone
-            Drone *closest_drone = find_closest_idle_drone(survivor_coord);
-            
-            // If we found a drone, assign the mission
-            if (closest_drone) {
-                assign_mission(closest_drone, survivor_coord, survivor_info);
-                printf("Assigned drone to survivor at (%d, %d)\n", 
-                       survivor_coord.x, survivor_coord.y);
-            } else {
-                // If no drone available, set survivor back to waiting
-                pthread_mutex_lock(&survivor_to_help->lock);
-                survivor_to_help->status = WAITING;
-                pthread_mutex_unlock(&survivor_to_help->lock);
-            }
+        // If we found a drone, order the stops from its position and assign
+        if (closest_drone) {
+            lock_acquire(&closest_drone->lock);
+            Coord start = closest_drone->coord;
+            lock_release(&closest_drone->lock);
+
+            plan_tour(start, &tour);
+            assign_tour(closest_drone, &tour);
+            assigned = tour.stops[0].id;
+            printf("Assigned drone to %d survivor(s) near (%d, %d)\n", 
+                   tour.count, anchor.x, anchor.y);
+            break;
         }
+
+        // If no drone available, set survivors back to waiting
+        release_tour(&tour);
+    }
+    metrics_observe(metrics.dispatch_pass, monotonic_ns() - pass_start);
+    // Idle passes would only push real work out of the ring
+    if (collected) trace_span("ai_dispatch_pass", assigned, span);
+}
+
+void *ai_controller(void *arg) {
+    trace_thread_name("ai_controller");
+    while (running) {
+        ai_dispatch_pass();
         
         // Sleep to prevent excessive CPU usage
-        usleep(100000); // 100ms
+        usleep(AI_PASS_INTERVAL_MS * 1000);
     }
     return NULL;
-}
\ No newline at end of file
+}
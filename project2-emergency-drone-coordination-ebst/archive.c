@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "headers/archive.h"
+#include "headers/simclock.h"
+
+// File layout (host byte order):
+//   "DRNARC01"
+//   block*: magic, rows, min/max helped_ms, byte size of each column,
+//           then each column's encoded values back to back
+// Columns are delta + zigzag + varint encoded: mission IDs and timestamps
+// grow slowly, so most values take one or two bytes instead of eight.
+// A block is written with a single fwrite, and a torn block at the end
+// of the file is cut off when the archive is reopened.
+#define FILE_MAGIC "DRNARC01"
+#define FILE_MAGIC_LEN 8
+#define BLOCK_MAGIC 0x314B4C42u   // "BLK1"
+#define BLOCK_HEADER_SIZE (4 + 4 + 8 + 8 + 4 * ARCHIVE_COLUMNS)
+#define MAX_VARINT 10
+
+typedef struct blockheader {
+    uint32_t rows;
+    int64_t min_helped_ms;
+    int64_t max_helped_ms;
+    uint32_t column_bytes[ARCHIVE_COLUMNS];
+} BlockHeader;
+
+static struct {
+    pthread_mutex_t lock;
+    FILE *file;
+    int rows;
+    time_t first_row;          // sim_time() when the oldest buffered row arrived
+    int64_t columns[ARCHIVE_COLUMNS][ARCHIVE_BLOCK_ROWS];
+    unsigned char *scratch;    // Encoded block, BLOCK_HEADER_SIZE + worst case
+    pthread_t flusher;
+    int flusher_running;
+} writer = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static size_t put_varint(unsigned char *out, int64_t delta) {
+    uint64_t v = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);  // zigzag
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (unsigned char)v;
+    return n;
+}
+
+// Returns bytes read, 0 on a malformed value
+static size_t get_varint(const unsigned char *in, size_t avail, int64_t *delta) {
+    uint64_t v = 0;
+    for (size_t n = 0; n < avail && n < MAX_VARINT; n++) {
+        v |= (uint64_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            *delta = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+static void write_header(unsigned char *out, const BlockHeader *h) {
+    uint32_t magic = BLOCK_MAGIC;
+    memcpy(out, &magic, 4);
+    memcpy(out + 4, &h->rows, 4);
+    memcpy(out + 8, &h->min_helped_ms, 8);
+    memcpy(out + 16, &h->max_helped_ms, 8);
+    memcpy(out + 24, h->column_bytes, 4 * ARCHIVE_COLUMNS);
+}
+
+static int read_header(const unsigned char *in, size_t avail, BlockHeader *h) {
+    uint32_t magic;
+    if (avail < BLOCK_HEADER_SIZE) return 1;
+    memcpy(&magic, in, 4);
+    if (magic != BLOCK_MAGIC) return 1;
+    memcpy(&h->rows, in + 4, 4);
+    memcpy(&h->min_helped_ms, in + 8, 8);
+    memcpy(&h->max_helped_ms, in + 16, 8);
+    memcpy(h->column_bytes, in + 24, 4 * ARCHIVE_COLUMNS);
+    if (h->rows == 0 || h->rows > ARCHIVE_BLOCK_ROWS) return 1;
+    size_t total = BLOCK_HEADER_SIZE;
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) total += h->column_bytes[c];
+    return total > avail;
+}
+
+// Size of the valid prefix of a mapped archive: file header plus every
+// complete block
+static size_t valid_length(const unsigned char *data, size_t size) {
+    if (size < FILE_MAGIC_LEN || memcmp(data, FILE_MAGIC, FILE_MAGIC_LEN) != 0) return 0;
+    size_t offset = FILE_MAGIC_LEN;
+    BlockHeader h;
+    while (read_header(data + offset, size - offset, &h) == 0) {
+        offset += BLOCK_HEADER_SIZE;
+        for (int c = 0; c < ARCHIVE_COLUMNS; c++) offset += h.column_bytes[c];
+    }
+    return offset;
+}
+
+// Caller holds writer.lock
+static int write_block() {
+    if (writer.rows == 0 || !writer.file) return 0;
+
+    BlockHeader h = { .rows = (uint32_t)writer.rows };
+    h.min_helped_ms = h.max_helped_ms = writer.columns[COL_HELPED_MS][0];
+    for (int i = 1; i < writer.rows; i++) {
+        int64_t t = writer.columns[COL_HELPED_MS][i];
+        if (t < h.min_helped_ms) h.min_helped_ms = t;
+        if (t > h.max_helped_ms) h.max_helped_ms = t;
+    }
+
+    size_t offset = BLOCK_HEADER_SIZE;
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        size_t start = offset;
+        int64_t prev = 0;
+        for (int i = 0; i < writer.rows; i++) {
+            offset += put_varint(writer.scratch + offset, writer.columns[c][i] - prev);
+            prev = writer.columns[c][i];
+        }
+        h.column_bytes[c] = (uint32_t)(offset - start);
+    }
+    write_header(writer.scratch, &h);
+
+    if (fwrite(writer.scratch, 1, offset, writer.file) != offset || fflush(writer.file) != 0) {
+        // Drop the block rather than grow the buffer without bound
+        perror("Failed to write archive block");
+        writer.rows = 0;
+        return 1;
+    }
+    printf("Archived %d helped survivors in %zu bytes (%.1f bytes/row)\n",
+           writer.rows, offset, (double)offset / writer.rows);
+    writer.rows = 0;
+    return 0;
+}
+
+static int block_is_stale() {
+    return writer.rows > 0 && sim_time() - writer.first_row >= ARCHIVE_FLUSH_INTERVAL;
+}
+
+// Writes out a partly filled block once it has waited ARCHIVE_FLUSH_INTERVAL,
+// so a quiet incident still reaches the disk. Under virtual time a check
+// from here would cut blocks at points set by the wall clock, and blocks
+// are delta encoded, so archive_append() does it at the next row instead.
+static void *flusher_thread(void *arg) {
+    (void)arg;
+    while (__atomic_load_n(&writer.flusher_running, __ATOMIC_RELAXED)) {
+        sleep(1);
+        if (sim_is_virtual()) continue;
+        pthread_mutex_lock(&writer.lock);
+        if (block_is_stale()) write_block();
+        pthread_mutex_unlock(&writer.lock);
+    }
+    return NULL;
+}
+
+// Opens (or creates) the archive for appending. A block torn by a crash is
+// truncated away first so new blocks stay readable.
+int archive_open(const char *path) {
+    ArchiveReader existing;
+    size_t keep = 0;
+    int fresh = 1;
+    if (archive_reader_open(path, &existing) == 0) {
+        keep = valid_length(existing.data, existing.size);
+        fresh = keep == 0;
+        if (keep < existing.size) {
+            printf("Archive %s: dropping %zu bytes of incomplete data\n", path, existing.size - keep);
+        }
+        archive_reader_close(&existing);
+    }
+
+    FILE *file = fopen(path, fresh ? "w" : "r+");
+    if (!file) {
+        perror("Failed to open archive");
+        return 1;
+    }
+    if (fresh) {
+        fwrite(FILE_MAGIC, 1, FILE_MAGIC_LEN, file);
+        fflush(file);
+    } else if (ftruncate(fileno(file), (off_t)keep) != 0 || fseek(file, 0, SEEK_END) != 0) {
+        perror("Failed to prepare archive for appending");
+        fclose(file);
+        return 1;
+    }
+
+    unsigned char *scratch = malloc(BLOCK_HEADER_SIZE + (size_t)ARCHIVE_COLUMNS * ARCHIVE_BLOCK_ROWS * MAX_VARINT);
+    if (!scratch) {
+        printf("Failed to allocate archive buffer\n");
+        fclose(file);
+        return 1;
+    }
+
+    pthread_mutex_lock(&writer.lock);
+    writer.file = file;
+    writer.scratch = scratch;
+    writer.rows = 0;
+    writer.flusher_running = 1;
+    pthread_mutex_unlock(&writer.lock);
+    if (pthread_create(&writer.flusher, NULL, flusher_thread, NULL) != 0) {
+        printf("Failed to start archive flusher\n");
+        writer.flusher_running = 0;
+    }
+    printf("Archiving helped survivors to %s\n", path);
+    return 0;
+}
+
+int archive_append(const ArchiveRecord *record) {
+    int result = 0;
+    pthread_mutex_lock(&writer.lock);
+    if (!writer.file) {
+        pthread_mutex_unlock(&writer.lock);
+        return 1;
+    }
+    if (block_is_stale()) result = write_block();
+    if (writer.rows == 0) writer.first_row = sim_time();
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        writer.columns[c][writer.rows] = record->values[c];
+    }
+    if (++writer.rows == ARCHIVE_BLOCK_ROWS) {
+        result = write_block();
+    }
+    pthread_mutex_unlock(&writer.lock);
+    return result;
+}
+
+int archive_flush() {
+    pthread_mutex_lock(&writer.lock);
+    int result = write_block();
+    pthread_mutex_unlock(&writer.lock);
+    return result;
+}
+
+// Rows waiting for the next block write
+int archive_buffered_rows() {
+    pthread_mutex_lock(&writer.lock);
+    int rows = writer.rows;
+    pthread_mutex_unlock(&writer.lock);
+    return rows;
+}
+
+void archive_close() {
+    if (__atomic_exchange_n(&writer.flusher_running, 0, __ATOMIC_RELAXED)) {
+        pthread_join(writer.flusher, NULL);
+    }
+    pthread_mutex_lock(&writer.lock);
+    write_block();
+    if (writer.file) {
+        fclose(writer.file);
+        writer.file = NULL;
+    }
+    free(writer.scratch);
+    writer.scratch = NULL;
+    pthread_mutex_unlock(&writer.lock);
+}
+
+int archive_reader_open(const char *path, ArchiveReader *reader) {
+    memset(reader, 0, sizeof(ArchiveReader));
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) return 1;
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(reader->fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    }
+    if (data == MAP_FAILED) {
+        close(reader->fd);
+        reader->fd = -1;
+        return 1;
+    }
+    reader->data = data;
+    reader->size = (size_t)st.st_size;
+    return 0;
+}
+
+void archive_reader_close(ArchiveReader *reader) {
+    if (reader->data) munmap((void *)reader->data, reader->size);
+    if (reader->fd >= 0) close(reader->fd);
+    reader->data = NULL;
+    reader->fd = -1;
+}
+
+// Visits every archived row whose helped time is in [from_ms, to_ms],
+// decoding only the columns in `columns`. Blocks entirely outside the time
+// range are skipped by their header alone. Returns rows visited, -1 on error.
+long archive_scan(const ArchiveReader *reader, unsigned columns,
+                  int64_t from_ms, int64_t to_ms, ArchiveVisitor visit, void *ctx) {
+    const unsigned char *data = reader->data;
+    size_t size = valid_length(data, reader->size);
+    if (size == 0) return -1;
+
+    int filtered = from_ms > INT64_MIN || to_ms < INT64_MAX;
+    if (filtered) columns |= COLUMN_BIT(COL_HELPED_MS);
+
+    int64_t *decoded = malloc(sizeof(int64_t) * ARCHIVE_COLUMNS * ARCHIVE_BLOCK_ROWS);
+    if (!decoded) return -1;
+
+    long visited = 0;
+    size_t offset = FILE_MAGIC_LEN;
+    BlockHeader h;
+    while (offset < size && read_header(data + offset, size - offset, &h) == 0) {
+        const unsigned char *column = data + offset + BLOCK_HEADER_SIZE;
+        offset += BLOCK_HEADER_SIZE;
+        for (int c = 0; c < ARCHIVE_COLUMNS; c++) offset += h.column_bytes[c];
+        if (h.max_helped_ms < from_ms || h.min_helped_ms > to_ms) continue;
+
+        for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+            if (columns & COLUMN_BIT(c)) {
+                int64_t *out = decoded + (size_t)c * ARCHIVE_BLOCK_ROWS;
+                int64_t value = 0;
+                size_t pos = 0;
+                for (uint32_t i = 0; i < h.rows; i++) {
+                    int64_t delta;
+                    size_t n = get_varint(column + pos, h.column_bytes[c] - pos, &delta);
+                    if (n == 0) {
+                        free(decoded);
+                        return -1;
+                    }
+                    pos += n;
+                    value += delta;
+                    out[i] = value;
+                }
+            }
+            column += h.column_bytes[c];
+        }
+
+        ArchiveRecord record;
+        memset(&record, 0, sizeof(record));
+        for (uint32_t i = 0; i < h.rows; i++) {
+            for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+                if (columns & COLUMN_BIT(c)) record.values[c] = decoded[(size_t)c * ARCHIVE_BLOCK_ROWS + i];
+            }
+            if (filtered && (record.values[COL_HELPED_MS] < from_ms || record.values[COL_HELPED_MS] > to_ms)) {
+                continue;
+            }
+            visit(&record, ctx);
+            visited++;
+        }
+    }
+    free(decoded);
+    return visited;
+}
@@ -0,0 +1,78 @@
+// After-action report over the helped-survivor archive: response times and
+// missions per drone. Only the drone id and timestamp columns are decoded.
+//
+// Usage: ./archive_query [archive] [from_epoch_s to_epoch_s]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "headers/archive.h"
+
+#define MAX_REPORTED_DRONES 1024
+
+typedef struct report {
+    long rows;
+    double total_ms;
+    int64_t max_ms;
+    long per_drone[MAX_REPORTED_DRONES];
+    double per_drone_ms[MAX_REPORTED_DRONES];
+    long other_drones;
+} Report;
+
+static void visit(const ArchiveRecord *record, void *ctx) {
+    Report *r = (Report *)ctx;
+    int64_t response = record->values[COL_HELPED_MS] - record->values[COL_DISCOVERED_MS];
+    int64_t drone = record->values[COL_DRONE_ID];
+    r->rows++;
+    r->total_ms += response;
+    if (response > r->max_ms) r->max_ms = response;
+    if (drone >= 0 && drone < MAX_REPORTED_DRONES) {
+        r->per_drone[drone]++;
+        r->per_drone_ms[drone] += response;
+    } else {
+        r->other_drones++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : ARCHIVE_PATH;
+    int64_t from_ms = INT64_MIN, to_ms = INT64_MAX;
+    if (argc > 3) {
+        from_ms = atoll(argv[2]) * 1000;
+        to_ms = atoll(argv[3]) * 1000;
+    }
+
+    ArchiveReader reader;
+    if (archive_reader_open(path, &reader) != 0) {
+        printf("Cannot open archive %s\n", path);
+        return 1;
+    }
+
+    Report *report = calloc(1, sizeof(Report));
+    if (!report) {
+        archive_reader_close(&reader);
+        return 1;
+    }
+    unsigned columns = COLUMN_BIT(COL_DRONE_ID) | COLUMN_BIT(COL_DISCOVERED_MS) | COLUMN_BIT(COL_HELPED_MS);
+    long rows = archive_scan(&reader, columns, from_ms, to_ms, visit, report);
+    archive_reader_close(&reader);
+    if (rows < 0) {
+        printf("Archive %s is corrupt or empty\n", path);
+        free(report);
+        return 1;
+    }
+
+    printf("Helped survivors: %ld\n", report->rows);
+    if (report->rows > 0) {
+        printf("Response time: mean %.1fs, max %.1fs\n",
+               report->total_ms / report->rows / 1000.0, report->max_ms / 1000.0);
+        printf("%-8s %10s %12s\n", "drone", "missions", "mean (s)");
+        for (int d = 0; d < MAX_REPORTED_DRONES; d++) {
+            if (report->per_drone[d] == 0) continue;
+            printf("D%-7d %10ld %12.1f\n", d, report->per_drone[d],
+                   report->per_drone_ms[d] / report->per_drone[d] / 1000.0);
+        }
+        if (report->other_drones > 0) printf("(%ld from other drone ids)\n", report->other_drones);
+    }
+    free(report);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <json-c/json.h>
+#include "headers/bench.h"
+
+void bench_add(BenchReport *report, const char *name, int param, double value,
+               const char *unit, int higher_is_better) {
+    if (report->count == BENCH_MAX_RESULTS) {
+        printf("Too many benchmark results, %s dropped\n", name);
+        return;
+    }
+    BenchResult *r = &report->results[report->count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->param = param;
+    r->value = value;
+    r->unit = unit;
+    r->higher_is_better = higher_is_better;
+}
+
+// Results file, one per suite and run:
+// {"suite":"micro","timestamp":1700000000,"host":"build-1","cpus":8,
+//  "results":[{"name":"list_add_remove","param":4,"value":2.1e6,
+//              "unit":"ops/s","better":"higher"}, ...]}
+int bench_write(const BenchReport *report, const char *path) {
+    char host[64] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+
+    struct json_object *root = json_object_new_object();
+    json_object_object_add(root, "suite", json_object_new_string(report->suite));
+    json_object_object_add(root, "timestamp", json_object_new_int64(time(NULL)));
+    json_object_object_add(root, "host", json_object_new_string(host));
+    json_object_object_add(root, "cpus", json_object_new_int((int)sysconf(_SC_NPROCESSORS_ONLN)));
+    struct json_object *results = json_object_new_array();
+    for (int i = 0; i < report->count; i++) {
+        const BenchResult *r = &report->results[i];
+        struct json_object *row = json_object_new_object();
+        json_object_object_add(row, "name", json_object_new_string(r->name));
+        json_object_object_add(row, "param", json_object_new_int(r->param));
+        json_object_object_add(row, "value", json_object_new_double(r->value));
+        json_object_object_add(row, "unit", json_object_new_string(r->unit));
+        json_object_object_add(row, "better", json_object_new_string(r->higher_is_better ? "higher" : "lower"));
+        json_object_array_add(results, row);
+    }
+    json_object_object_add(root, "results", results);
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror("Failed to open benchmark results file");
+        json_object_put(root);
+        return 1;
+    }
+    fprintf(out, "%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+    fclose(out);
+    json_object_put(root);
+    printf("Benchmark results written to %s\n", path);
+    return 0;
+}
+
+static struct json_object *load_results(const char *path) {
+    struct json_object *root = json_object_from_file(path);
+    struct json_object *results;
+    if (!root || !json_object_object_get_ex(root, "results", &results) ||
+        !json_object_is_type(results, json_type_array)) {
+        printf("Failed to read benchmark results from %s\n", path);
+        json_object_put(root);
+        return NULL;
+    }
+    return root;
+}
+
+static const char *field_string(struct json_object *row, const char *key) {
+    struct json_object *field;
+    return json_object_object_get_ex(row, key, &field) ? json_object_get_string(field) : "";
+}
+
+static double field_double(struct json_object *row, const char *key) {
+    struct json_object *field;
+    return json_object_object_get_ex(row, key, &field) ? json_object_get_double(field) : 0;
+}
+
+// Prints every result of `new_path` next to the same name and param in
+// `base_path`. Returns 1 if any got worse by more than threshold_pct, so a
+// release script can fail on it.
+int bench_compare(const char *base_path, const char *new_path, double threshold_pct) {
+    struct json_object *base = load_results(base_path);
+    struct json_object *cur = load_results(new_path);
+    if (!base || !cur) {
+        json_object_put(base);
+        json_object_put(cur);
+        return 1;
+    }
+    struct json_object *base_rows = json_object_object_get(base, "results");
+    struct json_object *cur_rows = json_object_object_get(cur, "results");
+
+    int regressions = 0;
+    printf("%-28s %7s %14s %14s %9s\n", "benchmark", "param", "base", "new", "change");
+    for (size_t i = 0; i < json_object_array_length(cur_rows); i++) {
+        struct json_object *row = json_object_array_get_idx(cur_rows, i);
+        const char *name = field_string(row, "name");
+        int param = (int)field_double(row, "param");
+        double value = field_double(row, "value");
+
+        struct json_object *match = NULL;
+        for (size_t j = 0; j < json_object_array_length(base_rows) && !match; j++) {
+            struct json_object *b = json_object_array_get_idx(base_rows, j);
+            if (strcmp(field_string(b, "name"), name) == 0 && (int)field_double(b, "param") == param) {
+                match = b;
+            }
+        }
+        if (!match) {
+            printf("%-28s %7d %14s %14.2f %9s\n", name, param, "-", value, "new");
+            continue;
+        }
+
+        double old = field_double(match, "value");
+        double change = old != 0 ? (value - old) * 100 / old : 0;
+        int higher_is_better = strcmp(field_string(row, "better"), "lower") != 0;
+        int worse = higher_is_better ? change < -threshold_pct : change > threshold_pct;
+        if (worse) regressions++;
+        printf("%-28s %7d %14.2f %14.2f %+8.1f%%%s\n", name, param, old, value, change,
+               worse ? "  REGRESSION" : "");
+    }
+    printf("%d regression(s) beyond %.1f%%\n", regressions, threshold_pct);
+
+    json_object_put(base);
+    json_object_put(cur);
+    return regressions > 0;
+}
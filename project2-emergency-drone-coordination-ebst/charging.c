@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/charging.h"
+#include "headers/communication.h"
+#include "headers/tour.h"
+#include "headers/globals.h"
+#include "headers/simclock.h"
+
+// Protects the occupied count of every station
+static pthread_mutex_t station_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// One station at the centre of each quadrant of the map
+void init_charging_stations() {
+    map.num_stations = NUM_CHARGING_STATIONS;
+    map.stations = malloc(sizeof(ChargingStation) * map.num_stations);
+    if (!map.stations) {
+        perror("Failed to allocate charging stations");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < map.num_stations; i++) {
+        map.stations[i].coord.x = (i % 2 == 0) ? map.width / 4 : 3 * map.width / 4;
+        map.stations[i].coord.y = (i < 2) ? map.height / 4 : 3 * map.height / 4;
+        map.stations[i].slots = STATION_SLOTS;
+        map.stations[i].occupied = 0;
+        printf("Charging station %d at (%d,%d) with %d slots\n", i,
+               map.stations[i].coord.x, map.stations[i].coord.y, STATION_SLOTS);
+    }
+}
+
+// Caller holds station_lock
+static int find_station(Coord from, int need_free_slot) {
+    int best = -1;
+    int best_dist = 0;
+    for (int i = 0; i < map.num_stations; i++) {
+        if (need_free_slot && map.stations[i].occupied >= map.stations[i].slots) continue;
+        int dist = travel_distance(from, map.stations[i].coord);
+        if (best < 0 || dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+int nearest_station(Coord from, int need_free_slot) {
+    pthread_mutex_lock(&station_lock);
+    int best = find_station(from, need_free_slot);
+    pthread_mutex_unlock(&station_lock);
+    return best;
+}
+
+// Nearest station with a free slot, reserved for the caller
+int reserve_station(Coord from) {
+    pthread_mutex_lock(&station_lock);
+    int best = find_station(from, 1);
+    if (best >= 0) map.stations[best].occupied++;
+    pthread_mutex_unlock(&station_lock);
+    return best;
+}
+
+void release_station(int index) {
+    if (index < 0 || index >= map.num_stations) return;
+    pthread_mutex_lock(&station_lock);
+    if (map.stations[index].occupied > 0) map.stations[index].occupied--;
+    pthread_mutex_unlock(&station_lock);
+}
+
+void assign_recharge(Drone *drone, int station) {
+    lock_acquire(&drone->lock);
+    if (drone->status != IDLE) {
+        // Dispatched since the scheduler looked at it
+        lock_release(&drone->lock);
+        release_station(station);
+        return;
+    }
+    Coord target = map.stations[station].coord;
+    drone->status = CHARGING;
+    drone->station = station;
+    drone->target = target;
+
+    char mission_id[25];
+    snprintf(mission_id, sizeof(mission_id), "CHARGE-%d", drone->id);
+
+    struct json_object *mission = json_object_new_object();
+    json_object_object_add(mission, "type", json_object_new_string("ASSIGN_MISSION"));
+    json_object_object_add(mission, "mission_id", json_object_new_string(mission_id));
+    json_object_object_add(mission, "priority", json_object_new_string("medium"));
+    json_object_object_add(mission, "charge", json_object_new_boolean(1));
+
+    struct json_object *target_obj = json_object_new_object();
+    json_object_object_add(target_obj, "x", json_object_new_int(target.x));
+    json_object_object_add(target_obj, "y", json_object_new_int(target.y));
+    json_object_object_add(mission, "target", target_obj);
+    json_object_object_add(mission, "expiry", json_object_new_int64(sim_time() + 3600));
+
+    send_json(drone->sock, mission);
+    printf("Sending drone %d (battery %d%%) to charging station %d at (%d,%d)\n",
+           drone->id, drone->battery, station, target.x, target.y);
+
+    json_object_put(mission);
+    lock_release(&drone->lock);
+}
+
+// Sends at most one drone to charge per pass, lowest battery first, and
+// keeps the charging share of the fleet under 1/MAX_CHARGING_SHARE so
+// recharge windows are staggered instead of grounding everyone at once.
+// Drones below CRITICAL_BATTERY go regardless of the share.
+void charging_pass() {
+    Drone *candidate = NULL;
+    int lowest = LOW_BATTERY + 1;
+    Coord position = {0, 0};
+    int active = 0, charging = 0;
+
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        lock_acquire(&d->lock);
+        if (d->status != DISCONNECTED) active++;
+        if (d->status == CHARGING) charging++;
+        if (d->status == IDLE && d->battery < lowest) {
+            lowest = d->battery;
+            candidate = d;
+            position = d->coord;
+        }
+        lock_release(&d->lock);
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+
+    if (!candidate) return;
+
+    int max_charging = active / MAX_CHARGING_SHARE;
+    if (max_charging < 1) max_charging = 1;
+    if (charging >= max_charging && lowest > CRITICAL_BATTERY) {
+        printf("Deferring recharge of drone %d (battery %d%%): %d/%d drones charging\n",
+               candidate->id, lowest, charging, max_charging);
+        return;
+    }
+
+    int station = reserve_station(position);
+    if (station < 0) {
+        printf("No free charging slot for drone %d (battery %d%%)\n", candidate->id, lowest);
+        return;
+    }
+    assign_recharge(candidate, station);
+}
+
+void *charging_scheduler(void *arg) {
+    (void)arg;
+    while (running) {
+        sleep(CHARGE_CHECK_INTERVAL);
+        charging_pass();
+    }
+    return NULL;
+}
@@ -8,11 +8,23 @@
 
 #define BUFFER_SIZE 4096
 
+static LocalDelivery local_delivery = NULL;
+
+// Sockets below -1 stand for drones living in this process (see
+// simulate.c); messages to them go to fn instead of the network
+void set_local_delivery(LocalDelivery fn) {
+    local_delivery = fn;
+}
+
 void send_json(int sock, struct json_object *jobj) {
     if (!jobj) {
         printf("Error: NULL json object passed to send_json\n");
         return;
     }
+    if (sock < -1 && local_delivery) {
+        local_delivery(sock, jobj);
+        return;
+    }
 
     // Check if socket is valid
     int error = 0;
@@ -59,10 +71,36 @@ void send_json(int sock, struct json_object *jobj) {
     free(msg);
 }
 
-struct json_object *receive_json(int sock) {
-    static char buffer[BUFFER_SIZE] = {0};
-    static size_t buf_pos = 0;
+// Whether a MISSION_CANCEL takes the stop `mission_id` away from the
+// drone: it is listed in "mission_ids", or, from a server that names only
+// one stop, it is that "mission_id"
+int cancel_withdraws(struct json_object *cancel, const char *mission_id) {
+    struct json_object *ids, *id;
+    if (json_object_object_get_ex(cancel, "mission_ids", &ids)) {
+        for (size_t i = 0; i < json_object_array_length(ids); i++) {
+            const char *listed = json_object_get_string(json_object_array_get_idx(ids, i));
+            if (listed && strcmp(listed, mission_id) == 0) return 1;
+        }
+        return 0;
+    }
+    return json_object_object_get_ex(cancel, "mission_id", &id) &&
+           json_object_get_string(id) && strcmp(json_object_get_string(id), mission_id) == 0;
+}
+
+// The buffer is per thread: the server runs one handler thread per drone,
+// and a shared buffer would splice bytes from different sockets together
+static __thread char buffer[BUFFER_SIZE] = {0};
+static __thread size_t buf_pos = 0;
 
+// Forget whatever this thread has buffered. A thread that moves to a new
+// socket must call it, or the rest of a line from the old one is glued
+// onto the first message of the new one.
+void receive_json_reset() {
+    buf_pos = 0;
+    buffer[0] = '\0';
+}
+
+struct json_object *receive_json(int sock) {
     while (1) {
         char *newline = strchr(buffer, '\n');
         if (newline) {
@@ -73,7 +111,8 @@ struct json_object *receive_json(int sock) {
                 printf("Failed to parse JSON: %s\n", buffer);
             }
             size_t len = newline - buffer + 1;
-            memmove(buffer, newline + 1, buf_pos - len);
+            // Keep the terminator, so strchr can't find an old newline
+            memmove(buffer, newline + 1, buf_pos - len + 1);
             buf_pos -= len;
             return jobj;
         }
@@ -4,6 +4,7 @@
 #include "headers/survivor.h"
 #include "headers/ai.h"
 #include "headers/view.h"
+#include "headers/stream.h"
 #include <stdio.h>
 
 int main() {
@@ -22,8 +23,9 @@ int main() {
     SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
 
     init_map(40, 30);
-    survivors = create_list(sizeof(Survivor), 1000);
-    helpedsurvivors = create_list(sizeof(Survivor), 1000);
+    init_survivor_pool();
+    survivors = create_ref_list(1000);
+    helpedsurvivors = create_ref_list(1000);
     drones = create_list(sizeof(Drone), 100);
 
     pthread_t survivor_thread;
@@ -32,13 +34,18 @@ int main() {
     pthread_t ai_thread;
     pthread_create(&ai_thread, NULL, ai_controller, NULL);
 
+    // Captures the world for draw_map
+    pthread_t stream_thread;
+    pthread_create(&stream_thread, NULL, stream_publisher, NULL);
+
     // Initialize SDL window in the main thread
-    if (init_sdl_window() != 0) {
+    if (init_sdl_window(map.width, map.height) != 0) {
         printf("Failed to initialize SDL window\n");
         freemap();
         survivors->destroy(survivors);
         helpedsurvivors->destroy(helpedsurvivors);
         drones->destroy(drones);
+        destroy_survivor_pool();
         SDL_Quit();
         return 1;
     }
@@ -76,6 +83,7 @@ int main() {
     survivors->destroy(survivors);
     helpedsurvivors->destroy(helpedsurvivors);
     drones->destroy(drones);
+    destroy_survivor_pool();
     cleanup_sdl();
     return 0;
 }
\ No newline at end of file
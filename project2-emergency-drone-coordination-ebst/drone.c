@@ -27,7 +27,7 @@ void initialize_drones() {
 void *drone_behavior(void *arg) {
     Drone *d = (Drone*)arg;
     while (1) {
-        pthread_mutex_lock(&d->lock);
+        lock_acquire(&d->lock);
         if (d->status == ON_MISSION) {
             if (d->coord.x < d->target.x) d->coord.x++;
             else if (d->coord.x > d->target.x) d->coord.x--;
@@ -38,7 +38,7 @@ void *drone_behavior(void *arg) {
                 printf("Drone %d: Mission completed!\n", d->id);
             }
         }
-        pthread_mutex_unlock(&d->lock);
+        lock_release(&d->lock);
         sleep(1);
     }
     return NULL;
@@ -47,7 +47,7 @@ void *drone_behavior(void *arg) {
 void cleanup_drones() {
     for (int i = 0; i < num_drones; i++) {
         pthread_cancel(drone_fleet[i].thread_id);
-        pthread_mutex_destroy(&drone_fleet[i].lock);
+        lock_destroy(&drone_fleet[i].lock);
     }
     free(drone_fleet);
 }
\ No newline at end of file
@@ -8,31 +8,174 @@
 #include <errno.h>
 #include <json-c/json.h>
 #include <time.h>
+#include <signal.h>
 #include "headers/drone.h"
+#include "headers/communication.h"
 #include "headers/coord.h"
+#include "headers/tour.h"
+#include "headers/charging.h"
+#include "headers/ai.h"
 
 #define SERVER_IP "127.0.0.1"
 #define PORT 8080
-#define BUFFER_SIZE 4096
+#define MAX_SPEED 30              // m/s, advertised in HANDSHAKE
+#define MOTION_TICK_MS 50         // How often the motion thread integrates position
+#define DEFAULT_STATUS_INTERVAL 5 // Seconds, if HANDSHAKE_ACK has no config
+#define RECONNECT_BASE_MS 500     // First reconnect delay, doubled per failure
+#define RECONNECT_MAX_MS 30000
+#define RECONNECT_MAX_ATTEMPTS 20 // Consecutive failures before giving up
+#define MAX_UNSENT_REPORTS 32
 
-void send_json(int sock, struct json_object *jobj);
-struct json_object *receive_json(int sock);
 void navigate_to_target(Drone *drone);
 
-int main() {
-    srand(time(NULL));
-    Drone drone = {
-        .id = rand() % 1000,
-        .status = IDLE,
-        .coord = {rand() % 40, rand() % 30},
-        .target = {0, 0}
-    };
-    pthread_mutex_init(&drone.lock, NULL);
+// Stops of the current mission, visited in the order the server planned
+static TourStop waypoints[MAX_TOUR_STOPS];
+static int num_waypoints = 0;
+static int current_waypoint = 0;
+static int repositioning = 0; // Low-priority move while still reporting idle
+
+// Battery simulation: ENERGY_PER_CELL per cell flown, CHARGE_RATE per second docked
+#define BATTERY_CAPACITY 100
+static double energy = BATTERY_CAPACITY;
+static enum { NOT_CHARGING, TO_STATION, DOCKED } charge_state = NOT_CHARGING;
+
+// The receive, motion and telemetry threads share the drone (under
+// drone.lock) and the socket (writes under send_lock, so messages from
+// different threads never interleave)
+static Drone drone;
+static char drone_id[10];
+static int max_speed = MAX_SPEED;
+static int status_interval = DEFAULT_STATUS_INTERVAL;
+static const char *payload;
+static volatile int running = 1;
+static volatile int connected = 0;
+static char session_token[17];  // From HANDSHAKE_ACK, "" until the first one
+// Stops reached but not yet reported: queued under drone.lock, sent by
+// flush_reports without it, and kept while the link is down
+static char unsent_reports[MAX_UNSENT_REPORTS][sizeof(((TourStop *)0)->mission_id)];
+static int num_unsent = 0;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;  // One flusher at a time
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stop_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t stop_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int battery_percent() {
+    return (int)(energy * 100 / BATTERY_CAPACITY);
+}
+
+static const char *status_string(const Drone *drone) {
+    if (charge_state == DOCKED) return "charging";
+    return drone->status == IDLE ? "idle" : "busy";
+}
+
+static int is_moving(const Drone *drone) {
+    return (drone->status == ON_MISSION && charge_state != DOCKED) || repositioning;
+}
+
+// Fails while the link is down
+static int send_message(struct json_object *jobj) {
+    pthread_mutex_lock(&send_lock);
+    int ok = connected;
+    if (ok) send_json(drone.sock, jobj);
+    pthread_mutex_unlock(&send_lock);
+    return ok ? 0 : 1;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sleep up to `seconds`, waking early when the client shuts down. Returns 0
+// once running is cleared.
+static int wait_while_running(double seconds) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long long ns = deadline.tv_nsec + (long long)(seconds * 1e9);
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec = ns % 1000000000;
+    pthread_mutex_lock(&stop_lock);
+    while (running) {
+        if (pthread_cond_timedwait(&stop_cond, &stop_lock, &deadline) == ETIMEDOUT) break;
+    }
+    int still_running = running;
+    pthread_mutex_unlock(&stop_lock);
+    return still_running;
+}
+
+static void stop_client() {
+    pthread_mutex_lock(&stop_lock);
+    running = 0;
+    pthread_cond_broadcast(&stop_cond);
+    pthread_mutex_unlock(&stop_lock);
+}
 
+static void handle_assign_mission(struct json_object *msg) {
+    struct json_object *target = json_object_object_get(msg, "target");
+    const char *mission_id = json_object_get_string(json_object_object_get(msg, "mission_id"));
+    struct json_object *wps = json_object_object_get(msg, "waypoints");
+    struct json_object *reposition = json_object_object_get(msg, "reposition");
+    struct json_object *charge = json_object_object_get(msg, "charge");
+    lock_acquire(&drone.lock);
+    if (charge && json_object_get_boolean(charge)) {
+        drone.target.x = json_object_get_int(json_object_object_get(target, "x"));
+        drone.target.y = json_object_get_int(json_object_object_get(target, "y"));
+        drone.status = ON_MISSION;
+        charge_state = TO_STATION;
+        repositioning = 0;
+        num_waypoints = 0;
+        printf("Received recharge order: station at (%d, %d), battery %d%%\n",
+               drone.target.x, drone.target.y, battery_percent());
+        lock_release(&drone.lock);
+        return;
+    }
+    if (reposition && json_object_get_boolean(reposition)) {
+        // Only move if not busy; a real mission always wins
+        if (drone.status == IDLE) {
+            drone.target.x = json_object_get_int(json_object_object_get(target, "x"));
+            drone.target.y = json_object_get_int(json_object_object_get(target, "y"));
+            repositioning = 1;
+            printf("Received reposition order: target=(%d, %d)\n",
+                   drone.target.x, drone.target.y);
+        }
+        lock_release(&drone.lock);
+        return;
+    }
+    repositioning = 0;
+    num_waypoints = 0;
+    current_waypoint = 0;
+    if (wps) {
+        size_t n = json_object_array_length(wps);
+        for (size_t i = 0; i < n && num_waypoints < MAX_TOUR_STOPS; i++) {
+            struct json_object *wp = json_object_array_get_idx(wps, i);
+            TourStop *stop = &waypoints[num_waypoints++];
+            stop->coord.x = json_object_get_int(json_object_object_get(wp, "x"));
+            stop->coord.y = json_object_get_int(json_object_object_get(wp, "y"));
+            snprintf(stop->mission_id, sizeof(stop->mission_id), "%s",
+                     json_object_get_string(json_object_object_get(wp, "mission_id")));
+        }
+    }
+    if (num_waypoints == 0) {
+        // Single-target mission from a server without waypoint support
+        waypoints[0].coord.x = json_object_get_int(json_object_object_get(target, "x"));
+        waypoints[0].coord.y = json_object_get_int(json_object_object_get(target, "y"));
+        snprintf(waypoints[0].mission_id, sizeof(waypoints[0].mission_id), "%s",
+                 mission_id ? mission_id : "");
+        num_waypoints = 1;
+    }
+    drone.target = waypoints[0].coord;
+    drone.status = ON_MISSION;
+    printf("Received ASSIGN_MISSION: mission_id=%s, %d stop(s), target=(%d, %d)\n",
+           mission_id, num_waypoints, drone.target.x, drone.target.y);
+    lock_release(&drone.lock);
+}
+
+static int open_connection() {
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
         perror("Socket creation failed");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     struct sockaddr_in server_addr = {
@@ -44,196 +187,352 @@ int main() {
     if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("Connection failed");
         close(sock);
-        exit(EXIT_FAILURE);
+        return -1;
     }
-
-    drone.sock = sock;
     printf("Connected to server at %s:%d\n", SERVER_IP, PORT);
+    return sock;
+}
 
-    char drone_id[10];
-    snprintf(drone_id, sizeof(drone_id), "D%d", drone.id);
+// The server no longer holds our mission (the session expired while we
+// were away) and has handed the survivors to other drones
+static void drop_mission() {
+    lock_acquire(&drone.lock);
+    num_waypoints = 0;
+    current_waypoint = 0;
+    repositioning = 0;
+    if (charge_state == TO_STATION) charge_state = NOT_CHARGING;
+    if (charge_state != DOCKED) drone.status = IDLE;
+    drone.target = drone.coord;
+    lock_release(&drone.lock);
+}
+
+// Register with the server, or resume our session if we have one
+static int handshake(int sock) {
     struct json_object *handshake = json_object_new_object();
     json_object_object_add(handshake, "type", json_object_new_string("HANDSHAKE"));
     json_object_object_add(handshake, "drone_id", json_object_new_string(drone_id));
+    if (session_token[0]) {
+        json_object_object_add(handshake, "session_token", json_object_new_string(session_token));
+    }
     struct json_object *capabilities = json_object_new_object();
-    json_object_object_add(capabilities, "max_speed", json_object_new_int(30));
-    json_object_object_add(capabilities, "battery_capacity", json_object_new_int(100));
-    json_object_object_add(capabilities, "payload", json_object_new_string("medical"));
+    json_object_object_add(capabilities, "max_speed", json_object_new_int(max_speed));
+    json_object_object_add(capabilities, "battery_capacity", json_object_new_int(BATTERY_CAPACITY));
+    json_object_object_add(capabilities, "payload", json_object_new_string(payload));
     json_object_object_add(handshake, "capabilities", capabilities);
     send_json(sock, handshake);
-    printf("Sent HANDSHAKE: drone_id=%s\n", drone_id);
+    printf("Sent HANDSHAKE: drone_id=%s%s\n", drone_id, session_token[0] ? " (resuming)" : "");
     json_object_put(handshake);
 
     struct json_object *ack = receive_json(sock);
-    if (!ack || strcmp(json_object_get_string(json_object_object_get(ack, "type")), "HANDSHAKE_ACK") != 0) {
+    const char *ack_type = ack ? json_object_get_string(json_object_object_get(ack, "type")) : NULL;
+    if (!ack_type || strcmp(ack_type, "HANDSHAKE_ACK") != 0) {
         fprintf(stderr, "Handshake failed\n");
         if (ack) json_object_put(ack);
-        close(sock);
-        exit(EXIT_FAILURE);
+        return 1;
+    }
+    struct json_object *config, *field;
+    if (json_object_object_get_ex(ack, "config", &config) &&
+        json_object_object_get_ex(config, "status_update_interval", &field) &&
+        json_object_get_int(field) > 0) {
+        status_interval = json_object_get_int(field);
     }
-    printf("Received HANDSHAKE_ACK\n");
+    int resumed = json_object_object_get_ex(ack, "resumed", &field) && json_object_get_boolean(field);
+    if (session_token[0] && !resumed) drop_mission();
+    if (json_object_object_get_ex(ack, "session_token", &field)) {
+        snprintf(session_token, sizeof(session_token), "%s", json_object_get_string(field));
+    }
+    printf("Received HANDSHAKE_ACK: %s, status every %ds, cruising at %d m/s\n",
+           resumed ? "session resumed" : "new session", status_interval, max_speed);
     json_object_put(ack);
+    return 0;
+}
 
-    while (1) {
-        pthread_mutex_lock(&drone.lock);
-        struct json_object *status = json_object_new_object();
-        json_object_object_add(status, "type", json_object_new_string("STATUS_UPDATE"));
-        json_object_object_add(status, "drone_id", json_object_new_string(drone_id));
-        json_object_object_add(status, "timestamp", json_object_new_int64(time(NULL)));
-        struct json_object *loc = json_object_new_object();
-        json_object_object_add(loc, "x", json_object_new_int(drone.coord.x));
-        json_object_object_add(loc, "y", json_object_new_int(drone.coord.y));
-        json_object_object_add(status, "location", loc);
-        json_object_object_add(status, "status", json_object_new_string(drone.status == IDLE ? "idle" : "busy"));
-        json_object_object_add(status, "battery", json_object_new_int(85));
-        json_object_object_add(status, "speed", json_object_new_int(5));
-        send_json(sock, status);
-        printf("Sent STATUS_UPDATE: x=%d, y=%d, status=%s\n",
-               drone.coord.x, drone.coord.y, drone.status == IDLE ? "idle" : "busy");
-        json_object_put(status);
+static int send_mission_complete(const char *mission_id) {
+    struct json_object *complete = json_object_new_object();
+    json_object_object_add(complete, "type", json_object_new_string("MISSION_COMPLETE"));
+    json_object_object_add(complete, "drone_id", json_object_new_string(drone_id));
+    json_object_object_add(complete, "mission_id", json_object_new_string(mission_id));
+    json_object_object_add(complete, "timestamp", json_object_new_int64(time(NULL)));
+    json_object_object_add(complete, "success", json_object_new_boolean(1));
+    json_object_object_add(complete, "details", json_object_new_string("Delivered aid to survivor"));
+    int failed = send_message(complete);
+    json_object_put(complete);
+    if (!failed) printf("Sent MISSION_COMPLETE: mission_id=%s\n", mission_id);
+    return failed;
+}
+
+// Caller holds drone.lock
+static void queue_report(const char *mission_id) {
+    if (num_unsent == MAX_UNSENT_REPORTS) {
+        printf("Report queue full, dropping mission %s\n", mission_id);
+        return;
+    }
+    snprintf(unsent_reports[num_unsent++], sizeof(unsent_reports[0]), "%s", mission_id);
+}
 
-        if (drone.status == ON_MISSION) {
-            navigate_to_target(&drone);
+// Sends the queued reports without holding drone.lock, so a stalled socket
+// holds up only the flushing thread. Reports that can't be sent go back to
+// the front of the queue, ahead of stops reached meanwhile. If another
+// thread is flushing, it picks up whatever is queued on its next call.
+static void flush_reports() {
+    if (pthread_mutex_trylock(&flush_lock) != 0) return;
+    char batch[MAX_UNSENT_REPORTS][sizeof(unsent_reports[0])];
+    lock_acquire(&drone.lock);
+    int n = num_unsent;
+    memcpy(batch, unsent_reports, n * sizeof(batch[0]));
+    num_unsent = 0;
+    lock_release(&drone.lock);
+
+    int sent = 0;
+    while (sent < n && send_mission_complete(batch[sent]) == 0) sent++;
+    if (sent < n) {
+        lock_acquire(&drone.lock);
+        int keep = n - sent;
+        int later = num_unsent + keep > MAX_UNSENT_REPORTS ? MAX_UNSENT_REPORTS - keep : num_unsent;
+        memmove(unsent_reports[keep], unsent_reports[0], later * sizeof(unsent_reports[0]));
+        memcpy(unsent_reports[0], batch[sent], keep * sizeof(batch[0]));
+        num_unsent = keep + later;
+        lock_release(&drone.lock);
+        printf("Link down, %d report(s) wait for the reconnect\n", keep);
+    }
+    pthread_mutex_unlock(&flush_lock);
+}
+
+// Connect and handshake, retrying with exponential backoff and jitter so a
+// fleet that lost the server at once doesn't reconnect in lockstep
+static int connect_with_backoff() {
+    int delay_ms = RECONNECT_BASE_MS;
+    for (int attempt = 1; running && attempt <= RECONNECT_MAX_ATTEMPTS; attempt++) {
+        receive_json_reset();  // Nothing buffered from an earlier socket belongs to this one
+        int sock = open_connection();
+        if (sock >= 0 && handshake(sock) == 0) {
+            lock_acquire(&drone.lock);
+            pthread_mutex_lock(&send_lock);
+            drone.sock = sock;
+            connected = 1;
+            pthread_mutex_unlock(&send_lock);
+            lock_release(&drone.lock);
+            // Stops finished while the link was down
+            flush_reports();
+            return 0;
         }
-        pthread_mutex_unlock(&drone.lock);
+        if (sock >= 0) close(sock);
 
-        struct json_object *msg = receive_json(sock);
+        int wait_ms = delay_ms / 2 + rand() % (delay_ms / 2 + 1);
+        printf("Reconnecting in %d ms (attempt %d/%d)\n", wait_ms, attempt, RECONNECT_MAX_ATTEMPTS);
+        if (!wait_while_running(wait_ms / 1000.0)) break;
+        delay_ms = delay_ms * 2 > RECONNECT_MAX_MS ? RECONNECT_MAX_MS : delay_ms * 2;
+    }
+    fprintf(stderr, "Could not reach the server, giving up\n");
+    return 1;
+}
+
+// Handles server messages as soon as they arrive; nothing else waits on
+// it. A dropped link is re-established here while the drone flies on.
+static void *receive_thread(void *arg) {
+    (void)arg;
+    while (running) {
+        struct json_object *msg = receive_json(drone.sock);
         if (!msg) {
             fprintf(stderr, "Server disconnected\n");
-            break;
+            pthread_mutex_lock(&send_lock);
+            connected = 0;
+            close(drone.sock);
+            drone.sock = -1;
+            pthread_mutex_unlock(&send_lock);
+            if (connect_with_backoff() != 0) break;
+            continue;
         }
 
         const char *type = json_object_get_string(json_object_object_get(msg, "type"));
         printf("Received message: type=%s\n", type ? type : "NULL");
-        if (strcmp(type, "ASSIGN_MISSION") == 0) {
-            struct json_object *target = json_object_object_get(msg, "target");
-            const char *mission_id = json_object_get_string(json_object_object_get(msg, "mission_id"));
-            pthread_mutex_lock(&drone.lock);
-            drone.target.x = json_object_get_int(json_object_object_get(target, "x"));
-            drone.target.y = json_object_get_int(json_object_object_get(target, "y"));
-            drone.status = ON_MISSION;
-            printf("Received ASSIGN_MISSION: mission_id=%s, target=(%d, %d)\n",
-                   mission_id, drone.target.x, drone.target.y);
-            pthread_mutex_unlock(&drone.lock);
+        if (!type) {
+            // Malformed; skip it
+        } else if (strcmp(type, "ASSIGN_MISSION") == 0) {
+            handle_assign_mission(msg);
+        } else if (strcmp(type, "MISSION_CANCEL") == 0) {
+            lock_acquire(&drone.lock);
+            // Drop the withdrawn stops still ahead of us; ones already
+            // completed are reported (or queued) and are the server's to sort out
+            int kept = current_waypoint;
+            for (int i = current_waypoint; drone.status == ON_MISSION && i < num_waypoints; i++) {
+                if (!cancel_withdraws(msg, waypoints[i].mission_id)) waypoints[kept++] = waypoints[i];
+            }
+            if (drone.status == ON_MISSION && kept < num_waypoints) {
+                printf("Received MISSION_CANCEL: %d stop(s) withdrawn\n", num_waypoints - kept);
+                num_waypoints = kept;
+                if (current_waypoint < num_waypoints) {
+                    drone.target = waypoints[current_waypoint].coord;
+                } else {
+                    num_waypoints = 0;
+                    current_waypoint = 0;
+                    drone.status = IDLE;
+                    drone.target = drone.coord;
+                    printf("No stops left, now idle\n");
+                }
+            }
+            lock_release(&drone.lock);
         } else if (strcmp(type, "HEARTBEAT") == 0) {
             struct json_object *response = json_object_new_object();
             json_object_object_add(response, "type", json_object_new_string("HEARTBEAT_RESPONSE"));
             json_object_object_add(response, "drone_id", json_object_new_string(drone_id));
             json_object_object_add(response, "timestamp", json_object_new_int64(time(NULL)));
-            send_json(sock, response);
+            send_message(response);
             printf("Sent HEARTBEAT_RESPONSE\n");
             json_object_put(response);
         } else if (strcmp(type, "ERROR") == 0) {
             fprintf(stderr, "Error from server: %s\n",
                     json_object_get_string(json_object_object_get(msg, "message")));
         }
-
         json_object_put(msg);
-        sleep(1);
     }
-
-    close(sock);
-    pthread_mutex_destroy(&drone.lock);
-    return 0;
+    stop_client();
+    return NULL;
 }
 
-void send_json(int sock, struct json_object *jobj) {
-    if (!jobj) {
-        printf("Error: NULL json object passed to send_json\n");
-        return;
-    }
-
-    const char *json_str = json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_PLAIN);
-    if (!json_str) {
-        printf("Error: Failed to convert json object to string\n");
-        return;
-    }
+// Integrates position over real time: at max_speed m/s the drone crosses
+// max_speed / METERS_PER_CELL cells per second. Partial progress carries
+// over between ticks, so slow drones still move, just less often.
+static void *motion_thread(void *arg) {
+    (void)arg;
+    double cells_per_second = (double)max_speed / METERS_PER_CELL;
+    double progress = 0;
+    double last = now_seconds();
+    while (wait_while_running(MOTION_TICK_MS / 1000.0)) {
+        double now = now_seconds();
+        double dt = now - last;
+        last = now;
 
-    size_t len = strlen(json_str);
-    char *msg = malloc(len + 2);
-    if (!msg) {
-        printf("Error: Failed to allocate memory for message\n");
-        return;
-    }
-    
-    snprintf(msg, len + 2, "%s\n", json_str);
-    printf("Attempting to send message: %s", msg);
-    
-    ssize_t total_sent = 0;
-    size_t remaining = strlen(msg);
-    
-    while (total_sent < remaining) {
-        ssize_t sent = send(sock, msg + total_sent, remaining - total_sent, 0);
-        if (sent < 0) {
-            printf("Error sending message: %s (errno: %d)\n", strerror(errno), errno);
-            free(msg);
-            return;
+        lock_acquire(&drone.lock);
+        if (charge_state == DOCKED) {
+            energy += CHARGE_RATE * dt;
+            if (energy >= BATTERY_CAPACITY) {
+                energy = BATTERY_CAPACITY;
+                charge_state = NOT_CHARGING;
+                drone.status = IDLE;
+                printf("Battery full, leaving charging station\n");
+            }
         }
-        total_sent += sent;
+        if (is_moving(&drone)) {
+            progress += dt * cells_per_second;
+            while (progress >= 1 && is_moving(&drone)) {
+                navigate_to_target(&drone);
+                progress -= 1;
+            }
+        }
+        if (!is_moving(&drone)) progress = 0;  // Next flight starts from a standstill
+        int reports = num_unsent;
+        lock_release(&drone.lock);
+        // While the link is down the reconnect flushes them instead
+        if (reports > 0 && connected) flush_reports();
     }
-    
-    printf("Successfully sent %zd bytes\n", total_sent);
-    free(msg);
+    return NULL;
+}
+
+// Reports position at the interval the server asked for in HANDSHAKE_ACK
+static void *telemetry_thread(void *arg) {
+    (void)arg;
+    do {
+        lock_acquire(&drone.lock);
+        struct json_object *status = json_object_new_object();
+        json_object_object_add(status, "type", json_object_new_string("STATUS_UPDATE"));
+        json_object_object_add(status, "drone_id", json_object_new_string(drone_id));
+        json_object_object_add(status, "timestamp", json_object_new_int64(time(NULL)));
+        struct json_object *loc = json_object_new_object();
+        json_object_object_add(loc, "x", json_object_new_int(drone.coord.x));
+        json_object_object_add(loc, "y", json_object_new_int(drone.coord.y));
+        json_object_object_add(status, "location", loc);
+        json_object_object_add(status, "status", json_object_new_string(status_string(&drone)));
+        json_object_object_add(status, "battery", json_object_new_int(battery_percent()));
+        json_object_object_add(status, "speed", json_object_new_int(is_moving(&drone) ? max_speed : 0));
+        printf("Sent STATUS_UPDATE: x=%d, y=%d, status=%s, battery=%d%%\n",
+               drone.coord.x, drone.coord.y, status_string(&drone), battery_percent());
+        lock_release(&drone.lock);
+        send_message(status);
+        json_object_put(status);
+    } while (wait_while_running(status_interval));
+    return NULL;
 }
 
-struct json_object *receive_json(int sock) {
-    static char buffer[BUFFER_SIZE] = {0};
-    static size_t buf_pos = 0;
+int main(int argc, char *argv[]) {
+    srand(time(NULL));
+    // Payload can be given on the command line; otherwise pick one so that
+    // a handful of clients makes a mixed fleet. An optional second argument
+    // sets the cruise speed in m/s.
+    static const char *payload_types[] = {"medical", "food", "water"};
+    payload = argc > 1 ? argv[1] : payload_types[rand() % 3];
+    if (argc > 2 && atoi(argv[2]) > 0) max_speed = atoi(argv[2]);
+    drone.id = rand() % 1000;
+    drone.status = IDLE;
+    drone.coord.x = rand() % 40;
+    drone.coord.y = rand() % 30;
+    drone.sock = -1;
+    lock_init(&drone.lock, "drone", 0);
+    snprintf(drone_id, sizeof(drone_id), "D%d", drone.id);
 
-    while (1) {
-        char *newline = strchr(buffer, '\n');
-        if (newline) {
-            *newline = '\0';
-            printf("Received complete message: %s\n", buffer);
-            struct json_object *jobj = json_tokener_parse(buffer);
-            if (!jobj) {
-                printf("Failed to parse JSON: %s\n", buffer);
-            }
-            size_t len = newline - buffer + 1;
-            memmove(buffer, newline + 1, buf_pos - len);
-            buf_pos -= len;
-            return jobj;
-        }
+    // A write to a dropped link must fail, not kill the drone
+    signal(SIGPIPE, SIG_IGN);
 
-        int bytes = recv(sock, buffer + buf_pos, BUFFER_SIZE - buf_pos - 1, 0);
-        if (bytes <= 0) {
-            if (bytes < 0) {
-                printf("Error receiving data: %s (errno: %d)\n", strerror(errno), errno);
-            }
-            if (buf_pos > 0) {
-                buffer[buf_pos] = '\0';
-                printf("Received partial message: %s\n", buffer);
-                struct json_object *jobj = json_tokener_parse(buffer);
-                buf_pos = 0;
-                return jobj;
-            }
-            return NULL;
-        }
-        buf_pos += bytes;
-        buffer[buf_pos] = '\0';
-        printf("Received %d bytes: %s\n", bytes, buffer + buf_pos - bytes);
+    if (connect_with_backoff() != 0) {
+        exit(EXIT_FAILURE);
     }
+
+    pthread_t receiver, motion, telemetry;
+    pthread_create(&receiver, NULL, receive_thread, NULL);
+    pthread_create(&motion, NULL, motion_thread, NULL);
+    pthread_create(&telemetry, NULL, telemetry_thread, NULL);
+
+    // The receiver stops the client once the server can't be reached
+    pthread_join(receiver, NULL);
+    pthread_join(motion, NULL);
+    pthread_join(telemetry, NULL);
+
+    if (drone.sock >= 0) close(drone.sock);
+    lock_destroy(&drone.lock);
+    return 0;
 }
 
 void navigate_to_target(Drone *drone) {
+    if (drone->coord.x != drone->target.x || drone->coord.y != drone->target.y) {
+        energy -= ENERGY_PER_CELL;
+        if (energy < 0) energy = 0;
+    }
     if (drone->coord.x < drone->target.x) drone->coord.x++;
     else if (drone->coord.x > drone->target.x) drone->coord.x--;
     if (drone->coord.y < drone->target.y) drone->coord.y++;
     else if (drone->coord.y > drone->target.y) drone->coord.y--;
 
+    if (charge_state == TO_STATION) {
+        if (drone->coord.x == drone->target.x && drone->coord.y == drone->target.y) {
+            charge_state = DOCKED;
+            printf("Docked at charging station (%d, %d), battery %d%%\n",
+                   drone->target.x, drone->target.y, battery_percent());
+        }
+        return;
+    }
+
+    if (repositioning) {
+        if (drone->coord.x == drone->target.x && drone->coord.y == drone->target.y) {
+            repositioning = 0;
+            printf("Reached reposition target (%d, %d)\n", drone->target.x, drone->target.y);
+        }
+        return;
+    }
+
     if (drone->coord.x == drone->target.x && drone->coord.y == drone->target.y) {
-        drone->status = IDLE;
-        char drone_id[10];
-        snprintf(drone_id, sizeof(drone_id), "D%d", drone->id);
-        struct json_object *complete = json_object_new_object();
-        json_object_object_add(complete, "type", json_object_new_string("MISSION_COMPLETE"));
-        json_object_object_add(complete, "drone_id", json_object_new_string(drone_id));
-        json_object_object_add(complete, "mission_id", json_object_new_string("M123")); // Should match survivor->info
-        json_object_object_add(complete, "timestamp", json_object_new_int64(time(NULL)));
-        json_object_object_add(complete, "success", json_object_new_boolean(1));
-        json_object_object_add(complete, "details", json_object_new_string("Delivered aid to survivor"));
-        send_json(drone->sock, complete);
-        printf("Sent MISSION_COMPLETE: mission_id=M123\n");
-        json_object_put(complete);
+        // Reported by the motion thread once it drops drone.lock
+        const char *mission_id = num_waypoints > 0 ? waypoints[current_waypoint].mission_id : "";
+        queue_report(mission_id);
+        printf("Reached mission %s (stop %d/%d)\n", mission_id, current_waypoint + 1, num_waypoints);
+
+        // Fly on to the next stop of the tour, or go idle after the last one
+        current_waypoint++;
+        if (current_waypoint < num_waypoints) {
+            drone->target = waypoints[current_waypoint].coord;
+        } else {
+            num_waypoints = 0;
+            current_waypoint = 0;
+            drone->status = IDLE;
+        }
     }
 }
\ No newline at end of file
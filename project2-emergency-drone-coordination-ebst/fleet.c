@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "headers/fleet.h"
+#include "headers/drone.h"
+
+#define FRESH 4  // Set in middle until the reader has taken that state
+
+// The fleet the server draws and streams alongside real drones, if any
+Fleet *sim_fleet = NULL;
+
+// splitmix64 of (seed, drone, tick): each drone's next target depends only
+// on these, never on which thread stepped it or in what order
+static uint64_t mix(uint64_t seed, uint64_t drone, uint64_t tick) {
+    uint64_t z = seed + drone * 0x9E3779B97F4A7C15ULL + tick * 0xD1B54A32D192ED03ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int alloc_state(FleetState *state, int count) {
+    memset(state, 0, sizeof(*state));
+    state->x = malloc(count * sizeof(int32_t));
+    state->y = malloc(count * sizeof(int32_t));
+    state->target_x = malloc(count * sizeof(int32_t));
+    state->target_y = malloc(count * sizeof(int32_t));
+    state->status = malloc(count);
+    return !state->x || !state->y || !state->target_x || !state->target_y || !state->status;
+}
+
+static void free_state(FleetState *state) {
+    free(state->x);
+    free(state->y);
+    free(state->target_x);
+    free(state->target_y);
+    free(state->status);
+    memset(state, 0, sizeof(*state));
+}
+
+// Advance drones [begin, end) from prev into next. The moving path has no
+// branches, so the common case stays a straight run over the arrays.
+static unsigned long step_range(const Fleet *f, const FleetState *prev, FleetState *next,
+                                int begin, int end) {
+    unsigned long completed = 0;
+    uint64_t tick = prev->tick;
+    for (int i = begin; i < end; i++) {
+        int32_t x = prev->x[i], y = prev->y[i];
+        int32_t tx = prev->target_x[i], ty = prev->target_y[i];
+        uint8_t status = prev->status[i];
+        if (status == IDLE) {
+            uint64_t r = mix(f->seed, i, tick);
+            tx = (int32_t)((uint32_t)r % f->width);
+            ty = (int32_t)((uint32_t)(r >> 32) % f->height);
+            status = ON_MISSION;
+        } else {
+            x += (tx > x) - (tx < x);
+            y += (ty > y) - (ty < y);
+            int arrived = (x == tx) & (y == ty);
+            completed += arrived;
+            status = arrived ? IDLE : ON_MISSION;
+        }
+        next->x[i] = x;
+        next->y[i] = y;
+        next->target_x[i] = tx;
+        next->target_y[i] = ty;
+        next->status[i] = status;
+    }
+    return completed;
+}
+
+static void run_worker_step(FleetWorker *w) {
+    Fleet *f = w->fleet;
+    w->completed = step_range(f, &f->states[f->last], &f->states[f->back], w->begin, w->end);
+}
+
+// Pool threads wait for each step, run their share and report back
+static void *fleet_worker(void *arg) {
+    FleetWorker *w = (FleetWorker *)arg;
+    Fleet *f = w->fleet;
+    uint64_t seen = 0;
+    while (1) {
+        pthread_mutex_lock(&f->step_lock);
+        while (f->generation == seen && !f->shutting_down) {
+            pthread_cond_wait(&f->step_start, &f->step_lock);
+        }
+        if (f->shutting_down) {
+            pthread_mutex_unlock(&f->step_lock);
+            break;
+        }
+        seen = f->generation;
+        pthread_mutex_unlock(&f->step_lock);
+
+        run_worker_step(w);
+
+        pthread_mutex_lock(&f->step_lock);
+        if (--f->pending == 0) pthread_cond_signal(&f->step_done);
+        pthread_mutex_unlock(&f->step_lock);
+    }
+    return NULL;
+}
+
+// Drones start idle at random cells and take their first target on the
+// first step. With threads > 1 the fleet is split into that many slices,
+// stepped in parallel.
+int fleet_init(Fleet *f, int count, int width, int height, int threads, uint64_t seed) {
+    memset(f, 0, sizeof(*f));
+    if (count <= 0 || width <= 0 || height <= 0) return 1;
+    if (threads < 1) threads = 1;
+    if (threads > FLEET_MAX_THREADS) threads = FLEET_MAX_THREADS;
+    if (threads > count) threads = count;
+    f->count = count;
+    f->width = width;
+    f->height = height;
+    f->seed = seed;
+
+    for (int s = 0; s < 3; s++) {
+        if (alloc_state(&f->states[s], count) != 0) {
+            printf("Failed to allocate fleet of %d drones\n", count);
+            fleet_free(f);
+            return 1;
+        }
+    }
+    FleetState *initial = &f->states[0];
+    for (int i = 0; i < count; i++) {
+        uint64_t r = mix(seed, i, UINT64_MAX);
+        initial->x[i] = initial->target_x[i] = (int32_t)((uint32_t)r % width);
+        initial->y[i] = initial->target_y[i] = (int32_t)((uint32_t)(r >> 32) % height);
+        initial->status[i] = IDLE;
+    }
+    f->last = 0;
+    f->middle = 0 | FRESH;
+    f->back = 1;
+    f->front = 2;
+
+    pthread_mutex_init(&f->step_lock, NULL);
+    pthread_cond_init(&f->step_start, NULL);
+    pthread_cond_init(&f->step_done, NULL);
+    f->num_workers = threads;
+    for (int t = 0; t < threads; t++) {
+        FleetWorker *w = &f->workers[t];
+        w->fleet = f;
+        w->begin = (int)((long long)count * t / threads);
+        w->end = (int)((long long)count * (t + 1) / threads);
+        if (t == 0) continue;
+        if (pthread_create(&w->thread, NULL, fleet_worker, w) != 0) {
+            printf("Failed to create fleet worker thread %d\n", t);
+            f->num_workers = t;
+            fleet_free(f);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void fleet_free(Fleet *f) {
+    if (f->simulating) fleet_stop(f);
+    if (f->num_workers > 0) {
+        pthread_mutex_lock(&f->step_lock);
+        f->shutting_down = 1;
+        pthread_cond_broadcast(&f->step_start);
+        pthread_mutex_unlock(&f->step_lock);
+        for (int t = 1; t < f->num_workers; t++) {
+            pthread_join(f->workers[t].thread, NULL);
+        }
+        pthread_mutex_destroy(&f->step_lock);
+        pthread_cond_destroy(&f->step_start);
+        pthread_cond_destroy(&f->step_done);
+    }
+    for (int s = 0; s < 3; s++) free_state(&f->states[s]);
+    memset(f, 0, sizeof(*f));
+}
+
+// One fixed timestep for every drone, then publish the result. Only one
+// thread may step a fleet.
+void fleet_step(Fleet *f) {
+    f->states[f->back].tick = f->states[f->last].tick + 1;
+    if (f->num_workers > 1) {
+        pthread_mutex_lock(&f->step_lock);
+        f->pending = f->num_workers - 1;
+        f->generation++;
+        pthread_cond_broadcast(&f->step_start);
+        pthread_mutex_unlock(&f->step_lock);
+    }
+    run_worker_step(&f->workers[0]);
+    if (f->num_workers > 1) {
+        pthread_mutex_lock(&f->step_lock);
+        while (f->pending > 0) pthread_cond_wait(&f->step_done, &f->step_lock);
+        pthread_mutex_unlock(&f->step_lock);
+    }
+    for (int t = 0; t < f->num_workers; t++) {
+        f->missions_completed += f->workers[t].completed;
+    }
+
+    // The state just written becomes the next step's input; the one handed
+    // back is neither that nor the reader's, so it is free to overwrite
+    f->last = f->back;
+    f->back = __atomic_exchange_n(&f->middle, f->back | FRESH, __ATOMIC_ACQ_REL) & ~FRESH;
+}
+
+// Newest published state. Stays valid and unchanged until the next call.
+const FleetState *fleet_latest(Fleet *f) {
+    if (__atomic_load_n(&f->middle, __ATOMIC_RELAXED) & FRESH) {
+        f->front = __atomic_exchange_n(&f->middle, f->front, __ATOMIC_ACQ_REL) & ~FRESH;
+        f->have_front = 1;
+    }
+    return f->have_front ? &f->states[f->front] : NULL;
+}
+
+// Steps the fleet every FLEET_TICK_MS of wall time. A step that overruns
+// is followed straight away by the next, which then catches up.
+static void *fleet_simulator(void *arg) {
+    Fleet *f = (Fleet *)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (__atomic_load_n(&f->simulating, __ATOMIC_RELAXED)) {
+        fleet_step(f);
+        next.tv_nsec += FLEET_TICK_MS * 1000000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long wait_us = (next.tv_sec - now.tv_sec) * 1000000L + (next.tv_nsec - now.tv_nsec) / 1000;
+        if (wait_us > 0) usleep(wait_us);
+    }
+    return NULL;
+}
+
+int fleet_start(Fleet *f) {
+    f->simulating = 1;
+    if (pthread_create(&f->simulator, NULL, fleet_simulator, f) != 0) {
+        printf("Failed to create fleet simulator thread\n");
+        f->simulating = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void fleet_stop(Fleet *f) {
+    if (!f->simulating) return;
+    __atomic_store_n(&f->simulating, 0, __ATOMIC_RELAXED);
+    pthread_join(f->simulator, NULL);
+}
@@ -0,0 +1,85 @@
+// Fleet simulator benchmark: steps a synthetic fleet as fast as possible,
+// with no server, network or display, and reports the step rate.
+//
+// Usage: ./fleetsim [-n drones] [-t threads] [-s steps] [-W width] [-H height] [-S seed]
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "headers/fleet.h"
+#include "headers/drone.h"
+
+static struct {
+    int drones;
+    int threads;
+    int steps;
+    int width, height;
+    unsigned long long seed;
+} config = {1000000, 1, 1000, 1000, 1000, 1};
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-n drones] [-t threads] [-s steps] [-W width] [-H height] [-S seed]\n", prog);
+}
+
+static int parse_args(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:s:W:H:S:")) != -1) {
+        switch (opt) {
+        case 'n': config.drones = atoi(optarg); break;
+        case 't': config.threads = atoi(optarg); break;
+        case 's': config.steps = atoi(optarg); break;
+        case 'W': config.width = atoi(optarg); break;
+        case 'H': config.height = atoi(optarg); break;
+        case 'S': config.seed = strtoull(optarg, NULL, 10); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (config.drones < 1 || config.threads < 1 || config.steps < 1 ||
+        config.width < 1 || config.height < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    if (parse_args(argc, argv) != 0) return 1;
+
+    Fleet fleet;
+    if (fleet_init(&fleet, config.drones, config.width, config.height, config.threads, config.seed) != 0) {
+        return 1;
+    }
+    printf("Simulating %d drones on a %dx%d map with %d thread(s) for %d steps\n",
+           fleet.count, config.width, config.height, fleet.num_workers, config.steps);
+
+    double start = now_seconds();
+    for (int s = 0; s < config.steps; s++) {
+        fleet_step(&fleet);
+    }
+    double elapsed = now_seconds() - start;
+
+    // A checksum of the final state, to confirm runs match across thread counts
+    const FleetState *state = fleet_latest(&fleet);
+    unsigned long long checksum = 0;
+    int on_mission = 0;
+    for (int i = 0; i < fleet.count; i++) {
+        checksum = checksum * 31 + (unsigned)state->x[i] * 7919u + (unsigned)state->y[i];
+        on_mission += state->status[i] == ON_MISSION;
+    }
+
+    double drone_steps = (double)fleet.count * config.steps;
+    printf("%.3fs: %.1f steps/s, %.1f M drone-steps/s, %.2f ns per drone-step\n",
+           elapsed, config.steps / elapsed, drone_steps / elapsed / 1e6, elapsed * 1e9 / drone_steps);
+    printf("Tick %llu: %d on mission, %lu missions completed, checksum %016llx\n",
+           (unsigned long long)state->tick, on_mission, fleet.missions_completed, checksum);
+    printf("Real time at %dms per step: %.0fx\n", FLEET_TICK_MS,
+           config.steps * FLEET_TICK_MS / 1000.0 / elapsed);
+    fleet_free(&fleet);
+    return 0;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "headers/frame.h"
+
+void frame_init(Frame *frame) {
+    memset(frame, 0, sizeof(Frame));
+}
+
+void frame_free(Frame *frame) {
+    free(frame->drones);
+    free(frame->survivors);
+    frame_init(frame);
+}
+
+// Grow the arrays to hold at least this many entities; they never shrink,
+// so a frame reused every tick stops allocating once the world stops growing
+int frame_reserve(Frame *frame, int drones, int survivors) {
+    if (drones > frame->drones_capacity) {
+        int capacity = frame->drones_capacity ? frame->drones_capacity : 64;
+        while (capacity < drones) capacity *= 2;
+        FrameDrone *grown = realloc(frame->drones, capacity * sizeof(FrameDrone));
+        if (!grown) return 1;
+        frame->drones = grown;
+        frame->drones_capacity = capacity;
+    }
+    if (survivors > frame->survivors_capacity) {
+        int capacity = frame->survivors_capacity ? frame->survivors_capacity : 64;
+        while (capacity < survivors) capacity *= 2;
+        FrameSurvivor *grown = realloc(frame->survivors, capacity * sizeof(FrameSurvivor));
+        if (!grown) return 1;
+        frame->survivors = grown;
+        frame->survivors_capacity = capacity;
+    }
+    return 0;
+}
+
+static int compare_drones(const void *a, const void *b) {
+    int ka = ((const FrameDrone *)a)->key, kb = ((const FrameDrone *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static int compare_survivors(const void *a, const void *b) {
+    uint64_t ia = ((const FrameSurvivor *)a)->id, ib = ((const FrameSurvivor *)b)->id;
+    return (ia > ib) - (ia < ib);
+}
+
+void frame_sort(Frame *frame) {
+    qsort(frame->drones, frame->num_drones, sizeof(FrameDrone), compare_drones);
+    qsort(frame->survivors, frame->num_survivors, sizeof(FrameSurvivor), compare_survivors);
+}
+
+int frame_copy(Frame *dst, const Frame *src) {
+    if (frame_reserve(dst, src->num_drones, src->num_survivors) != 0) return 1;
+    dst->seq = src->seq;
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->num_stations = src->num_stations;
+    memcpy(dst->stations, src->stations, sizeof(dst->stations));
+    dst->num_drones = src->num_drones;
+    dst->num_survivors = src->num_survivors;
+    if (src->num_drones > 0) memcpy(dst->drones, src->drones, src->num_drones * sizeof(FrameDrone));
+    if (src->num_survivors > 0) memcpy(dst->survivors, src->survivors, src->num_survivors * sizeof(FrameSurvivor));
+    return 0;
+}
+
+// Whether two frames hold the same world, compared byte for byte.
+// Conservative: padding can make equal frames compare unequal, never the
+// other way round.
+int frame_equal(const Frame *a, const Frame *b) {
+    return a->width == b->width && a->height == b->height &&
+           a->num_stations == b->num_stations &&
+           memcmp(a->stations, b->stations, a->num_stations * sizeof(Coord)) == 0 &&
+           a->num_drones == b->num_drones && a->num_survivors == b->num_survivors &&
+           (a->num_drones == 0 || memcmp(a->drones, b->drones, a->num_drones * sizeof(FrameDrone)) == 0) &&
+           (a->num_survivors == 0 ||
+            memcmp(a->survivors, b->survivors, a->num_survivors * sizeof(FrameSurvivor)) == 0);
+}
+
+// Entities travel as arrays rather than objects to keep snapshots small:
+// drones as [key, id, x, y, target_x, target_y, status], survivors as
+// ["mission_id", x, y, status]
+static struct json_object *drone_json(const FrameDrone *d) {
+    struct json_object *row = json_object_new_array();
+    json_object_array_add(row, json_object_new_int(d->key));
+    json_object_array_add(row, json_object_new_int(d->id));
+    json_object_array_add(row, json_object_new_int(d->coord.x));
+    json_object_array_add(row, json_object_new_int(d->coord.y));
+    json_object_array_add(row, json_object_new_int(d->target.x));
+    json_object_array_add(row, json_object_new_int(d->target.y));
+    json_object_array_add(row, json_object_new_int(d->status));
+    return row;
+}
+
+static struct json_object *survivor_id_json(uint64_t id) {
+    char text[21];
+    snprintf(text, sizeof(text), "%" PRIu64, id);
+    return json_object_new_string(text);
+}
+
+static struct json_object *survivor_json(const FrameSurvivor *s) {
+    struct json_object *row = json_object_new_array();
+    json_object_array_add(row, survivor_id_json(s->id));
+    json_object_array_add(row, json_object_new_int(s->coord.x));
+    json_object_array_add(row, json_object_new_int(s->coord.y));
+    json_object_array_add(row, json_object_new_int(s->status));
+    return row;
+}
+
+struct json_object *frame_snapshot_json(const Frame *frame) {
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string("SNAPSHOT"));
+    json_object_object_add(msg, "seq", json_object_new_int64((int64_t)frame->seq));
+    json_object_object_add(msg, "width", json_object_new_int(frame->width));
+    json_object_object_add(msg, "height", json_object_new_int(frame->height));
+    struct json_object *stations = json_object_new_array();
+    for (int i = 0; i < frame->num_stations; i++) {
+        struct json_object *row = json_object_new_array();
+        json_object_array_add(row, json_object_new_int(frame->stations[i].x));
+        json_object_array_add(row, json_object_new_int(frame->stations[i].y));
+        json_object_array_add(stations, row);
+    }
+    json_object_object_add(msg, "stations", stations);
+    struct json_object *drones = json_object_new_array();
+    for (int i = 0; i < frame->num_drones; i++) {
+        json_object_array_add(drones, drone_json(&frame->drones[i]));
+    }
+    json_object_object_add(msg, "drones", drones);
+    struct json_object *survivors = json_object_new_array();
+    for (int i = 0; i < frame->num_survivors; i++) {
+        json_object_array_add(survivors, survivor_json(&frame->survivors[i]));
+    }
+    json_object_object_add(msg, "survivors", survivors);
+    return msg;
+}
+
+// Changes from prev to cur, both sorted: new or changed entities in full,
+// gone ones by key. The caller sets "seq" if *changes is non-zero.
+struct json_object *frame_delta_json(const Frame *prev, const Frame *cur, int *changes) {
+    struct json_object *drones = json_object_new_array();
+    struct json_object *drones_removed = json_object_new_array();
+    struct json_object *survivors = json_object_new_array();
+    struct json_object *survivors_removed = json_object_new_array();
+
+    int i = 0, j = 0;
+    while (i < prev->num_drones || j < cur->num_drones) {
+        const FrameDrone *p = i < prev->num_drones ? &prev->drones[i] : NULL;
+        const FrameDrone *c = j < cur->num_drones ? &cur->drones[j] : NULL;
+        if (p && (!c || p->key < c->key)) {
+            json_object_array_add(drones_removed, json_object_new_int(p->key));
+            i++;
+        } else if (c && (!p || c->key < p->key)) {
+            json_object_array_add(drones, drone_json(c));
+            j++;
+        } else {
+            if (memcmp(p, c, sizeof(FrameDrone)) != 0) json_object_array_add(drones, drone_json(c));
+            i++;
+            j++;
+        }
+    }
+
+    i = 0;
+    j = 0;
+    while (i < prev->num_survivors || j < cur->num_survivors) {
+        const FrameSurvivor *p = i < prev->num_survivors ? &prev->survivors[i] : NULL;
+        const FrameSurvivor *c = j < cur->num_survivors ? &cur->survivors[j] : NULL;
+        if (p && (!c || p->id < c->id)) {
+            json_object_array_add(survivors_removed, survivor_id_json(p->id));
+            i++;
+        } else if (c && (!p || c->id < p->id)) {
+            json_object_array_add(survivors, survivor_json(c));
+            j++;
+        } else {
+            if (p->coord.x != c->coord.x || p->coord.y != c->coord.y || p->status != c->status) {
+                json_object_array_add(survivors, survivor_json(c));
+            }
+            i++;
+            j++;
+        }
+    }
+    *changes = (int)(json_object_array_length(drones) + json_object_array_length(drones_removed) +
+                     json_object_array_length(survivors) + json_object_array_length(survivors_removed));
+
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string("DELTA"));
+    json_object_object_add(msg, "drones", drones);
+    json_object_object_add(msg, "drones_removed", drones_removed);
+    json_object_object_add(msg, "survivors", survivors);
+    json_object_object_add(msg, "survivors_removed", survivors_removed);
+    return msg;
+}
+
+static int parse_drone(struct json_object *row, FrameDrone *d) {
+    if (json_object_array_length(row) < 7) return 1;
+    d->key = json_object_get_int(json_object_array_get_idx(row, 0));
+    d->id = json_object_get_int(json_object_array_get_idx(row, 1));
+    d->coord.x = json_object_get_int(json_object_array_get_idx(row, 2));
+    d->coord.y = json_object_get_int(json_object_array_get_idx(row, 3));
+    d->target.x = json_object_get_int(json_object_array_get_idx(row, 4));
+    d->target.y = json_object_get_int(json_object_array_get_idx(row, 5));
+    d->status = json_object_get_int(json_object_array_get_idx(row, 6));
+    return 0;
+}
+
+static uint64_t parse_survivor_id(struct json_object *field) {
+    const char *text = json_object_get_string(field);
+    return text ? strtoull(text, NULL, 10) : 0;
+}
+
+static int parse_survivor(struct json_object *row, FrameSurvivor *s) {
+    if (json_object_array_length(row) < 4) return 1;
+    s->id = parse_survivor_id(json_object_array_get_idx(row, 0));
+    s->coord.x = json_object_get_int(json_object_array_get_idx(row, 1));
+    s->coord.y = json_object_get_int(json_object_array_get_idx(row, 2));
+    s->status = json_object_get_int(json_object_array_get_idx(row, 3));
+    return 0;
+}
+
+static FrameDrone *find_drone(Frame *frame, int key) {
+    FrameDrone probe = { .key = key };
+    return bsearch(&probe, frame->drones, frame->num_drones, sizeof(FrameDrone), compare_drones);
+}
+
+static FrameSurvivor *find_survivor(Frame *frame, uint64_t id) {
+    FrameSurvivor probe = { .id = id };
+    return bsearch(&probe, frame->survivors, frame->num_survivors, sizeof(FrameSurvivor), compare_survivors);
+}
+
+static int apply_snapshot(Frame *frame, struct json_object *msg) {
+    struct json_object *stations, *drones, *survivors, *field;
+    if (!json_object_object_get_ex(msg, "drones", &drones) ||
+        !json_object_object_get_ex(msg, "survivors", &survivors)) {
+        return -1;
+    }
+    int num_drones = (int)json_object_array_length(drones);
+    int num_survivors = (int)json_object_array_length(survivors);
+    if (frame_reserve(frame, num_drones, num_survivors) != 0) return -1;
+
+    frame->seq = json_object_object_get_ex(msg, "seq", &field) ? (uint64_t)json_object_get_int64(field) : 0;
+    frame->width = json_object_get_int(json_object_object_get(msg, "width"));
+    frame->height = json_object_get_int(json_object_object_get(msg, "height"));
+    frame->num_stations = 0;
+    if (json_object_object_get_ex(msg, "stations", &stations)) {
+        for (size_t i = 0; i < json_object_array_length(stations) && frame->num_stations < FRAME_MAX_STATIONS; i++) {
+            struct json_object *row = json_object_array_get_idx(stations, i);
+            Coord *c = &frame->stations[frame->num_stations++];
+            c->x = json_object_get_int(json_object_array_get_idx(row, 0));
+            c->y = json_object_get_int(json_object_array_get_idx(row, 1));
+        }
+    }
+    frame->num_drones = 0;
+    for (int i = 0; i < num_drones; i++) {
+        if (parse_drone(json_object_array_get_idx(drones, i), &frame->drones[frame->num_drones]) == 0) {
+            frame->num_drones++;
+        }
+    }
+    frame->num_survivors = 0;
+    for (int i = 0; i < num_survivors; i++) {
+        if (parse_survivor(json_object_array_get_idx(survivors, i), &frame->survivors[frame->num_survivors]) == 0) {
+            frame->num_survivors++;
+        }
+    }
+    frame_sort(frame);
+    return 0;
+}
+
+static int apply_delta(Frame *frame, struct json_object *msg) {
+    struct json_object *list;
+    // Removals: mark, then compact in one pass
+    int removed = 0;
+    if (json_object_object_get_ex(msg, "drones_removed", &list)) {
+        for (size_t i = 0; i < json_object_array_length(list); i++) {
+            FrameDrone *d = find_drone(frame, json_object_get_int(json_object_array_get_idx(list, i)));
+            if (d) {
+                d->status = -1;
+                removed = 1;
+            }
+        }
+    }
+    if (removed) {
+        int n = 0;
+        for (int i = 0; i < frame->num_drones; i++) {
+            if (frame->drones[i].status != -1) frame->drones[n++] = frame->drones[i];
+        }
+        frame->num_drones = n;
+    }
+    removed = 0;
+    if (json_object_object_get_ex(msg, "survivors_removed", &list)) {
+        for (size_t i = 0; i < json_object_array_length(list); i++) {
+            FrameSurvivor *s = find_survivor(frame, parse_survivor_id(json_object_array_get_idx(list, i)));
+            if (s) {
+                s->status = -1;
+                removed = 1;
+            }
+        }
+    }
+    if (removed) {
+        int n = 0;
+        for (int i = 0; i < frame->num_survivors; i++) {
+            if (frame->survivors[i].status != -1) frame->survivors[n++] = frame->survivors[i];
+        }
+        frame->num_survivors = n;
+    }
+
+    // Upserts: update in place, append new ones and re-sort if there were any
+    int appended = 0;
+    if (json_object_object_get_ex(msg, "drones", &list)) {
+        int n = (int)json_object_array_length(list);
+        if (frame_reserve(frame, frame->num_drones + n, 0) != 0) return -1;
+        int sorted_count = frame->num_drones;
+        for (int i = 0; i < n; i++) {
+            FrameDrone d;
+            if (parse_drone(json_object_array_get_idx(list, i), &d) != 0) continue;
+            FrameDrone probe = { .key = d.key };
+            FrameDrone *existing = bsearch(&probe, frame->drones, sorted_count, sizeof(FrameDrone), compare_drones);
+            if (existing) {
+                *existing = d;
+            } else {
+                frame->drones[frame->num_drones++] = d;
+                appended = 1;
+            }
+        }
+    }
+    if (json_object_object_get_ex(msg, "survivors", &list)) {
+        int n = (int)json_object_array_length(list);
+        if (frame_reserve(frame, 0, frame->num_survivors + n) != 0) return -1;
+        int sorted_count = frame->num_survivors;
+        for (int i = 0; i < n; i++) {
+            FrameSurvivor s;
+            if (parse_survivor(json_object_array_get_idx(list, i), &s) != 0) continue;
+            FrameSurvivor probe = { .id = s.id };
+            FrameSurvivor *existing = bsearch(&probe, frame->survivors, sorted_count, sizeof(FrameSurvivor), compare_survivors);
+            if (existing) {
+                *existing = s;
+            } else {
+                frame->survivors[frame->num_survivors++] = s;
+                appended = 1;
+            }
+        }
+    }
+    if (appended) frame_sort(frame);
+    return 0;
+}
+
+// Viewer side. Returns 0 when the message was applied, 1 when it doesn't
+// follow on from this frame (no snapshot yet, or a delta was missed) and
+// the viewer must ask for a RESYNC, -1 for a malformed message.
+int frame_apply_json(Frame *frame, struct json_object *msg) {
+    struct json_object *field;
+    const char *type = json_object_object_get_ex(msg, "type", &field) ? json_object_get_string(field) : NULL;
+    if (!type) return -1;
+    if (strcmp(type, "SNAPSHOT") == 0) return apply_snapshot(frame, msg);
+    if (strcmp(type, "DELTA") != 0) return -1;
+
+    uint64_t seq = json_object_object_get_ex(msg, "seq", &field) ? (uint64_t)json_object_get_int64(field) : 0;
+    if (frame->width == 0 || seq != frame->seq + 1) return 1;
+    if (apply_delta(frame, msg) != 0) return -1;
+    frame->seq = seq;
+    return 0;
+}
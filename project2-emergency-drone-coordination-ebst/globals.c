@@ -1,7 +1,106 @@
+#include <stdio.h>
+#include <pthread.h>
 #include "headers/globals.h"
+#include "headers/mission_index.h"
+#include "headers/archive.h"
 
 Map map;
 List *survivors = NULL;
 List *helpedsurvivors = NULL;
 List *drones = NULL;
-int running = 1;
\ No newline at end of file
+int max_drones = DEFAULT_MAX_DRONES;
+int running = 1;
+
+// Global mutex for initialization
+static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int initialized = 0;
+
+int initialize_globals(const char *archive_path) {
+    pthread_mutex_lock(&init_mutex);
+    if (initialized) {
+        printf("Globals already initialized\n");
+        pthread_mutex_unlock(&init_mutex);
+        return 0;
+    }
+
+    printf("Initializing survivor pool...\n");
+    if (init_survivor_pool() != 0) {
+        printf("Failed to create survivor pool\n");
+        pthread_mutex_unlock(&init_mutex);
+        return 1;
+    }
+    if (mission_index_init() != 0) {
+        destroy_survivor_pool();
+        pthread_mutex_unlock(&init_mutex);
+        return 1;
+    }
+
+    // Survivor lists hold pooled survivors by reference
+    printf("Initializing lists...\n");
+    printf("Creating survivors list with capacity 1000...\n");
+    survivors = create_ref_list(1000);
+    if (!survivors) {
+        printf("Failed to create survivors list\n");
+        mission_index_destroy();
+        destroy_survivor_pool();
+        pthread_mutex_unlock(&init_mutex);
+        return 1;
+    }
+    lock_set_class(&survivors->lock, "survivors list");
+    printf("Survivors list created successfully at %p\n", (void*)survivors);
+
+    // Helped survivors go to the on-disk archive instead of a list
+    if (archive_open(archive_path) != 0) {
+        survivors->destroy(survivors);
+        mission_index_destroy();
+        destroy_survivor_pool();
+        pthread_mutex_unlock(&init_mutex);
+        return 1;
+    }
+
+    printf("Creating drones list with capacity %d...\n", max_drones);
+    drones = create_list(sizeof(Drone), max_drones);
+    if (!drones) {
+        printf("Failed to create drones list\n");
+        survivors->destroy(survivors);
+        archive_close();
+        mission_index_destroy();
+        destroy_survivor_pool();
+        pthread_mutex_unlock(&init_mutex);
+        return 1;
+    }
+    lock_set_class(&drones->lock, "drones list");
+    printf("Drones list created successfully at %p\n", (void*)drones);
+
+    printf("Initializing map...\n");
+    init_map(30, 40);  // height = 30, width = 40
+    printf("Map initialized with dimensions: %dx%d\n", map.width, map.height);
+
+    initialized = 1;
+    printf("All globals initialized successfully\n");
+    pthread_mutex_unlock(&init_mutex);
+    return 0;
+}
+
+void cleanup_globals() {
+    pthread_mutex_lock(&init_mutex);
+    if (!initialized) {
+        pthread_mutex_unlock(&init_mutex);
+        return;
+    }
+
+    if (survivors) {
+        survivors->destroy(survivors);
+        survivors = NULL;
+    }
+    if (drones) {
+        drones->destroy(drones);
+        drones = NULL;
+    }
+    freemap();
+    archive_close();
+    mission_index_destroy();
+    destroy_survivor_pool();  // Frees every survivor the lists referenced
+    initialized = 0;
+    pthread_mutex_unlock(&init_mutex);
+}
@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/handlers.h"
+#include "headers/globals.h"
+#include "headers/ai.h"
+#include "headers/charging.h"
+#include "headers/mission_index.h"
+#include "headers/sla.h"
+#include "headers/archive.h"
+#include "headers/session.h"
+#include "headers/stream.h"
+#include "headers/simclock.h"
+#include "headers/metrics.h"
+#include "headers/trace.h"
+#include "headers/communication.h"
+
+// Protocol message handlers. The server's connection threads call them for
+// every message a drone sends; the simulator calls them directly for its
+// in-process drones.
+
+static void send_handshake_ack(int sock, const char *drone_id, uint64_t token, int resumed) {
+    char token_text[17];
+    format_session_token(token, token_text, sizeof(token_text));
+    struct json_object *ack = json_object_new_object();
+    json_object_object_add(ack, "type", json_object_new_string("HANDSHAKE_ACK"));
+    json_object_object_add(ack, "session_id", json_object_new_string(drone_id));
+    json_object_object_add(ack, "session_token", json_object_new_string(token_text));
+    json_object_object_add(ack, "resumed", json_object_new_boolean(resumed));
+
+    struct json_object *config = json_object_new_object();
+    json_object_object_add(config, "status_update_interval", json_object_new_int(STATUS_UPDATE_INTERVAL));
+    json_object_object_add(config, "heartbeat_interval", json_object_new_int(HEARTBEAT_INTERVAL));
+    json_object_object_add(config, "resume_timeout", json_object_new_int(SESSION_RESUME_TIMEOUT));
+    json_object_object_add(ack, "config", config);
+
+    send_json(sock, ack);
+    printf("Sent HANDSHAKE_ACK to drone %s%s\n", drone_id, resumed ? " (resumed)" : "");
+    json_object_put(ack);
+}
+
+void process_handshake(int sock, struct json_object *jobj) {
+    const char *drone_id = json_object_get_string(json_object_object_get(jobj, "drone_id"));
+    printf("Processing HANDSHAKE for drone_id=%s\n", drone_id);
+    
+    if (!drones) {
+        printf("Error: drones list is NULL\n");
+        struct json_object *error = json_object_new_object();
+        json_object_object_add(error, "type", json_object_new_string("ERROR"));
+        json_object_object_add(error, "code", json_object_new_int(500));
+        json_object_object_add(error, "message", json_object_new_string("Internal server error: drones list not initialized"));
+        send_json(sock, error);
+        json_object_put(error);
+        return;
+    }
+
+    // A known session token re-attaches the drone with its mission intact
+    struct json_object *field;
+    uint64_t token;
+    if (json_object_object_get_ex(jobj, "session_token", &field) &&
+        parse_session_token(json_object_get_string(field), &token) == 0) {
+        Drone *resumed = session_resume(token, sock);
+        if (resumed) {
+            send_handshake_ack(sock, drone_id, token, 1);
+            printf("Drone %s resumed its session on sock %d\n", drone_id, sock);
+            return;
+        }
+        printf("Session of drone %s has expired, registering it again\n", drone_id);
+    }
+
+    printf("Allocating memory for drone...\n");
+    Drone *drone = malloc(sizeof(Drone));
+    if (!drone) {
+        printf("Failed to allocate memory for drone\n");
+        struct json_object *error = json_object_new_object();
+        json_object_object_add(error, "type", json_object_new_string("ERROR"));
+        json_object_object_add(error, "code", json_object_new_int(500));
+        json_object_object_add(error, "message", json_object_new_string("Internal server error"));
+        send_json(sock, error);
+        json_object_put(error);
+        return;
+    }
+    printf("Memory allocated successfully\n");
+
+    printf("Initializing drone data...\n");
+    memset(drone, 0, sizeof(Drone));
+    drone->id = atoi(drone_id + 1); // Extract number from "D1"
+    drone->status = IDLE;
+    drone->sock = sock;
+    
+    // Initialize random starting position
+    drone->coord.x = sim_random_below(map.width);
+    drone->coord.y = sim_random_below(map.height);
+    drone->target = drone->coord;  // Initially target is same as current position
+
+    // Capabilities drive the dispatch cost model (ai.c); assume a standard
+    // general-purpose drone for fields the client leaves out
+    struct json_object *caps = json_object_object_get(jobj, "capabilities");
+    drone->max_speed = json_object_object_get_ex(caps, "max_speed", &field) ?
+                       json_object_get_int(field) : METERS_PER_CELL;
+    drone->battery_capacity = json_object_object_get_ex(caps, "battery_capacity", &field) ?
+                              json_object_get_int(field) : 100;
+    drone->battery = 100;
+    drone->station = -1;
+    drone->session_token = new_session_token();
+    if (json_object_object_get_ex(caps, "payload", &field)) {
+        snprintf(drone->payload, sizeof(drone->payload), "%s", json_object_get_string(field));
+    }
+    printf("Drone capabilities: max_speed=%d, battery_capacity=%d, payload=%s\n",
+           drone->max_speed, drone->battery_capacity,
+           drone->payload[0] ? drone->payload : "any");
+    
+    lock_init(&drone->lock, "drone", 0);
+
+    printf("Adding drone to list...\n");
+    printf("Entering add function...\n");
+    Node *drone_node = drones->add(drones, drone);
+    if (!drone_node) {
+        // No session to hand out: the client's updates would match no drone
+        printf("Drone list full (%d drones), start the server with a larger -n\n", max_drones);
+        lock_destroy(&drone->lock);
+        free(drone);
+        struct json_object *error = json_object_new_object();
+        json_object_object_add(error, "type", json_object_new_string("ERROR"));
+        json_object_object_add(error, "code", json_object_new_int(503));
+        json_object_object_add(error, "message", json_object_new_string("Drone capacity reached"));
+        send_json(sock, error);
+        json_object_put(error);
+        return;
+    }
+    printf("Drone added to list with ID %d at position (%d,%d)\n", 
+           drone->id, drone->coord.x, drone->coord.y);
+    uint64_t session_token = drone->session_token;
+    free(drone);  // The list holds its own copy
+
+    send_handshake_ack(sock, drone_id, session_token, 0);
+
+    // A fresh idle drone may be closer to a survivor than its assigned drone
+    reoptimize_missions((Drone *)drone_node->data);
+}
+
+void process_status_update(int sock, struct json_object *jobj) {
+    struct json_object *loc = json_object_object_get(jobj, "location");
+    int x = json_object_get_int(json_object_object_get(loc, "x"));
+    int y = json_object_get_int(json_object_object_get(loc, "y"));
+    const char *status_str = json_object_get_string(json_object_object_get(jobj, "status"));
+    printf("Processing STATUS_UPDATE: x=%d, y=%d, status=%s\n", x, y, status_str);
+
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        if (d->sock == sock) {
+            lock_acquire(&d->lock);
+            d->coord.x = x;
+            d->coord.y = y;
+            if (d->station >= 0) {
+                // Out of service until the drone reports idle on a full battery;
+                // an idle update on a low battery predates the recharge order
+                int battery = json_object_get_int(json_object_object_get(jobj, "battery"));
+                if (strcmp(status_str, "idle") == 0 && battery >= FULL_BATTERY) {
+                    printf("Drone %d finished charging at station %d\n", d->id, d->station);
+                    release_station(d->station);
+                    d->station = -1;
+                    d->status = IDLE;
+                } else {
+                    d->status = CHARGING;
+                }
+            }
+            else if (strcmp(status_str, "idle") == 0) d->status = IDLE;
+            else if (strcmp(status_str, "busy") == 0) d->status = ON_MISSION;
+            else if (strcmp(status_str, "charging") == 0) d->status = CHARGING;
+            struct json_object *field;
+            if (json_object_object_get_ex(jobj, "battery", &field)) d->battery = json_object_get_int(field);
+            if (json_object_object_get_ex(jobj, "speed", &field)) d->speed = json_object_get_int(field);
+            // First move after an assignment is the departure for every stop left
+            if (d->status == ON_MISSION && !d->departed && d->pending_stops > 0 &&
+                (x != d->dispatch_coord.x || y != d->dispatch_coord.y)) {
+                d->departed = 1;
+                sla_mark_departed(&d->tour, d->tour.count - d->pending_stops);
+            }
+            d->last_update = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
+            lock_release(&d->lock);
+            break;
+        }
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+}
+
+typedef struct ownercheck {
+    Drone *drone;
+    int owned;
+} OwnerCheck;
+
+static void check_owner(MissionEntry *entry, void *arg) {
+    OwnerCheck *check = (OwnerCheck *)arg;
+    check->owned = __atomic_load_n(&entry->drone, __ATOMIC_ACQUIRE) == check->drone;
+}
+
+void process_mission_complete(int sock, struct json_object *jobj) {
+    uint64_t span = trace_start();
+    const char *mission_id = json_object_get_string(json_object_object_get(jobj, "mission_id"));
+    printf("Processing MISSION_COMPLETE: mission_id=%s\n", mission_id);
+
+    uint64_t id = 0;
+    int parsed = parse_mission_id(mission_id, &id) == 0;
+    Drone *freed = NULL;
+    int drone_id = -1;
+    int removed = 0;
+    MissionEntry entry;
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        if (d->sock == sock) {
+            lock_acquire(&d->lock);
+            drone_id = d->id;
+            // Only a stop this drone still flies counts. A duplicate finds
+            // the mission gone, a report racing a MISSION_CANCEL finds no
+            // pending stops or the stop handed to another drone. Both need
+            // d->lock to change, so removing under it claims the survivor.
+            OwnerCheck check = { d, 0 };
+            if (parsed && d->pending_stops > 0) mission_index_visit(id, check_owner, &check);
+            if (check.owned && mission_index_remove(id, &entry) == 0) {
+                removed = 1;
+                // A tour reports each stop separately; stay busy until the
+                // last one. A drone sent to charge keeps its station.
+                d->pending_stops--;
+                if (d->pending_stops == 0 && d->status == ON_MISSION) {
+                    d->status = IDLE;
+                    freed = d;
+                }
+            }
+            lock_release(&d->lock);
+            break;
+        }
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+
+    if (!removed) {
+        printf("Mission %s is unknown, already complete or not this drone's\n",
+               mission_id ? mission_id : "NULL");
+    } else {
+        Survivor *s = entry.survivor;
+        trace_stage_end(STAGE_FLYING, id);
+        lock_acquire(&survivors->lock);
+        lock_acquire(&s->lock);
+        s->status = HELPED;
+        s->helped_time = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
+        s->helped_ns = sim_now_ns();
+        sla_record_helped(s);
+        counter_add(metrics.stops_completed, 1);
+        lock_release(&s->lock);
+        survivors->removenode(survivors, s->node);
+        s->node = NULL;
+        lock_release(&survivors->lock);
+        survivor_cleanup(s);
+
+        // Only the archive row outlives the survivor, so memory stays flat
+        // however long the incident runs. Wall-clock discovery time is
+        // derived from the monotonic stamps for millisecond precision.
+        int64_t helped_ms = sim_wall_ms();
+        ArchiveRecord record;
+        record.values[COL_MISSION_ID] = (int64_t)s->mission_id;
+        record.values[COL_X] = s->coord.x;
+        record.values[COL_Y] = s->coord.y;
+        record.values[COL_DRONE_ID] = drone_id;
+        record.values[COL_DISCOVERED_MS] = helped_ms - (int64_t)((s->helped_ns - s->discovered_ns) / 1000000);
+        record.values[COL_HELPED_MS] = helped_ms;
+        uint64_t archive_start = trace_start();
+        if (archive_append(&record) != 0) {
+            printf("Failed to archive mission %s\n", mission_id);
+        }
+        trace_span("archive_append", id, archive_start);
+        destroy_survivor(s);
+    }
+
+    trace_span("process_mission_complete", id, span);
+
+    if (freed) {
+        reoptimize_missions(freed);
+    }
+}
+
+// Live response-time stats; "stage" picks one of wait/dispatch/flight/total
+void process_sla_query(int sock, struct json_object *jobj) {
+    int stage = -1;
+    struct json_object *field;
+    if (json_object_object_get_ex(jobj, "stage", &field)) {
+        stage = sla_stage_by_name(json_object_get_string(field));
+    }
+    struct json_object *report = sla_report_json(stage);
+    send_json(sock, report);
+    json_object_put(report);
+}
+
+// From here on the stream publisher owns writes to this socket
+void process_subscribe(int sock) {
+    if (stream_subscribe(sock) != 0) {
+        struct json_object *error = json_object_new_object();
+        json_object_object_add(error, "type", json_object_new_string("ERROR"));
+        json_object_object_add(error, "code", json_object_new_int(503));
+        json_object_object_add(error, "message", json_object_new_string("Too many viewers"));
+        send_json(sock, error);
+        json_object_put(error);
+    }
+}
+
+void process_heartbeat_response(int sock, struct json_object *jobj) {
+    printf("Processing HEARTBEAT_RESPONSE\n");
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        if (d->sock == sock) {
+            lock_acquire(&d->lock);
+            d->last_update = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
+            lock_release(&d->lock);
+            break;
+        }
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+}
+
+// One HEARTBEAT to every connected drone
+void send_heartbeats() {
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Drone *d = (Drone *)node->data;
+        if (d->status != DISCONNECTED) {
+            struct json_object *heartbeat = json_object_new_object();
+            json_object_object_add(heartbeat, "type", json_object_new_string("HEARTBEAT"));
+            json_object_object_add(heartbeat, "timestamp", json_object_new_int64(sim_time()));
+            send_json(d->sock, heartbeat);
+            printf("Sent HEARTBEAT to drone D%d\n", d->id);
+            json_object_put(heartbeat);
+        }
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+}
+
+void *heartbeat_thread(void *arg) {
+    while (1) {
+        sleep(HEARTBEAT_INTERVAL);
+        send_heartbeats();
+    }
+    return NULL;
+}
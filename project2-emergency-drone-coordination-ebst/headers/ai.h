@@ -5,9 +5,23 @@
 #include "coord.h"
 #include "list.h"
 #include "communication.h"
+#include "tour.h"
+#include "charging.h"
 
-void assign_mission(Drone *drone, Coord target, const char *mission_id);
-Drone *find_closest_idle_drone(Coord target);
+#define REASSIGN_THRESHOLD 5    // Cells a freed drone must save to take over a mission
+#define METERS_PER_CELL 30      // A drone cruising at 30 m/s crosses one cell per second
+#define BATTERY_RESERVE 10      // Energy units every dispatch must leave untouched
+#define MAX_DISPATCH_ATTEMPTS 8 // Waiting survivors tried per AI pass
+#define AI_PASS_INTERVAL_MS 100 // Pause between AI passes
+
+void assign_mission(Drone *drone, Coord target, uint64_t mission_id);
+void assign_tour(Drone *drone, const Tour *tour);
+double estimate_eta(const Drone *drone, int cells);
+int remaining_energy(const Drone *drone);
+int can_serve(const Drone *drone, const Tour *tour);
+Drone *find_closest_idle_drone(const Tour *tour);
+void reoptimize_missions(Drone *idle_drone);
+void ai_dispatch_pass();
 void *ai_controller(void *arg);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARCHIVE_PATH "helped_survivors.arc"
+#define ARCHIVE_BLOCK_ROWS 4096      // Rows buffered before a block is written
+#define ARCHIVE_FLUSH_INTERVAL 10    // Seconds before a partial block is written anyway
+
+typedef enum {
+    COL_MISSION_ID,
+    COL_X,
+    COL_Y,
+    COL_DRONE_ID,
+    COL_DISCOVERED_MS,   // Unix epoch milliseconds
+    COL_HELPED_MS,
+    ARCHIVE_COLUMNS
+} ArchiveColumn;
+
+#define COLUMN_BIT(c) (1u << (c))
+#define ALL_COLUMNS ((1u << ARCHIVE_COLUMNS) - 1)
+
+// One helped survivor. Readers only fill the columns they asked for.
+typedef struct archiverecord {
+    int64_t values[ARCHIVE_COLUMNS];
+} ArchiveRecord;
+
+// A whole archive file mapped read-only
+typedef struct archivereader {
+    const unsigned char *data;
+    size_t size;
+    int fd;
+} ArchiveReader;
+
+typedef void (*ArchiveVisitor)(const ArchiveRecord *record, void *ctx);
+
+int archive_open(const char *path);
+int archive_append(const ArchiveRecord *record);
+int archive_flush();
+int archive_buffered_rows();
+void archive_close();
+
+int archive_reader_open(const char *path, ArchiveReader *reader);
+void archive_reader_close(ArchiveReader *reader);
+long archive_scan(const ArchiveReader *reader, unsigned columns,
+                  int64_t from_ms, int64_t to_ms, ArchiveVisitor visit, void *ctx);
+#endif
@@ -0,0 +1,27 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_REGRESSION_PCT 10.0   // Default change counted as a regression
+
+// One measured number. Results from two runs are matched by name and
+// param, so both must stay stable across releases.
+typedef struct benchresult {
+    char name[48];
+    int param;              // Threads, fleet size or drones; 0 if none
+    double value;
+    const char *unit;
+    int higher_is_better;
+} BenchResult;
+
+typedef struct benchreport {
+    const char *suite;      // "micro" or "e2e"
+    BenchResult results[BENCH_MAX_RESULTS];
+    int count;
+} BenchReport;
+
+void bench_add(BenchReport *report, const char *name, int param, double value,
+               const char *unit, int higher_is_better);
+int bench_write(const BenchReport *report, const char *path);
+int bench_compare(const char *base_path, const char *new_path, double threshold_pct);
+#endif
@@ -0,0 +1,24 @@
+#ifndef CHARGING_H
+#define CHARGING_H
+#include "coord.h"
+#include "drone.h"
+#include "map.h"
+
+#define NUM_CHARGING_STATIONS 4
+#define STATION_SLOTS 2
+#define ENERGY_PER_CELL 1        // Battery energy units spent per cell flown
+#define CHARGE_RATE 10           // Energy units restored per second docked
+#define LOW_BATTERY 30           // Percent: idle drones below this get recharged
+#define CRITICAL_BATTERY 15      // Percent: recharge even past the fleet share
+#define FULL_BATTERY 95          // Percent: a charging drone back idle is done
+#define MAX_CHARGING_SHARE 3     // At most 1/3 of the fleet charging at once
+#define CHARGE_CHECK_INTERVAL 2  // Seconds between scheduler passes
+
+void init_charging_stations();
+int nearest_station(Coord from, int need_free_slot);
+int reserve_station(Coord from);
+void release_station(int index);
+void assign_recharge(Drone *drone, int station);
+void charging_pass();
+void *charging_scheduler(void *arg);
+#endif
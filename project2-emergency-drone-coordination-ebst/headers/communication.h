@@ -3,7 +3,12 @@
 
 #include <json-c/json.h>
 
+typedef void (*LocalDelivery)(int sock, struct json_object *jobj);
+
+void set_local_delivery(LocalDelivery fn);
 void send_json(int sock, struct json_object *jobj);
 struct json_object *receive_json(int sock);
+void receive_json_reset();
+int cancel_withdraws(struct json_object *cancel, const char *mission_id);
 
 #endif 
\ No newline at end of file
@@ -2,13 +2,17 @@
 #define DRONE_H
 #include "coord.h"
 #include <time.h>
+#include <stdint.h>
 #include <pthread.h>
 #include "list.h"
+#include "lockprof.h"
+#include "tour.h"
 
 typedef enum {
     IDLE,
     ON_MISSION,
-    DISCONNECTED
+    DISCONNECTED,
+    CHARGING     // Flying to or docked at a charging station
 } DroneStatus;
 
 typedef struct drone {
@@ -17,8 +21,20 @@ typedef struct drone {
     int status;
     Coord coord;
     Coord target;
+    Tour tour;         // Stops of the current mission, in flight order
+    int pending_stops; // Tour stops not yet reported complete
+    Coord dispatch_coord; // Where the drone was when the tour was assigned
+    int departed;         // Left dispatch_coord since the assignment
+    int max_speed;        // m/s, from HANDSHAKE capabilities
+    int battery_capacity; // Energy units of a full battery
+    int battery;          // Percent of capacity, from STATUS_UPDATE
+    int speed;            // Current speed reported by the drone
+    char payload[16];     // Aid carried, e.g. "medical" ("" carries anything)
+    int station;          // Reserved charging station index, -1 if none
     struct tm last_update;
-    pthread_mutex_t lock;
+    uint64_t session_token;  // Lets a dropped drone resume, 0 once expired
+    time_t disconnected_at;  // When the link dropped, while DISCONNECTED
+    Lock lock;
     int sock; // Socket descriptor for client communication
 } Drone;
 
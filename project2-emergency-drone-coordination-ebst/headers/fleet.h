@@ -0,0 +1,65 @@
+#ifndef FLEET_H
+#define FLEET_H
+#include <stdint.h>
+#include <pthread.h>
+
+#define FLEET_TICK_MS 100       // Simulated time per step when run in real time
+#define FLEET_MAX_THREADS 64
+
+// Simulated drones, stored as parallel arrays so a step is one pass over
+// contiguous memory. Status is IDLE or ON_MISSION.
+typedef struct fleetstate {
+    uint64_t tick;              // Steps taken to reach this state
+    int32_t *x, *y;
+    int32_t *target_x, *target_y;
+    uint8_t *status;
+} FleetState;
+
+typedef struct fleetworker {
+    struct fleet *fleet;
+    pthread_t thread;
+    int begin, end;             // Drones this worker steps
+    unsigned long completed;    // Missions finished, this step
+} FleetWorker;
+
+// A fixed-timestep engine for large synthetic fleets. Each step every drone
+// moves one cell toward its target; one that arrives idles for a step, then
+// takes a new target derived from the seed, its index and the tick, so a
+// run is the same for any number of threads.
+//
+// States are triple-buffered like the render snapshot: a step reads the
+// last published state and writes the back one, then publishes it with one
+// atomic exchange. One reader takes the newest state with fleet_latest()
+// and keeps it until its next call; nothing is locked per drone.
+typedef struct fleet {
+    int count;
+    int width, height;
+    uint64_t seed;
+    FleetState states[3];
+    int middle;                 // Index of the newest state, plus FRESH
+    int back, last;             // Stepping side only
+    int front, have_front;      // Reader side only
+    unsigned long missions_completed;
+
+    // Workers 1..num_workers-1 are threads; the stepping thread is worker 0
+    int num_workers;
+    FleetWorker workers[FLEET_MAX_THREADS];
+    pthread_mutex_t step_lock;
+    pthread_cond_t step_start, step_done;
+    uint64_t generation;        // Bumped to start a step
+    int pending;                // Workers still stepping
+    int shutting_down;
+
+    pthread_t simulator;        // Real-time driver, see fleet_start
+    int simulating;
+} Fleet;
+
+int fleet_init(Fleet *fleet, int count, int width, int height, int threads, uint64_t seed);
+void fleet_free(Fleet *fleet);
+void fleet_step(Fleet *fleet);
+const FleetState *fleet_latest(Fleet *fleet);
+int fleet_start(Fleet *fleet);
+void fleet_stop(Fleet *fleet);
+
+extern Fleet *sim_fleet;
+#endif
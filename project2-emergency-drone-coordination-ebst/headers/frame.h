@@ -0,0 +1,48 @@
+#ifndef FRAME_H
+#define FRAME_H
+#include <stdint.h>
+#include <json-c/json.h>
+#include "coord.h"
+
+#define FRAME_MAX_STATIONS 16
+
+// What a viewer needs to draw one drone or survivor. Arrays are kept
+// sorted by key so two frames can be diffed in one merge pass.
+typedef struct framedrone {
+    int key;          // Slot in the server's drone list, stable while connected
+    int id;
+    Coord coord;
+    Coord target;
+    int status;       // DroneStatus
+} FrameDrone;
+
+typedef struct framesurvivor {
+    uint64_t id;      // Mission ID
+    Coord coord;
+    int status;       // WAITING / ASSIGNED
+} FrameSurvivor;
+
+// The whole visible world at one tick. Plain data: no locks, no pointers
+// into simulation state, so it can be copied, diffed, sent or drawn
+// anywhere.
+typedef struct frame {
+    uint64_t seq;     // Number of deltas published up to this frame
+    int width, height;
+    int num_stations;
+    Coord stations[FRAME_MAX_STATIONS];
+    FrameDrone *drones;
+    int num_drones, drones_capacity;
+    FrameSurvivor *survivors;
+    int num_survivors, survivors_capacity;
+} Frame;
+
+void frame_init(Frame *frame);
+void frame_free(Frame *frame);
+int frame_reserve(Frame *frame, int drones, int survivors);
+void frame_sort(Frame *frame);
+int frame_copy(Frame *dst, const Frame *src);
+int frame_equal(const Frame *a, const Frame *b);
+struct json_object *frame_snapshot_json(const Frame *frame);
+struct json_object *frame_delta_json(const Frame *prev, const Frame *cur, int *changes);
+int frame_apply_json(Frame *frame, struct json_object *msg);
+#endif
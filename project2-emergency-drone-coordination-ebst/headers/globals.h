@@ -6,7 +6,15 @@
 #include "list.h"
 #include "coord.h"
 
+#define DEFAULT_MAX_DRONES 64   // Drone slots preallocated at startup
+#define MAX_DRONES 1048576       // Largest max_drones accepted
+
+extern int max_drones;           // Drone list capacity; set before initialize_globals()
+
 extern Map map;
 extern List *survivors, *helpedsurvivors, *drones;
 extern int running;
+
+int initialize_globals(const char *archive_path);
+void cleanup_globals();
 #endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef HANDLERS_H
+#define HANDLERS_H
+#include <json-c/json.h>
+
+#define STATUS_UPDATE_INTERVAL 5  // Seconds, sent to drones in HANDSHAKE_ACK
+#define HEARTBEAT_INTERVAL 10     // Seconds between HEARTBEAT rounds
+
+void process_handshake(int sock, struct json_object *jobj);
+void process_status_update(int sock, struct json_object *jobj);
+void process_mission_complete(int sock, struct json_object *jobj);
+void process_heartbeat_response(int sock, struct json_object *jobj);
+void process_sla_query(int sock, struct json_object *jobj);
+void process_subscribe(int sock);
+void send_heartbeats();
+void *heartbeat_thread(void *arg);
+#endif
@@ -0,0 +1,24 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+#include <stdint.h>
+
+// HDR-style buckets: exact below 2^HISTOGRAM_SUB_BITS, then every power of
+// two is split into 2^(HISTOGRAM_SUB_BITS-1) linear steps (about 3% error)
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_MAX_BITS 44    // Values above 2^44 (~4.9 hours in ns) land in the top bucket
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) << (HISTOGRAM_SUB_BITS - 1))
+
+// Updated with atomic adds only, so recording never takes a lock
+typedef struct histogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} Histogram;
+
+uint64_t monotonic_ns();
+void histogram_record(Histogram *h, uint64_t value);
+uint64_t histogram_percentile(const Histogram *h, double percentile);
+uint64_t histogram_count_below(const Histogram *h, uint64_t value);
+void histogram_merge(Histogram *into, const Histogram *from);
+#endif
@@ -2,6 +2,7 @@
 #define LIST_H
 #include <time.h>
 #include <pthread.h>
+#include "lockprof.h"
 
 typedef struct node {
     struct node *prev;
@@ -15,13 +16,13 @@ typedef struct list {
     Node *tail;
     int number_of_elements;
     int capacity;
-    size_t datasize;
+    size_t datasize;       // 0: node->data is the caller's pointer (no copy)
     size_t nodesize;
     char *startaddress;
     char *endaddress;
     Node *lastprocessed;
     Node *free_list;
-    pthread_mutex_t lock;
+    Lock lock;             // Recursive
     Node *(*add)(struct list *list, void *data);
     int (*removedata)(struct list *list, void *data);
     int (*removenode)(struct list *list, Node *node);
@@ -34,6 +35,7 @@ typedef struct list {
 } List;
 
 List *create_list(size_t datasize, int capacity);
+List *create_ref_list(int capacity);
 int removenode(List *list, Node *node);
 Node *add(List *list, void *data);
 int removedata(List *list, void *data);
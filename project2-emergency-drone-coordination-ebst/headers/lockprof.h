@@ -0,0 +1,81 @@
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#define LOCK_CLASSES_MAX 16
+
+// Totals for one lock class or one acquisition site, updated with relaxed
+// atomics by whichever thread takes or releases the lock
+typedef struct lockstats {
+    uint64_t acquisitions;
+    uint64_t contended;      // Acquisitions that found the lock held
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    uint64_t hold_ns;
+    uint64_t max_hold_ns;
+} LockStats;
+
+// Locks of one kind (every survivor's lock, every map cell list), so
+// generic code like list.c can still be told apart
+typedef struct lockclass {
+    const char *name;
+    LockStats stats;
+} LockClass;
+
+// One lock_acquire() in the source. Each call site owns a static one,
+// linked into the report the first time it is profiled.
+typedef struct locksite {
+    const char *file;
+    int line;
+    const char *expr;        // The lock expression as written
+    LockStats stats;
+    int linked;
+    struct locksite *next;
+} LockSite;
+
+// A pthread mutex plus what the holder needs to time its hold. Only the
+// thread holding the mutex touches the fields after it.
+typedef struct lock {
+    pthread_mutex_t mutex;
+    LockClass *cls;
+    LockSite *holder_site;   // Where the current holder took it
+    uint64_t acquired_ns;
+    int depth;               // Nesting of a recursive lock's holder
+} Lock;
+
+// Set once by lock_profiling_enable(), before any thread starts. While it
+// is 0, acquire and release are a branch plus the pthread call.
+extern int lock_profiling;
+
+void lock_profiling_enable();
+LockClass *lock_class(const char *name);
+int lock_init(Lock *lock, const char *class_name, int recursive);
+void lock_set_class(Lock *lock, const char *class_name);
+void lock_destroy(Lock *lock);
+void lock_acquire_profiled(Lock *lock, LockSite *site);
+void lock_release_profiled(Lock *lock);
+void lock_report(FILE *out);
+
+static inline void lock_acquire_at(Lock *lock, LockSite *site) {
+    if (!lock_profiling) {
+        pthread_mutex_lock(&lock->mutex);
+        return;
+    }
+    lock_acquire_profiled(lock, site);
+}
+
+static inline void lock_release(Lock *lock) {
+    if (!lock_profiling) {
+        pthread_mutex_unlock(&lock->mutex);
+        return;
+    }
+    lock_release_profiled(lock);
+}
+
+#define lock_acquire(l) do { \
+    static LockSite lock_site_ = { .file = __FILE__, .line = __LINE__, .expr = #l }; \
+    lock_acquire_at((l), &lock_site_); \
+} while (0)
+#endif
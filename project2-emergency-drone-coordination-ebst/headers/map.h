@@ -9,11 +9,20 @@ extern List *survivors;
 typedef struct mapcell {
     Coord coord;
     List *survivors;
+    double demand; // Decayed count of survivor appearances (rebalance.c)
 } MapCell;
 
+typedef struct chargingstation {
+    Coord coord;
+    int slots;     // Drones that can charge here at once
+    int occupied;  // Slots reserved by drones en route or docked
+} ChargingStation;
+
 typedef struct map {
     int height, width;
     MapCell **cells;
+    ChargingStation *stations;
+    int num_stations;
 } Map;
 
 extern Map map;
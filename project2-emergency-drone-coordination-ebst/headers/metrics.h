@@ -0,0 +1,69 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <stdint.h>
+#include <stdio.h>
+#include "histogram.h"
+
+#define METRICS_PORT 9100        // Prometheus scrape endpoint, on 127.0.0.1
+#define METRICS_SHARDS 16        // Slots per counter; threads spread over them
+#define METRICS_MAX 64           // Registered series
+
+// One cache line per shard, so threads updating the same counter don't
+// bounce the line between cores
+typedef struct metricshard {
+    int64_t value;
+} __attribute__((aligned(64))) MetricShard;
+
+// Counters only go up; gauges go both ways. Both are summed over the
+// shards when scraped.
+typedef struct counter {
+    MetricShard shards[METRICS_SHARDS];
+} Counter;
+typedef Counter Gauge;
+
+// Durations in nanoseconds, exported in seconds
+typedef struct metricshistogram {
+    Histogram shards[METRICS_SHARDS];
+} MetricsHistogram;
+
+typedef enum {
+    MSG_HANDSHAKE,
+    MSG_STATUS_UPDATE,
+    MSG_MISSION_COMPLETE,
+    MSG_HEARTBEAT_RESPONSE,
+    MSG_SLA_QUERY,
+    MSG_SUBSCRIBE,
+    MSG_RESYNC,
+    MSG_OTHER,             // Missing or unknown type
+    NUM_MESSAGE_KINDS
+} MessageKind;
+
+// What the server records. Every handle is NULL until metrics_init(),
+// and updating a NULL handle does nothing, so tools that share the server
+// code but don't serve metrics pay nothing.
+typedef struct servermetrics {
+    Counter *messages[NUM_MESSAGE_KINDS];
+    Counter *connections_accepted;
+    Gauge *connections;
+    Counter *survivors_created;
+    Counter *stops_assigned;
+    Counter *stops_completed;
+    Counter *missions_reassigned;
+    MetricsHistogram *dispatch_latency;   // Survivor discovery to first assignment
+    MetricsHistogram *dispatch_pass;      // One AI controller pass
+} ServerMetrics;
+
+extern ServerMetrics metrics;
+
+Counter *metrics_counter(const char *name, const char *help, const char *labels);
+Gauge *metrics_gauge(const char *name, const char *help, const char *labels);
+int metrics_gauge_fn(const char *name, const char *help, const char *labels, double (*read)());
+MetricsHistogram *metrics_histogram(const char *name, const char *help, const char *labels);
+void counter_add(Counter *counter, int64_t n);
+void gauge_add(Gauge *gauge, int64_t n);
+void metrics_observe(MetricsHistogram *histogram, uint64_t ns);
+Counter *message_counter(const char *type);
+int metrics_init();
+void metrics_render(FILE *out);
+void *metrics_server(void *arg);
+#endif
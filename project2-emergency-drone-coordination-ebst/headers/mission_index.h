@@ -0,0 +1,39 @@
+#ifndef MISSION_INDEX_H
+#define MISSION_INDEX_H
+#include <stdint.h>
+#include <pthread.h>
+#include "survivor.h"
+#include "drone.h"
+
+#define MISSION_INDEX_CAPACITY 4096  // Initial slots, a power of two
+#define MISSION_ID_EMPTY 0           // Never handed out as a mission ID
+
+// Where a mission stands: its survivor and the drone flying it (NULL
+// while it waits for one)
+typedef struct missionentry {
+    uint64_t id;
+    Survivor *survivor;
+    Drone *drone;
+} MissionEntry;
+
+// Open-addressing table with linear probing. Lookups share a read lock,
+// inserts and removals take it exclusively; removal shifts the following
+// entries back, so there are no tombstones and probes stay short.
+typedef struct missionindex {
+    MissionEntry *slots;
+    uint64_t mask;               // capacity - 1
+    uint64_t count;
+    pthread_rwlock_t lock;
+} MissionIndex;
+
+int mission_index_init();
+void mission_index_destroy();
+int mission_index_insert(uint64_t id, Survivor *survivor);
+int mission_index_set_drone(uint64_t id, Drone *drone);
+int mission_index_lookup(uint64_t id, MissionEntry *out);
+int mission_index_visit(uint64_t id, void (*fn)(MissionEntry *entry, void *arg), void *arg);
+int mission_index_remove(uint64_t id, MissionEntry *out);
+void mission_index_forget_drone(Drone *drone);
+uint64_t mission_index_count();
+int parse_mission_id(const char *text, uint64_t *id);
+#endif
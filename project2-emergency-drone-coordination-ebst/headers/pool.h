@@ -0,0 +1,34 @@
+#ifndef POOL_H
+#define POOL_H
+#include <stddef.h>
+#include <pthread.h>
+
+#define POOL_CACHE_SIZE 64      // Objects a thread keeps for itself
+#define POOL_SLAB_OBJECTS 256   // Objects carved per malloc when empty
+
+// Per-thread stack of free objects, used without any lock
+typedef struct poolcache {
+    struct pool *pool;
+    int count;
+    void *objects[POOL_CACHE_SIZE];
+} PoolCache;
+
+// Fixed-size object pool. Objects come from slabs that are never returned
+// to malloc while the pool lives, so `init` (e.g. pthread_mutex_init) runs
+// once per object, not once per allocation.
+typedef struct pool {
+    size_t objsize;
+    void (*init)(void *obj);
+    pthread_mutex_t lock;        // Protects free_list, slabs and counters
+    void *free_list;             // Shared free objects, linked through their first word
+    int free_count;
+    void *slabs;                 // Linked through the first word of each slab
+    long slab_count;
+    pthread_key_t cache_key;     // Thread's PoolCache; flushed when the thread exits
+} Pool;
+
+int pool_init(Pool *pool, size_t objsize, void (*init)(void *obj));
+void *pool_alloc(Pool *pool);
+void pool_free(Pool *pool, void *obj);
+void pool_destroy(Pool *pool);
+#endif
@@ -0,0 +1,27 @@
+#ifndef RASTER_H
+#define RASTER_H
+#include <stdint.h>
+#include <stdio.h>
+#include "frame.h"
+
+// Draws frames into a plain pixel buffer instead of an SDL window, with the
+// same layout and colors as view.c, so recorded state can be rendered
+// without a display
+
+#define RASTER_MAX_PIXELS (8192 * 8192)
+
+typedef struct raster {
+    uint32_t *pixels;  // 0x00RRGGBB, row-major
+    int map_width, map_height;
+    int width, height; // In pixels
+    int cell_size;     // Pixels per map cell
+    uint8_t *rgb;      // Packed 24-bit copy of pixels for writing out
+} Raster;
+
+int raster_init(Raster *raster, int map_width, int map_height, int cell_size);
+void raster_free(Raster *raster);
+void raster_fill_span(uint32_t *dst, int count, uint32_t color);
+void raster_draw_frame(Raster *raster, const Frame *frame);
+int raster_write_ppm(Raster *raster, FILE *out);
+int raster_write_raw(Raster *raster, FILE *out);
+#endif
@@ -0,0 +1,17 @@
+#ifndef REBALANCE_H
+#define REBALANCE_H
+#include "coord.h"
+#include "drone.h"
+
+#define REBALANCE_INTERVAL 5        // Seconds between rebalancing passes
+#define DEMAND_DECAY 0.97           // Heat kept per pass (half-life ~2 minutes)
+#define DEMAND_EPSILON 0.01         // Cells cooler than this are ignored
+#define KMEANS_ITERATIONS 10
+#define REPOSITION_MIN_DISTANCE 3   // Don't move drones already this close
+
+void record_demand(Coord coord);
+void decay_demand();
+void rebalance_idle_drones();
+void assign_reposition(Drone *drone, Coord target);
+void *rebalancer(void *arg);
+#endif
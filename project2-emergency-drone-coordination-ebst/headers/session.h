@@ -0,0 +1,17 @@
+#ifndef SESSION_H
+#define SESSION_H
+#include <stdint.h>
+#include "drone.h"
+
+#define SESSION_RESUME_TIMEOUT 30   // Seconds a dropped drone keeps its mission
+#define SESSION_REAP_INTERVAL 1     // Seconds between expiry checks
+
+uint64_t new_session_token();
+int parse_session_token(const char *text, uint64_t *token);
+void format_session_token(uint64_t token, char *buf, size_t size);
+Drone *session_resume(uint64_t token, int sock);
+void session_detach(Drone *drone);
+void session_expire(Drone *drone);
+void session_reap_pass();
+void *session_reaper(void *arg);
+#endif
@@ -0,0 +1,26 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+#include <stdint.h>
+#include <time.h>
+
+// Time and randomness for the server logic. Normally these are the wall
+// clock and a shared generator seeded at startup. After
+// sim_use_virtual_time() they come from a virtual clock that only moves
+// when the event queue below runs the next event, and from a fixed seed,
+// so the same inputs give the same run at whatever speed the CPU allows.
+
+#define SIM_EPOCH 1704067200  // Wall time at virtual time zero (2024-01-01 UTC)
+
+typedef void (*SimEventFn)(void *arg);
+
+void sim_use_virtual_time(uint64_t seed);
+int sim_is_virtual();
+uint64_t sim_now_ns();
+time_t sim_time();
+int64_t sim_wall_ms();
+uint64_t sim_random();
+int sim_random_below(int n);
+
+int sim_schedule(uint64_t delay_ns, SimEventFn fn, void *arg);
+uint64_t sim_run(uint64_t until_ns);
+#endif
@@ -0,0 +1,29 @@
+#ifndef SLA_H
+#define SLA_H
+#include <stdint.h>
+#include <stdio.h>
+#include <json-c/json.h>
+#include "survivor.h"
+#include "tour.h"
+#include "histogram.h"
+
+#define SLA_REGION_COLS 4        // The map is cut into COLS x ROWS regions
+#define SLA_REGION_ROWS 3
+#define SLA_REGIONS (SLA_REGION_COLS * SLA_REGION_ROWS)
+
+typedef enum {
+    SLA_WAIT,       // Discovered -> assigned to a drone
+    SLA_DISPATCH,   // Assigned -> drone departed
+    SLA_FLIGHT,     // Departed -> helped
+    SLA_TOTAL,      // Discovered -> helped: the response time we are judged on
+    SLA_STAGES
+} SlaStage;
+
+int sla_region(Coord coord);
+void sla_mark_assigned(const Tour *tour);
+void sla_mark_departed(const Tour *tour, int first_stop);
+void sla_record_helped(const Survivor *s);
+int sla_stage_by_name(const char *name);
+struct json_object *sla_report_json(int stage);
+void sla_dump(FILE *out);
+#endif
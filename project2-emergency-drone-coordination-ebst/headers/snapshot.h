@@ -0,0 +1,10 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "frame.h"
+
+// Triple buffer of frames between one publisher (the simulation side)
+// and one renderer
+Frame *snapshot_back();
+void snapshot_publish();
+const Frame *snapshot_latest();
+#endif
@@ -0,0 +1,17 @@
+#ifndef STREAM_H
+#define STREAM_H
+#include <stddef.h>
+#include "frame.h"
+
+#define STREAM_TICK_MS 100             // How often the world is captured and deltas published
+#define STREAM_MAX_SUBSCRIBERS 64
+#define STREAM_MAX_BACKLOG (1 << 20)   // Bytes queued per viewer before it is resynced
+
+void capture_frame(Frame *frame);
+int stream_subscribe(int sock);
+void stream_resync(int sock);
+void stream_unsubscribe(int sock);
+void stream_stats(int *subscriber_count, size_t *backlog_bytes);
+void *stream_publisher(void *arg);
+int draw_map();
+#endif
@@ -2,6 +2,7 @@
 #define SURVIVOR_H
 #include "coord.h"
 #include <time.h>
+#include <stdint.h>
 #include "list.h"
 #include <pthread.h>
 
@@ -9,18 +10,41 @@
 #define ASSIGNED 1
 #define HELPED 2
 
+#define PRIORITY_LOW 0
+#define PRIORITY_MEDIUM 1
+#define PRIORITY_HIGH 2
+#define NUM_PRIORITIES 3
+
+#define NUM_PAYLOAD_TYPES 3
+extern const char *payload_types[NUM_PAYLOAD_TYPES];
+
 typedef struct survivor {
     int status;
     Coord coord;
+    uint64_t mission_id;   // Unique for the server's lifetime, see next_mission_id
+    Node *node;            // Entry in the survivors list, for O(1) removal
     struct tm discovery_time;
     struct tm helped_time;
+    int priority;          // PRIORITY_*, from the aid needed
+    // sim_now_ns() at each lifecycle stage, 0 = not reached
+    uint64_t discovered_ns;
+    uint64_t assigned_ns;
+    uint64_t departed_ns;
+    uint64_t helped_ns;
     char info[25];
-    pthread_mutex_t lock;  // Add mutex lock for thread safety
+    char payload[16];      // Aid needed, matched against Drone payload
+    Lock lock;             // Add mutex lock for thread safety
 } Survivor;
 
 extern List *survivors;
 extern List *helpedsurvivors;
-Survivor *create_survivor(Coord *coord, char *info, struct tm *discovery_time);
+int init_survivor_pool();
+void destroy_survivor_pool();
+int payload_priority(const char *payload);
+Survivor *create_survivor(Coord *coord, char *info, const char *payload, struct tm *discovery_time);
+void destroy_survivor(Survivor *s);
+int spawn_survivor(Coord coord, const char *info, const char *payload);
+int generate_survivor();
 void *survivor_generator(void *args);
 void survivor_cleanup(Survivor *s);
 #endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef TOUR_H
+#define TOUR_H
+#include "coord.h"
+#include "survivor.h"
+
+#define MAX_TOUR_STOPS 6        // Survivors served by one multi-stop mission
+#define TOUR_CLUSTER_RADIUS 5   // Max distance (cells) from the first survivor
+
+typedef struct tourstop {
+    Coord coord;
+    uint64_t id;           // Survivor mission_id (0 on the client)
+    char mission_id[25];   // Same ID as sent on the wire, echoed in MISSION_COMPLETE
+    Survivor *survivor;    // Survivor reserved for this stop (NULL on the client)
+} TourStop;
+
+typedef struct tour {
+    int count;
+    char payload[16];      // Aid needed by every stop of the tour
+    TourStop stops[MAX_TOUR_STOPS];
+} Tour;
+
+int travel_distance(Coord a, Coord b);
+int tour_length(Coord start, const Tour *tour);
+int collect_tour(Tour *tour, int skip);
+void release_tour(Tour *tour);
+void plan_tour(Coord start, Tour *tour);
+#endif
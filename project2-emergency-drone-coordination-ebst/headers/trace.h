@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <stdint.h>
+#include <stdio.h>
+#include "simclock.h"
+
+#define TRACE_RING_MIN 256        // Events a thread's ring starts with
+#define TRACE_RING_MAX 16384      // Events kept per thread once it wraps
+
+// Mission stages, shown as one async track per mission ID
+#define STAGE_WAITING "waiting"   // Discovered or released, no drone yet
+#define STAGE_FLYING "flying"     // Assigned, until the drone reports it
+
+// One recorded event. `name` must be a string literal: only the pointer
+// is stored.
+typedef struct traceevent {
+    const char *name;
+    uint64_t mission;     // Mission ID the event belongs to, 0 for none
+    uint64_t ts_ns;       // sim_now_ns() at the start
+    uint64_t dur_ns;      // Spans only
+    char phase;           // Chrome trace phase: 'X' span, 'b'/'e' stage
+} TraceEvent;
+
+// Set once by trace_enable() before threads start. While it is 0 every
+// trace call below is a single branch.
+extern int tracing;
+
+void trace_enable();
+void trace_thread_name(const char *name);
+void trace_record(char phase, const char *name, uint64_t mission, uint64_t ts_ns, uint64_t dur_ns);
+void trace_write(FILE *out);
+int trace_save(const char *path);
+
+// Start of a span, to pass to trace_span() when it ends
+static inline uint64_t trace_start() {
+    return tracing ? sim_now_ns() : 0;
+}
+
+static inline void trace_span(const char *name, uint64_t mission, uint64_t start) {
+    if (tracing) trace_record('X', name, mission, start, sim_now_ns() - start);
+}
+
+static inline void trace_stage_begin(const char *stage, uint64_t mission) {
+    if (tracing) trace_record('b', stage, mission, sim_now_ns(), 0);
+}
+
+static inline void trace_stage_end(const char *stage, uint64_t mission) {
+    if (tracing) trace_record('e', stage, mission, sim_now_ns(), 0);
+}
+#endif
@@ -1,10 +1,8 @@
 #ifndef VIEW_H
 #define VIEW_H
 #include <SDL2/SDL.h>
-#include "map.h"
-#include "drone.h"
-#include "survivor.h"
-#include "globals.h"
+#include <pthread.h>
+#include "frame.h"
 
 // SDL variables
 extern SDL_Window *window;
@@ -25,12 +23,10 @@ extern const SDL_Color GREEN;
 extern const SDL_Color BLUE;
 extern const SDL_Color YELLOW;
 
-void draw_cell(int x, int y, SDL_Color color);
-void draw_grid();
-void draw_survivors();
-void draw_drones();
-int draw_map();
-int init_sdl_window();
+void draw_grid(int width, int height);
+int draw_frame(const Frame *frame);
+int view_handle_event(const SDL_Event *event);
+int init_sdl_window(int width, int height);
 void cleanup_sdl();
 
 #endif
\ No newline at end of file
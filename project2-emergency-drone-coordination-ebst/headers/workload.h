@@ -0,0 +1,51 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "coord.h"
+
+#define MAX_PHASES 16
+#define MAX_HOTSPOTS 16
+#define MAX_WORKLOAD_THREADS 16
+
+typedef enum {
+    ARRIVAL_POISSON,   // Exponential inter-arrival times
+    ARRIVAL_BURSTY,    // Poisson bursts of burst_size survivors at once
+    ARRIVAL_CONSTANT   // Fixed interval
+} ArrivalKind;
+
+typedef struct hotspot {
+    Coord center;
+    int radius;
+    double weight;     // Relative share among hotspots
+} Hotspot;
+
+typedef struct phase {
+    double duration;       // Seconds
+    ArrivalKind arrival;
+    double rate;           // Survivors per second, summed over all threads
+    int burst_size;        // ARRIVAL_BURSTY only
+    double hotspot_share;  // Fraction of arrivals placed around hotspots
+} Phase;
+
+typedef struct scenario {
+    uint64_t seed;
+    int threads;
+    int loop;              // Restart the phase list when it runs out
+    char trace_out[256];   // Record every generated survivor here ("" = off)
+    char replay[256];      // Replay this trace instead of generating
+    int num_phases;
+    Phase phases[MAX_PHASES];
+    int num_hotspots;
+    Hotspot hotspots[MAX_HOTSPOTS];
+    double hotspot_weight;  // Sum of hotspot weights
+    int fleet_drones;      // Simulated drones to run alongside (0 = none)
+    int fleet_threads;
+} Scenario;
+
+int load_scenario(const char *path, Scenario *scenario);
+int start_workload(const char *path);
+int schedule_workload(const char *path);
+void stop_workload();
+#endif
@@ -0,0 +1,82 @@
+#include <time.h>
+#include "headers/histogram.h"
+
+#define HALF_SUB (1 << (HISTOGRAM_SUB_BITS - 1))
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_index(uint64_t value) {
+    if (value < (1ULL << HISTOGRAM_SUB_BITS)) return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HISTOGRAM_SUB_BITS + 1;
+    int index = shift * HALF_SUB + (int)(value >> shift);
+    return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+// Upper edge of a bucket, so percentiles never under-report
+static uint64_t bucket_upper(int index) {
+    if (index < (1 << HISTOGRAM_SUB_BITS)) return (uint64_t)index;
+    int shift = index / HALF_SUB - 1;
+    uint64_t sub = (uint64_t)(index - shift * HALF_SUB);
+    return ((sub + 1) << shift) - 1;
+}
+
+void histogram_record(Histogram *h, uint64_t value) {
+    __atomic_fetch_add(&h->buckets[bucket_index(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum, value, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    while (value > max &&
+           !__atomic_compare_exchange_n(&h->max, &max, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    // Last, so a reader that sees the count also sees the bucket
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELEASE);
+}
+
+// Readers may run while writers record; the result is then off by the few
+// values in flight, which is fine for monitoring
+uint64_t histogram_percentile(const Histogram *h, double percentile) {
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+            return upper < max ? upper : max;
+        }
+    }
+    return __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+}
+
+// Values recorded at or below `value`, give or take the bucket `value`
+// falls in (about 3%)
+uint64_t histogram_count_below(const Histogram *h, uint64_t value) {
+    int last = bucket_index(value);
+    uint64_t count = 0;
+    for (int i = 0; i <= last; i++) {
+        count += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+// Fold one histogram into another, e.g. per-thread ones into a total
+void histogram_merge(Histogram *into, const Histogram *from) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        uint64_t n = __atomic_load_n(&from->buckets[i], __ATOMIC_RELAXED);
+        if (n) __atomic_fetch_add(&into->buckets[i], n, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&into->sum, __atomic_load_n(&from->sum, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&from->max, __ATOMIC_RELAXED);
+    uint64_t cur = __atomic_load_n(&into->max, __ATOMIC_RELAXED);
+    while (max > cur &&
+           !__atomic_compare_exchange_n(&into->max, &cur, max, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&into->count, __atomic_load_n(&from->count, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
@@ -22,8 +22,13 @@ List *create_list(size_t datasize, int capacity) {
     printf("Allocated List structure at %p\n", (void*)list);
     memset(list, 0, sizeof(List));
 
+    // Recursive: callers lock the list to iterate it and then call add or
+    // removedata, which lock it again
     printf("Initializing mutex...\n");
-    pthread_mutex_init(&list->lock, NULL);
+    if (lock_init(&list->lock, "list", 1) != 0) {
+        free(list);
+        return NULL;
+    }
     list->datasize = datasize;
     list->nodesize = sizeof(Node);  // Node size is now just the structure size
     printf("Node size: %zu bytes\n", list->nodesize);
@@ -32,7 +37,7 @@ List *create_list(size_t datasize, int capacity) {
     list->startaddress = malloc(list->nodesize * capacity);
     if (!list->startaddress) {
         printf("Failed to allocate memory for nodes\n");
-        pthread_mutex_destroy(&list->lock);
+        lock_destroy(&list->lock);
         free(list);
         return NULL;
     }
@@ -44,9 +49,10 @@ List *create_list(size_t datasize, int capacity) {
     printf("Zeroing node memory...\n");
     memset(list->startaddress, 0, list->nodesize * capacity);
     
-    // Initialize each node's data pointer
+    // Initialize each node's data pointer (reference lists store the
+    // caller's pointer in add instead)
     printf("Initializing node data pointers...\n");
-    for (int i = 0; i < capacity; i++) {
+    for (int i = 0; i < capacity && datasize > 0; i++) {
         Node *node = (Node *)(list->startaddress + (i * list->nodesize));
         node->data = malloc(datasize);
         if (!node->data) {
@@ -57,7 +63,7 @@ List *create_list(size_t datasize, int capacity) {
                 free(prev_node->data);
             }
             free(list->startaddress);
-            pthread_mutex_destroy(&list->lock);
+            lock_destroy(&list->lock);
             free(list);
             return NULL;
         }
@@ -84,6 +90,13 @@ List *create_list(size_t datasize, int capacity) {
     return list;
 }
 
+// A list of pointers to objects owned elsewhere: add stores the pointer
+// itself, removedata matches by pointer, pop writes the pointer to *dest.
+// Several lists can then share one canonical object without copying it.
+List *create_ref_list(int capacity) {
+    return create_list(0, capacity);
+}
+
 static Node *find_memcell_fornode(List *list) {
     printf("[find_memcell_fornode] Entered.\n");
     if (!list) {
@@ -137,14 +150,14 @@ Node *add(List *list, void *data) {
         return NULL;
     }
     
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     printf("Lock acquired. Current elements: %d, capacity: %d\n", 
            list->number_of_elements, list->capacity);
     
     if (list->number_of_elements >= list->capacity) {
         printf("List is full! (elements: %d, capacity: %d)\n", 
                list->number_of_elements, list->capacity);
-        pthread_mutex_unlock(&list->lock);
+        lock_release(&list->lock);
         return NULL;
     }
 
@@ -152,14 +165,18 @@ Node *add(List *list, void *data) {
     Node *node = find_memcell_fornode(list);
     if (node == NULL) {
         printf("Failed to find memory cell\n");
-        pthread_mutex_unlock(&list->lock);
+        lock_release(&list->lock);
         return NULL;
     }
     
     printf("Memory cell found at %p\n", (void*)node);
     node->occupied = 1;
-    printf("Copying data of size %zu bytes...\n", list->datasize);
-    memcpy(node->data, data, list->datasize);
+    if (list->datasize == 0) {
+        node->data = data;
+    } else {
+        printf("Copying data of size %zu bytes...\n", list->datasize);
+        memcpy(node->data, data, list->datasize);
+    }
     
     // Initialize node pointers
     node->prev = NULL;
@@ -184,14 +201,16 @@ Node *add(List *list, void *data) {
     printf("Node added successfully. New element count: %d\n", list->number_of_elements);
     printf("List head: %p, List tail: %p\n", (void*)list->head, (void*)list->tail);
     
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
     return node;
 }
 
 int removedata(List *list, void *data) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     Node *temp = list->head;
-    while (temp != NULL && memcmp(temp->data, data, list->datasize) != 0) {
+    while (temp != NULL &&
+           (list->datasize == 0 ? temp->data != data
+                                : memcmp(temp->data, data, list->datasize) != 0)) {
         temp = temp->next;
     }
     if (temp != NULL) {
@@ -215,36 +234,40 @@ int removedata(List *list, void *data) {
             list->head = nextnode;
         }
         list->lastprocessed = temp;
-        pthread_mutex_unlock(&list->lock);
+        lock_release(&list->lock);
         return 0;
     }
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
     return 1;
 }
 
 void *pop(List *list, void *dest) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     if (list->head != NULL) {
         Node *node = list->head;
         if (removenode(list, node) == 0) {
-            memcpy(dest, node->data, list->datasize);
-            pthread_mutex_unlock(&list->lock);
+            if (list->datasize == 0) {
+                *(void **)dest = node->data;
+            } else {
+                memcpy(dest, node->data, list->datasize);
+            }
+            lock_release(&list->lock);
             return dest;
         }
     }
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
     return NULL;
 }
 
 void *peek(List *list) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     void *data = (list->head != NULL) ? list->head->data : NULL;
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
     return data;
 }
 
 int removenode(List *list, Node *node) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     if (node != NULL) {
         Node *prevnode = node->prev;
         Node *nextnode = node->next;
@@ -266,23 +289,23 @@ int removenode(List *list, Node *node) {
             list->head = nextnode;
         }
         list->lastprocessed = node;
-        pthread_mutex_unlock(&list->lock);
+        lock_release(&list->lock);
         return 0;
     }
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
     return 1;
 }
 
 void destroy(List *list) {
     if (!list) return;
     
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     printf("Destroying list...\n");
     
     // Free all node data
     for (int i = 0; i < list->capacity; i++) {
         Node *node = (Node *)(list->startaddress + (i * list->nodesize));
-        if (node->data) {
+        if (node->data && list->datasize > 0) {
             printf("Freeing node %d data at %p\n", i, node->data);
             free(node->data);
         }
@@ -298,8 +321,8 @@ void destroy(List *list) {
     list->free_list = NULL;
     list->number_of_elements = 0;
     
-    pthread_mutex_unlock(&list->lock);
-    pthread_mutex_destroy(&list->lock);
+    lock_release(&list->lock);
+    lock_destroy(&list->lock);
     
     printf("Freeing list structure at %p\n", list);
     free(list);
@@ -307,21 +330,21 @@ void destroy(List *list) {
 }
 
 void printlist(List *list, void (*print)(void *)) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     Node *temp = list->head;
     while (temp != NULL) {
         print(temp->data);
         temp = temp->next;
     }
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
 }
 
 void printlistfromtail(List *list, void (*print)(void *)) {
-    pthread_mutex_lock(&list->lock);
+    lock_acquire(&list->lock);
     Node *temp = list->tail;
     while (temp != NULL) {
         print(temp->data);
         temp = temp->prev;
     }
-    pthread_mutex_unlock(&list->lock);
+    lock_release(&list->lock);
 }
\ No newline at end of file
@@ -0,0 +1,597 @@
+// Load generator: drives thousands of simulated drones over real TCP from a
+// few epoll threads, so the server's capacity can be measured from one host.
+//
+// Usage: ./loadgen [-n drones] [-t threads] [-r updates/s per drone]
+//                  [-d seconds] [-c connects/s] [-h host] [-p port]
+//                  [-j results.json]
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/histogram.h"
+#include "headers/tour.h"
+#include "headers/bench.h"
+#include "headers/communication.h"
+
+#define MAX_WORKERS 64
+#define READ_BUFFER 4096
+#define WRITE_BUFFER 2048        // Per drone; updates are dropped when it is full
+#define MAX_EVENTS 256
+#define TICK_MS 5                // Longest a worker sleeps between timer checks
+#define MAP_WIDTH 40             // Server map size (init_map in server.c)
+#define MAP_HEIGHT 30
+#define SLA_REPORT_BUFFER 65536  // Whole SLA_REPORT for the final dispatch latency
+
+typedef enum { SIM_WAITING, SIM_CONNECTING, SIM_HANDSHAKE, SIM_RUNNING, SIM_CLOSED } SimState;
+
+typedef struct simdrone {
+    int fd;
+    int id;
+    SimState state;
+    Coord coord;
+    TourStop stops[MAX_TOUR_STOPS];
+    int num_stops;
+    int current_stop;
+    uint64_t connect_at;       // When the ramp-up lets this drone connect
+    uint64_t next_update;      // Next STATUS_UPDATE (and motion step)
+    uint64_t handshake_sent;
+    char rbuf[READ_BUFFER];
+    size_t rlen;
+    char wbuf[WRITE_BUFFER];
+    size_t wlen;
+    int want_write;            // EPOLLOUT armed
+} SimDrone;
+
+typedef struct worker {
+    int index;
+    pthread_t thread;
+    int epfd;
+    SimDrone *drones;
+    int count;
+    Histogram handshake_latency;
+    // Written by the worker, read by the reporter
+    uint64_t connected, sent, received, bytes_sent, bytes_received;
+    uint64_t assigned, completed, dropped, errors;
+} Worker;
+
+static struct {
+    int drones;
+    int threads;
+    double rate;               // Status updates per second per drone
+    int duration;              // Seconds, 0 = until interrupted
+    double connect_rate;       // New connections per second, all workers
+    const char *host;
+    int port;
+    const char *results;       // Benchmark results file, as microbench -o writes
+} config = { 1000, 4, 1.0, 30, 1000.0, "127.0.0.1", 8080, NULL };
+
+static volatile sig_atomic_t running = 1;
+static struct sockaddr_in server_addr;
+static Worker workers[MAX_WORKERS];
+static Histogram probe_latency;
+
+static void stop(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void add_stat(uint64_t *counter, uint64_t n) {
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+static uint64_t get_stat(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static void close_drone(Worker *w, SimDrone *d, int error) {
+    if (d->fd >= 0) {
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, d->fd, NULL);
+        close(d->fd);
+    }
+    if (d->state == SIM_RUNNING) __atomic_fetch_sub(&w->connected, 1, __ATOMIC_RELAXED);
+    d->fd = -1;
+    d->state = SIM_CLOSED;
+    if (error) add_stat(&w->errors, 1);
+}
+
+static void watch(Worker *w, SimDrone *d, int want_write) {
+    struct epoll_event ev = { .events = EPOLLIN | (want_write ? EPOLLOUT : 0), .data.ptr = d };
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, d->fd, &ev);
+    d->want_write = want_write;
+}
+
+// Send as much of the write buffer as the socket takes; arm EPOLLOUT for
+// the rest
+static void flush_drone(Worker *w, SimDrone *d) {
+    while (d->wlen > 0) {
+        ssize_t n = send(d->fd, d->wbuf, d->wlen, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            close_drone(w, d, 1);
+            return;
+        }
+        add_stat(&w->bytes_sent, (uint64_t)n);
+        memmove(d->wbuf, d->wbuf + n, d->wlen - (size_t)n);
+        d->wlen -= (size_t)n;
+    }
+    if ((d->wlen > 0) != d->want_write) watch(w, d, d->wlen > 0);
+}
+
+static void queue_message(Worker *w, SimDrone *d, const char *msg, int len) {
+    if (len <= 0 || d->wlen + (size_t)len > WRITE_BUFFER) {
+        add_stat(&w->dropped, 1);  // Server is not keeping up with this drone
+        return;
+    }
+    memcpy(d->wbuf + d->wlen, msg, (size_t)len);
+    d->wlen += (size_t)len;
+    add_stat(&w->sent, 1);
+}
+
+static void send_handshake(Worker *w, SimDrone *d) {
+    char msg[256];
+    int len = snprintf(msg, sizeof(msg),
+                       "{\"type\":\"HANDSHAKE\",\"drone_id\":\"D%d\",\"capabilities\":"
+                       "{\"max_speed\":30,\"battery_capacity\":1000000,\"payload\":\"\"}}\n", d->id);
+    d->state = SIM_HANDSHAKE;
+    d->handshake_sent = monotonic_ns();
+    queue_message(w, d, msg, len);
+    flush_drone(w, d);
+}
+
+static void start_connect(Worker *w, SimDrone *d) {
+    d->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (d->fd < 0) {
+        close_drone(w, d, 1);
+        return;
+    }
+    int one = 1;
+    setsockopt(d->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT, .data.ptr = d };
+    d->want_write = 1;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, d->fd, &ev) != 0) {
+        close(d->fd);
+        d->fd = -1;
+        close_drone(w, d, 1);
+        return;
+    }
+    d->state = SIM_CONNECTING;
+    if (connect(d->fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) != 0 && errno != EINPROGRESS) {
+        close_drone(w, d, 1);
+    }
+}
+
+// One simulated second: step one cell toward the current stop (diagonals
+// allowed, like drone_client), report stops reached, then send the status
+static void tick(Worker *w, SimDrone *d, uint64_t now) {
+    char msg[512];
+    int len;
+    if (d->current_stop < d->num_stops) {
+        TourStop *stop = &d->stops[d->current_stop];
+        if (d->coord.x != stop->coord.x) d->coord.x += d->coord.x < stop->coord.x ? 1 : -1;
+        if (d->coord.y != stop->coord.y) d->coord.y += d->coord.y < stop->coord.y ? 1 : -1;
+        if (d->coord.x == stop->coord.x && d->coord.y == stop->coord.y) {
+            len = snprintf(msg, sizeof(msg),
+                           "{\"type\":\"MISSION_COMPLETE\",\"drone_id\":\"D%d\",\"mission_id\":\"%s\","
+                           "\"timestamp\":%ld,\"success\":true,\"details\":\"loadgen\"}\n",
+                           d->id, stop->mission_id, (long)time(NULL));
+            queue_message(w, d, msg, len);
+            add_stat(&w->completed, 1);
+            d->current_stop++;
+        }
+    }
+    int busy = d->current_stop < d->num_stops;
+    len = snprintf(msg, sizeof(msg),
+                   "{\"type\":\"STATUS_UPDATE\",\"drone_id\":\"D%d\",\"timestamp\":%ld,"
+                   "\"location\":{\"x\":%d,\"y\":%d},\"status\":\"%s\",\"battery\":100,\"speed\":%d}\n",
+                   d->id, (long)time(NULL), d->coord.x, d->coord.y, busy ? "busy" : "idle", busy ? 5 : 0);
+    queue_message(w, d, msg, len);
+    d->next_update += (uint64_t)(1e9 / config.rate);
+    if (d->next_update < now) d->next_update = now;  // Don't burst to catch up
+}
+
+static void handle_message(Worker *w, SimDrone *d, const char *line) {
+    struct json_object *msg = json_tokener_parse(line);
+    if (!msg) {
+        add_stat(&w->errors, 1);
+        return;
+    }
+    add_stat(&w->received, 1);
+    struct json_object *field;
+    const char *type = json_object_object_get_ex(msg, "type", &field) ? json_object_get_string(field) : "";
+
+    if (strcmp(type, "HANDSHAKE_ACK") == 0 && d->state == SIM_HANDSHAKE) {
+        histogram_record(&w->handshake_latency, monotonic_ns() - d->handshake_sent);
+        d->state = SIM_RUNNING;
+        add_stat(&w->connected, 1);
+    } else if (strcmp(type, "ASSIGN_MISSION") == 0) {
+        // Recharge and reposition orders never complete; a loadgen drone
+        // has an endless battery and simply stays put for them
+        if (json_object_object_get_ex(msg, "charge", &field) ||
+            json_object_object_get_ex(msg, "reposition", &field)) {
+            json_object_put(msg);
+            return;
+        }
+        struct json_object *wps;
+        d->num_stops = 0;
+        d->current_stop = 0;
+        if (json_object_object_get_ex(msg, "waypoints", &wps)) {
+            size_t n = json_object_array_length(wps);
+            for (size_t i = 0; i < n && d->num_stops < MAX_TOUR_STOPS; i++) {
+                struct json_object *wp = json_object_array_get_idx(wps, i);
+                TourStop *stop = &d->stops[d->num_stops++];
+                stop->coord.x = json_object_get_int(json_object_object_get(wp, "x"));
+                stop->coord.y = json_object_get_int(json_object_object_get(wp, "y"));
+                snprintf(stop->mission_id, sizeof(stop->mission_id), "%s",
+                         json_object_get_string(json_object_object_get(wp, "mission_id")));
+            }
+        }
+        add_stat(&w->assigned, 1);
+    } else if (strcmp(type, "MISSION_CANCEL") == 0) {
+        int kept = d->current_stop;
+        for (int i = d->current_stop; i < d->num_stops; i++) {
+            if (!cancel_withdraws(msg, d->stops[i].mission_id)) d->stops[kept++] = d->stops[i];
+        }
+        d->num_stops = kept;
+        if (d->current_stop >= d->num_stops) d->num_stops = d->current_stop = 0;
+    }
+    json_object_put(msg);
+}
+
+static void read_drone(Worker *w, SimDrone *d) {
+    while (d->fd >= 0) {
+        ssize_t n = recv(d->fd, d->rbuf + d->rlen, READ_BUFFER - 1 - d->rlen, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close_drone(w, d, 1);
+            return;
+        }
+        if (n < 0) return;
+        add_stat(&w->bytes_received, (uint64_t)n);
+        d->rlen += (size_t)n;
+        d->rbuf[d->rlen] = '\0';
+
+        char *start = d->rbuf, *newline;
+        while ((newline = strchr(start, '\n')) != NULL) {
+            *newline = '\0';
+            handle_message(w, d, start);
+            start = newline + 1;
+        }
+        d->rlen -= (size_t)(start - d->rbuf);
+        memmove(d->rbuf, start, d->rlen);
+        if (d->rlen == READ_BUFFER - 1) {
+            close_drone(w, d, 1);  // A single message larger than the buffer
+            return;
+        }
+    }
+}
+
+static void *worker_thread(void *arg) {
+    Worker *w = (Worker *)arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (running) {
+        uint64_t now = monotonic_ns();
+        for (int i = 0; i < w->count; i++) {
+            SimDrone *d = &w->drones[i];
+            if (d->state == SIM_WAITING && d->connect_at <= now) {
+                start_connect(w, d);
+            } else if (d->state == SIM_RUNNING && d->next_update <= now) {
+                tick(w, d, now);
+                flush_drone(w, d);
+            }
+        }
+
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, TICK_MS);
+        for (int i = 0; i < n; i++) {
+            SimDrone *d = (SimDrone *)events[i].data.ptr;
+            if (d->fd < 0) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_drone(w, d, 1);
+                continue;
+            }
+            if (d->state == SIM_CONNECTING && (events[i].events & EPOLLOUT)) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(d->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0) {
+                    close_drone(w, d, 1);
+                    continue;
+                }
+                send_handshake(w, d);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) read_drone(w, d);
+            if (d->fd >= 0 && (events[i].events & EPOLLOUT)) flush_drone(w, d);
+        }
+    }
+
+    for (int i = 0; i < w->count; i++) {
+        if (w->drones[i].fd >= 0) close_drone(w, &w->drones[i], 0);
+    }
+    return NULL;
+}
+
+// Blocking connection for SLA queries, or -1
+static int query_socket() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    // Bounded so a swamped server can't stall the once-a-second report
+    struct timeval tv = { 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));  // Also bounds connect
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Round trip of an SLA_QUERY on its own blocking connection: how long a
+// request waits for the server while the simulated fleet keeps it busy
+static void probe(int *sock) {
+    if (*sock < 0) {
+        *sock = query_socket();
+        if (*sock < 0) return;
+    }
+    const char *query = "{\"type\":\"SLA_QUERY\",\"stage\":\"total\"}\n";
+    uint64_t start = monotonic_ns();
+    if (send(*sock, query, strlen(query), MSG_NOSIGNAL) < 0) {
+        close(*sock);
+        *sock = -1;
+        return;
+    }
+    char buf[READ_BUFFER];
+    while (1) {
+        ssize_t n = recv(*sock, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            close(*sock);
+            *sock = -1;
+            return;
+        }
+        if (memchr(buf, '\n', (size_t)n)) break;
+    }
+    histogram_record(&probe_latency, monotonic_ns() - start);
+}
+
+// Discovery-to-assignment percentiles of every survivor helped so far,
+// from the server's own SLA histograms. Returns 1 if the server did not
+// answer or had no samples.
+static int dispatch_latency(double *p50_ms, double *p99_ms) {
+    int sock = query_socket();
+    if (sock < 0) return 1;
+    const char *query = "{\"type\":\"SLA_QUERY\",\"stage\":\"wait\"}\n";
+    char *buf = malloc(SLA_REPORT_BUFFER);
+    size_t len = 0;
+    if (buf && send(sock, query, strlen(query), MSG_NOSIGNAL) >= 0) {
+        while (len < SLA_REPORT_BUFFER - 1) {
+            ssize_t n = recv(sock, buf + len, SLA_REPORT_BUFFER - 1 - len, 0);
+            if (n <= 0) break;
+            len += (size_t)n;
+            if (memchr(buf + len - n, '\n', (size_t)n)) break;
+        }
+    }
+    close(sock);
+    if (!buf) return 1;
+    buf[len] = '\0';
+
+    struct json_object *report = json_tokener_parse(buf);
+    free(buf);
+    struct json_object *overall, *wait, *p50, *p99;
+    int found = report && json_object_object_get_ex(report, "overall", &overall) &&
+                json_object_object_get_ex(overall, "wait", &wait) &&
+                json_object_object_get_ex(wait, "p50_ms", &p50) &&
+                json_object_object_get_ex(wait, "p99_ms", &p99);
+    if (found) {
+        *p50_ms = json_object_get_double(p50);
+        *p99_ms = json_object_get_double(p99);
+    }
+    json_object_put(report);
+    return !found;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-n drones] [-t threads] [-r updates/s per drone] [-d seconds] "
+           "[-c connects/s] [-h host] [-p port] [-j results.json]\n", prog);
+}
+
+static int parse_args(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:r:d:c:h:p:j:")) != -1) {
+        switch (opt) {
+        case 'n': config.drones = atoi(optarg); break;
+        case 't': config.threads = atoi(optarg); break;
+        case 'r': config.rate = atof(optarg); break;
+        case 'd': config.duration = atoi(optarg); break;
+        case 'c': config.connect_rate = atof(optarg); break;
+        case 'h': config.host = optarg; break;
+        case 'p': config.port = atoi(optarg); break;
+        case 'j': config.results = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (config.drones < 1 || config.threads < 1 || config.rate <= 0 || config.connect_rate <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (config.threads > MAX_WORKERS) config.threads = MAX_WORKERS;
+    if (config.threads > config.drones) config.threads = config.drones;
+    return 0;
+}
+
+static void print_latency(const char *name, const Histogram *h) {
+    if (h->count == 0) {
+        printf("  %-10s no samples\n", name);
+        return;
+    }
+    printf("  %-10s n=%llu  p50 %.2fms  p90 %.2fms  p99 %.2fms  max %.2fms\n", name,
+           (unsigned long long)h->count,
+           histogram_percentile(h, 50) / 1e6, histogram_percentile(h, 90) / 1e6,
+           histogram_percentile(h, 99) / 1e6, h->max / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    if (parse_args(argc, argv) != 0) return 1;
+
+    // Every drone is a socket; lift the descriptor limit as far as allowed
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < (rlim_t)config.drones + 16) {
+        printf("Warning: descriptor limit %llu is below %d drones\n",
+               (unsigned long long)lim.rlim_cur, config.drones);
+    }
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.host, &server_addr.sin_addr) != 1) {
+        printf("Invalid server address %s\n", config.host);
+        return 1;
+    }
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    srand((unsigned)time(NULL));
+
+    // Drones are dealt round-robin to workers and connect at connect_rate
+    uint64_t start = monotonic_ns();
+    uint64_t update_interval = (uint64_t)(1e9 / config.rate);
+    for (int t = 0; t < config.threads; t++) {
+        Worker *w = &workers[t];
+        w->index = t;
+        w->count = config.drones / config.threads + (t < config.drones % config.threads);
+        w->drones = calloc((size_t)w->count, sizeof(SimDrone));
+        w->epfd = epoll_create1(0);
+        if (!w->drones || w->epfd < 0) {
+            printf("Failed to set up worker %d\n", t);
+            return 1;
+        }
+        for (int i = 0; i < w->count; i++) {
+            SimDrone *d = &w->drones[i];
+            int global = i * config.threads + t;
+            d->fd = -1;
+            d->id = global + 1;
+            d->state = SIM_WAITING;
+            d->coord.x = rand() % MAP_WIDTH;
+            d->coord.y = rand() % MAP_HEIGHT;
+            d->connect_at = start + (uint64_t)(global * 1e9 / config.connect_rate);
+            // Spread first updates over one interval so drones don't tick in step
+            d->next_update = d->connect_at + (uint64_t)rand() % update_interval;
+        }
+    }
+    for (int t = 0; t < config.threads; t++) {
+        if (pthread_create(&workers[t].thread, NULL, worker_thread, &workers[t]) != 0) {
+            printf("Failed to start worker %d\n", t);
+            running = 0;
+            config.threads = t;
+            break;
+        }
+    }
+    printf("Load generator: %d drones on %d threads, %.2f updates/s each, target %s:%d\n",
+           config.drones, config.threads, config.rate, config.host, config.port);
+
+    int probe_sock = -1;
+    uint64_t last_sent = 0, last_received = 0, last_completed = 0;
+    uint64_t last_report = start;
+    double elapsed = 0;
+    while (running && (config.duration == 0 || elapsed < config.duration)) {
+        sleep(1);
+        probe(&probe_sock);
+        uint64_t now = monotonic_ns();
+        double interval = (now - last_report) / 1e9;
+        elapsed = (now - start) / 1e9;
+        last_report = now;
+
+        uint64_t connected = 0, sent = 0, received = 0, completed = 0, dropped = 0, errors = 0;
+        for (int t = 0; t < config.threads; t++) {
+            connected += get_stat(&workers[t].connected);
+            sent += get_stat(&workers[t].sent);
+            received += get_stat(&workers[t].received);
+            completed += get_stat(&workers[t].completed);
+            dropped += get_stat(&workers[t].dropped);
+            errors += get_stat(&workers[t].errors);
+        }
+        printf("[%5.1fs] connected %llu  sent %.0f/s  received %.0f/s  stops done %.0f/s  "
+               "dropped %llu  errors %llu  probe p99 %.2fms\n", elapsed,
+               (unsigned long long)connected, (sent - last_sent) / interval,
+               (received - last_received) / interval, (completed - last_completed) / interval,
+               (unsigned long long)dropped, (unsigned long long)errors,
+               histogram_percentile(&probe_latency, 99) / 1e6);
+        last_sent = sent;
+        last_received = received;
+        last_completed = completed;
+    }
+    running = 0;
+    if (probe_sock >= 0) close(probe_sock);
+
+    Histogram *handshake = calloc(1, sizeof(Histogram));
+    uint64_t totals[8] = {0};
+    for (int t = 0; t < config.threads; t++) {
+        Worker *w = &workers[t];
+        pthread_join(w->thread, NULL);
+        if (handshake) histogram_merge(handshake, &w->handshake_latency);
+        totals[0] += w->sent;
+        totals[1] += w->received;
+        totals[2] += w->bytes_sent;
+        totals[3] += w->bytes_received;
+        totals[4] += w->assigned;
+        totals[5] += w->completed;
+        totals[6] += w->dropped;
+        totals[7] += w->errors;
+        close(w->epfd);
+        free(w->drones);
+    }
+
+    double seconds = (monotonic_ns() - start) / 1e9;
+    printf("\n=== Load generator summary (%.1fs) ===\n", seconds);
+    printf("  messages   sent %llu (%.0f/s, %.1f MB), received %llu (%.0f/s, %.1f MB)\n",
+           (unsigned long long)totals[0], totals[0] / seconds, totals[2] / 1e6,
+           (unsigned long long)totals[1], totals[1] / seconds, totals[3] / 1e6);
+    printf("  missions   %llu assigned, %llu stops completed\n",
+           (unsigned long long)totals[4], (unsigned long long)totals[5]);
+    printf("  problems   %llu updates dropped (server not reading), %llu connection errors\n",
+           (unsigned long long)totals[6], (unsigned long long)totals[7]);
+    if (handshake) print_latency("handshake", handshake);
+    print_latency("probe", &probe_latency);
+
+    // Same schema as microbench, so microbench -c compares two runs.
+    // Everything is keyed by fleet size: throughput at 100 drones says
+    // nothing about 1000.
+    int failed = 0;
+    if (config.results) {
+        BenchReport *report = calloc(1, sizeof(BenchReport));
+        if (!report) return 1;
+        report->suite = "e2e";
+        int n = config.drones;
+        bench_add(report, "messages_sent", n, totals[0] / seconds, "msgs/s", 1);
+        bench_add(report, "messages_received", n, totals[1] / seconds, "msgs/s", 1);
+        bench_add(report, "messages_total", n, (totals[0] + totals[1]) / seconds, "msgs/s", 1);
+        bench_add(report, "stops_completed", n, totals[5] / seconds, "stops/s", 1);
+        bench_add(report, "updates_dropped", n, (double)totals[6], "msgs", 0);
+        if (handshake && handshake->count > 0) {
+            bench_add(report, "handshake_p50", n, histogram_percentile(handshake, 50) / 1e6, "ms", 0);
+            bench_add(report, "handshake_p99", n, histogram_percentile(handshake, 99) / 1e6, "ms", 0);
+        }
+        double p50, p99;
+        if (dispatch_latency(&p50, &p99) == 0) {
+            bench_add(report, "dispatch_p50", n, p50, "ms", 0);
+            bench_add(report, "dispatch_p99", n, p99, "ms", 0);
+        } else {
+            printf("No dispatch latency from the server; left out of %s\n", config.results);
+        }
+        failed = bench_write(report, config.results);
+        free(report);
+    }
+    free(handshake);
+    return failed;
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "headers/lockprof.h"
+
+int lock_profiling = 0;
+
+static LockClass classes[LOCK_CLASSES_MAX];
+static int num_classes = 0;
+static pthread_mutex_t classes_lock = PTHREAD_MUTEX_INITIALIZER;
+static LockSite *sites = NULL;   // Every profiled site, pushed on first use
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void update_max(uint64_t *max, uint64_t value) {
+    uint64_t seen = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(max, &seen, value, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void record_acquire(LockStats *stats, uint64_t wait, int contended) {
+    __atomic_fetch_add(&stats->acquisitions, 1, __ATOMIC_RELAXED);
+    if (!contended) return;
+    __atomic_fetch_add(&stats->contended, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->wait_ns, wait, __ATOMIC_RELAXED);
+    update_max(&stats->max_wait_ns, wait);
+}
+
+static void record_hold(LockStats *stats, uint64_t hold) {
+    __atomic_fetch_add(&stats->hold_ns, hold, __ATOMIC_RELAXED);
+    update_max(&stats->max_hold_ns, hold);
+}
+
+// Flipping this while threads hold locks would pair an unprofiled acquire
+// with a profiled release, so it is only called at startup
+void lock_profiling_enable() {
+    lock_profiling = 1;
+    printf("Lock profiling enabled\n");
+}
+
+// Finds or adds the class called `name`. Classes live for the whole run;
+// when the table is full the last slot collects the rest.
+LockClass *lock_class(const char *name) {
+    pthread_mutex_lock(&classes_lock);
+    LockClass *cls = NULL;
+    for (int i = 0; i < num_classes; i++) {
+        if (strcmp(classes[i].name, name) == 0) {
+            cls = &classes[i];
+            break;
+        }
+    }
+    if (!cls && num_classes < LOCK_CLASSES_MAX) {
+        cls = &classes[num_classes++];
+        cls->name = name;
+    }
+    if (!cls) cls = &classes[LOCK_CLASSES_MAX - 1];
+    pthread_mutex_unlock(&classes_lock);
+    return cls;
+}
+
+int lock_init(Lock *lock, const char *class_name, int recursive) {
+    memset(lock, 0, sizeof(Lock));
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (recursive) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    int failed = pthread_mutex_init(&lock->mutex, &attr) != 0;
+    pthread_mutexattr_destroy(&attr);
+    if (failed) {
+        printf("Failed to initialize %s lock\n", class_name);
+        return 1;
+    }
+    lock->cls = lock_class(class_name);
+    return 0;
+}
+
+// For locks created by generic code (list.c) whose owner knows better
+void lock_set_class(Lock *lock, const char *class_name) {
+    lock->cls = lock_class(class_name);
+}
+
+void lock_destroy(Lock *lock) {
+    pthread_mutex_destroy(&lock->mutex);
+}
+
+void lock_acquire_profiled(Lock *lock, LockSite *site) {
+    if (!__atomic_load_n(&site->linked, __ATOMIC_ACQUIRE) &&
+        !__atomic_exchange_n(&site->linked, 1, __ATOMIC_ACQ_REL)) {
+        site->next = __atomic_load_n(&sites, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&sites, &site->next, site, 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    // An uncontended acquire costs one trylock and no clock reads
+    uint64_t wait = 0;
+    int contended = pthread_mutex_trylock(&lock->mutex) != 0;
+    if (contended) {
+        uint64_t start = now_ns();
+        pthread_mutex_lock(&lock->mutex);
+        wait = now_ns() - start;
+    }
+    record_acquire(&site->stats, wait, contended);
+    if (lock->cls) record_acquire(&lock->cls->stats, wait, contended);
+
+    // A recursive re-entry is counted but its hold belongs to the outer one
+    if (lock->depth++ == 0) {
+        lock->holder_site = site;
+        lock->acquired_ns = now_ns();
+    }
+}
+
+void lock_release_profiled(Lock *lock) {
+    if (lock->depth > 0 && --lock->depth == 0) {
+        uint64_t hold = now_ns() - lock->acquired_ns;
+        record_hold(&lock->holder_site->stats, hold);
+        if (lock->cls) record_hold(&lock->cls->stats, hold);
+        lock->holder_site = NULL;
+    }
+    pthread_mutex_unlock(&lock->mutex);
+}
+
+typedef struct reportrow {
+    char name[96];
+    LockStats stats;
+} ReportRow;
+
+// Most total wait first: the locks threads actually queue on
+static int by_wait(const void *a, const void *b) {
+    const LockStats *x = &((const ReportRow *)a)->stats;
+    const LockStats *y = &((const ReportRow *)b)->stats;
+    if (x->wait_ns != y->wait_ns) return x->wait_ns < y->wait_ns ? 1 : -1;
+    if (x->contended != y->contended) return x->contended < y->contended ? 1 : -1;
+    return x->acquisitions < y->acquisitions ? 1 : x->acquisitions > y->acquisitions ? -1 : 0;
+}
+
+static void copy_stats(LockStats *to, const LockStats *from) {
+    to->acquisitions = __atomic_load_n(&from->acquisitions, __ATOMIC_RELAXED);
+    to->contended = __atomic_load_n(&from->contended, __ATOMIC_RELAXED);
+    to->wait_ns = __atomic_load_n(&from->wait_ns, __ATOMIC_RELAXED);
+    to->max_wait_ns = __atomic_load_n(&from->max_wait_ns, __ATOMIC_RELAXED);
+    to->hold_ns = __atomic_load_n(&from->hold_ns, __ATOMIC_RELAXED);
+    to->max_hold_ns = __atomic_load_n(&from->max_hold_ns, __ATOMIC_RELAXED);
+}
+
+static void print_rows(FILE *out, const char *title, ReportRow *rows, int count) {
+    qsort(rows, count, sizeof(ReportRow), by_wait);
+    fprintf(out, "%-44s %10s %9s %11s %10s %11s %10s\n", title, "acquired", "contended",
+            "wait ms", "max wait", "hold ms", "max hold");
+    for (int i = 0; i < count; i++) {
+        const LockStats *s = &rows[i].stats;
+        if (s->acquisitions == 0) continue;
+        fprintf(out, "%-44s %10llu %8.2f%% %11.3f %8.1fus %11.3f %8.1fus\n", rows[i].name,
+                (unsigned long long)s->acquisitions, 100.0 * s->contended / s->acquisitions,
+                s->wait_ns / 1e6, s->max_wait_ns / 1e3, s->hold_ns / 1e6, s->max_hold_ns / 1e3);
+    }
+}
+
+// Two tables, lock classes then acquisition sites, each sorted by total
+// time threads spent waiting. Safe to call while the locks are in use;
+// the numbers are a snapshot, not a consistent cut.
+void lock_report(FILE *out) {
+    if (!lock_profiling) {
+        fprintf(out, "Lock profiling is disabled\n");
+        return;
+    }
+
+    pthread_mutex_lock(&classes_lock);
+    int count = num_classes;
+    pthread_mutex_unlock(&classes_lock);
+    // Sites linked after this load are left for the next report
+    LockSite *head = __atomic_load_n(&sites, __ATOMIC_ACQUIRE);
+    int num_sites = 0;
+    for (LockSite *s = head; s; s = s->next) num_sites++;
+
+    int max_rows = count > num_sites ? count : num_sites;
+    ReportRow *rows = malloc(sizeof(ReportRow) * (max_rows > 0 ? max_rows : 1));
+    if (!rows) {
+        fprintf(out, "Failed to allocate lock report\n");
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        snprintf(rows[i].name, sizeof(rows[i].name), "%s", classes[i].name);
+        copy_stats(&rows[i].stats, &classes[i].stats);
+    }
+    fprintf(out, "=== Lock contention by class ===\n");
+    print_rows(out, "class", rows, count);
+
+    LockSite *site = head;
+    for (int i = 0; i < num_sites; i++, site = site->next) {
+        const char *file = strrchr(site->file, '/');
+        snprintf(rows[i].name, sizeof(rows[i].name), "%s:%d %s",
+                 file ? file + 1 : site->file, site->line, site->expr);
+        copy_stats(&rows[i].stats, &site->stats);
+    }
+    fprintf(out, "\n=== Lock contention by site ===\n");
+    print_rows(out, "site", rows, num_sites);
+    free(rows);
+}
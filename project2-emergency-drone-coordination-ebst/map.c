@@ -1,5 +1,6 @@
 #include "headers/map.h"
 #include "headers/list.h"
+#include "headers/charging.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -35,18 +36,22 @@ void init_map(int height, int width) {
             printf("Initializing cell [%d][%d]...\n", i, j);
             map.cells[i][j].coord.x = j;  // x is the column index
             map.cells[i][j].coord.y = i;  // y is the row index
+            map.cells[i][j].demand = 0.0;
             
             // Initialize survivors list for each cell
             printf("Creating survivors list for cell [%d][%d]...\n", i, j);
-            map.cells[i][j].survivors = create_list(sizeof(Survivor), 10);
+            map.cells[i][j].survivors = create_ref_list(10);
             if (!map.cells[i][j].survivors) {
                 perror("Failed to create survivors list for cell");
                 exit(EXIT_FAILURE);
             }
+            lock_set_class(&map.cells[i][j].survivors->lock, "map cell list");
             printf("Successfully created survivors list for cell [%d][%d] at %p\n", i, j, (void*)map.cells[i][j].survivors);
         }
     }
 
+    init_charging_stations();
+
     printf("Map initialization complete: %dx%d grid created\n", height, width);
 }
 
@@ -60,5 +65,8 @@ void freemap() {
         free(map.cells[i]);
     }
     free(map.cells);
+    free(map.stations);
+    map.stations = NULL;
+    map.num_stations = 0;
     printf("Map destroyed\n");
 }
\ No newline at end of file
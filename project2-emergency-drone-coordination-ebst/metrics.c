@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "headers/metrics.h"
+#include "headers/globals.h"
+#include "headers/mission_index.h"
+#include "headers/stream.h"
+#include "headers/archive.h"
+#include "headers/lockprof.h"
+#include "headers/trace.h"
+
+#define REQUEST_SIZE 2048
+#define SCRAPE_TIMEOUT_S 2       // A stalled scraper can't hold the listener longer
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_GAUGE_FN,   // Read when scraped, nothing to update
+    METRIC_HISTOGRAM
+} MetricKind;
+
+typedef struct metric {
+    MetricKind kind;
+    const char *name;
+    const char *help;
+    char labels[64];   // Prometheus label list without braces, "" for none
+    void *data;        // Counter, Gauge or MetricsHistogram
+    double (*read)();
+} Metric;
+
+ServerMetrics metrics;
+
+// Written only while registering, at startup; scrapes read it under the lock
+static Metric registry[METRICS_MAX];
+static int registered = 0;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static int next_shard = 0;
+
+// Histogram bucket bounds exported to Prometheus, in seconds
+static const double bucket_bounds[] = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30, 60, 300};
+#define NUM_BOUNDS (int)(sizeof(bucket_bounds) / sizeof(bucket_bounds[0]))
+
+static const char *message_types[NUM_MESSAGE_KINDS] = {
+    "HANDSHAKE", "STATUS_UPDATE", "MISSION_COMPLETE", "HEARTBEAT_RESPONSE",
+    "SLA_QUERY", "SUBSCRIBE", "RESYNC", "other"
+};
+
+// Threads take shards round-robin on first use, so up to METRICS_SHARDS
+// threads update a counter without sharing a cache line
+static int thread_shard() {
+    static __thread int shard = -1;
+    if (shard < 0) shard = __atomic_fetch_add(&next_shard, 1, __ATOMIC_RELAXED) % METRICS_SHARDS;
+    return shard;
+}
+
+static void *add_metric(MetricKind kind, const char *name, const char *help, const char *labels,
+                        size_t size, double (*read)()) {
+    pthread_mutex_lock(&registry_lock);
+    if (registered == METRICS_MAX) {
+        pthread_mutex_unlock(&registry_lock);
+        printf("Metrics registry full, %s not registered\n", name);
+        return NULL;
+    }
+    void *data = NULL;
+    if (size > 0) {
+        // Aligned so the shards land on separate cache lines
+        if (posix_memalign(&data, 64, size) != 0) {
+            pthread_mutex_unlock(&registry_lock);
+            printf("Failed to allocate metric %s\n", name);
+            return NULL;
+        }
+        memset(data, 0, size);
+    }
+    Metric *m = &registry[registered++];
+    m->kind = kind;
+    m->name = name;
+    m->help = help;
+    snprintf(m->labels, sizeof(m->labels), "%s", labels ? labels : "");
+    m->data = data;
+    m->read = read;
+    pthread_mutex_unlock(&registry_lock);
+    return data;
+}
+
+// Series of one name must be registered one after another, so the scrape
+// prints a single HELP/TYPE header for them
+Counter *metrics_counter(const char *name, const char *help, const char *labels) {
+    return add_metric(METRIC_COUNTER, name, help, labels, sizeof(Counter), NULL);
+}
+
+Gauge *metrics_gauge(const char *name, const char *help, const char *labels) {
+    return add_metric(METRIC_GAUGE, name, help, labels, sizeof(Gauge), NULL);
+}
+
+// A gauge computed at scrape time, for values the server already keeps
+// (list lengths, queue depths): free to maintain, costs only the scrape
+int metrics_gauge_fn(const char *name, const char *help, const char *labels, double (*read)()) {
+    int before = registered;
+    add_metric(METRIC_GAUGE_FN, name, help, labels, 0, read);
+    return registered == before;
+}
+
+MetricsHistogram *metrics_histogram(const char *name, const char *help, const char *labels) {
+    return add_metric(METRIC_HISTOGRAM, name, help, labels, sizeof(MetricsHistogram), NULL);
+}
+
+void counter_add(Counter *counter, int64_t n) {
+    if (!counter) return;
+    __atomic_fetch_add(&counter->shards[thread_shard()].value, n, __ATOMIC_RELAXED);
+}
+
+void gauge_add(Gauge *gauge, int64_t n) {
+    counter_add(gauge, n);
+}
+
+void metrics_observe(MetricsHistogram *histogram, uint64_t ns) {
+    if (!histogram) return;
+    histogram_record(&histogram->shards[thread_shard()], ns);
+}
+
+Counter *message_counter(const char *type) {
+    int kind = MSG_OTHER;
+    for (int i = 0; type && i < MSG_OTHER; i++) {
+        if (strcmp(type, message_types[i]) == 0) {
+            kind = i;
+            break;
+        }
+    }
+    return metrics.messages[kind];
+}
+
+static double survivors_pending() {
+    return survivors ? __atomic_load_n(&survivors->number_of_elements, __ATOMIC_RELAXED) : 0;
+}
+
+static double survivors_capacity() {
+    return survivors ? survivors->capacity : 0;
+}
+
+static double count_drones(int status) {
+    if (!drones) return 0;
+    int count = 0;
+    lock_acquire(&drones->lock);
+    for (Node *node = drones->head; node != NULL; node = node->next) {
+        if (((Drone *)node->data)->status == status) count++;
+    }
+    lock_release(&drones->lock);
+    return count;
+}
+
+static double drones_idle() { return count_drones(IDLE); }
+static double drones_on_mission() { return count_drones(ON_MISSION); }
+static double drones_charging() { return count_drones(CHARGING); }
+static double drones_disconnected() { return count_drones(DISCONNECTED); }
+
+static double missions_indexed() {
+    return (double)mission_index_count();
+}
+
+static double stream_subscribers() {
+    int count;
+    size_t bytes;
+    stream_stats(&count, &bytes);
+    return count;
+}
+
+static double stream_backlog() {
+    int count;
+    size_t bytes;
+    stream_stats(&count, &bytes);
+    return (double)bytes;
+}
+
+static double archive_rows() {
+    return archive_buffered_rows();
+}
+
+// Registers everything in `metrics` plus the scrape-time gauges. Call once
+// before the threads that record them start.
+int metrics_init() {
+    for (int i = 0; i < NUM_MESSAGE_KINDS; i++) {
+        char labels[48];
+        snprintf(labels, sizeof(labels), "type=\"%s\"", message_types[i]);
+        metrics.messages[i] = metrics_counter("drone_messages_received_total",
+                                              "Messages received from drones and viewers, by type", labels);
+    }
+    metrics.connections_accepted = metrics_counter("drone_connections_accepted_total",
+                                                   "TCP connections accepted", NULL);
+    metrics.connections = metrics_gauge("drone_connections", "Open drone and viewer connections", NULL);
+    metrics.survivors_created = metrics_counter("drone_survivors_created_total",
+                                                "Survivors added to the map", NULL);
+    metrics.stops_assigned = metrics_counter("drone_stops_assigned_total",
+                                             "Survivor stops sent to drones, reassignments included", NULL);
+    metrics.stops_completed = metrics_counter("drone_stops_completed_total",
+                                              "Survivors reported helped", NULL);
+    metrics.missions_reassigned = metrics_counter("drone_missions_reassigned_total",
+                                                  "Missions cancelled for a closer drone", NULL);
+    metrics.dispatch_latency = metrics_histogram("drone_dispatch_latency_seconds",
+                                                 "Survivor discovery to first assignment", NULL);
+    metrics.dispatch_pass = metrics_histogram("drone_dispatch_pass_seconds",
+                                              "Time spent in one AI controller pass", NULL);
+
+    int failed = metrics_gauge_fn("drone_survivors_pending", "Survivors waiting or assigned", NULL, survivors_pending)
+        | metrics_gauge_fn("drone_survivors_capacity", "Capacity of the survivor list", NULL, survivors_capacity)
+        | metrics_gauge_fn("drone_drones", "Registered drones by status", "status=\"idle\"", drones_idle)
+        | metrics_gauge_fn("drone_drones", "Registered drones by status", "status=\"on_mission\"", drones_on_mission)
+        | metrics_gauge_fn("drone_drones", "Registered drones by status", "status=\"charging\"", drones_charging)
+        | metrics_gauge_fn("drone_drones", "Registered drones by status", "status=\"disconnected\"", drones_disconnected)
+        | metrics_gauge_fn("drone_missions_indexed", "Entries in the mission index", NULL, missions_indexed)
+        | metrics_gauge_fn("drone_stream_subscribers", "Viewers subscribed to the world stream", NULL, stream_subscribers)
+        | metrics_gauge_fn("drone_stream_backlog_bytes", "Bytes queued for slow viewers", NULL, stream_backlog)
+        | metrics_gauge_fn("drone_archive_buffered_rows", "Helped survivors not yet written to the archive", NULL, archive_rows);
+
+    for (int i = 0; i < NUM_MESSAGE_KINDS; i++) {
+        if (!metrics.messages[i]) failed = 1;
+    }
+    if (failed || !metrics.connections_accepted || !metrics.connections || !metrics.survivors_created ||
+        !metrics.stops_assigned || !metrics.stops_completed || !metrics.missions_reassigned ||
+        !metrics.dispatch_latency || !metrics.dispatch_pass) {
+        printf("Failed to register metrics\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int64_t shard_sum(const Counter *counter) {
+    int64_t sum = 0;
+    for (int i = 0; i < METRICS_SHARDS; i++) {
+        sum += __atomic_load_n(&counter->shards[i].value, __ATOMIC_RELAXED);
+    }
+    return sum;
+}
+
+// name{labels,extra}, leaving out whichever part is empty
+static void print_series(FILE *out, const char *name, const char *suffix, const char *labels, const char *extra) {
+    fprintf(out, "%s%s", name, suffix);
+    if (labels[0] || extra[0]) {
+        fprintf(out, "{%s%s%s}", labels, labels[0] && extra[0] ? "," : "", extra);
+    }
+}
+
+static void render_histogram(FILE *out, const Metric *m) {
+    const MetricsHistogram *mh = (const MetricsHistogram *)m->data;
+    static Histogram total;  // Rendering holds registry_lock
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < METRICS_SHARDS; i++) {
+        histogram_merge(&total, &mh->shards[i]);
+    }
+    char le[32];
+    for (int i = 0; i < NUM_BOUNDS; i++) {
+        snprintf(le, sizeof(le), "le=\"%g\"", bucket_bounds[i]);
+        print_series(out, m->name, "_bucket", m->labels, le);
+        fprintf(out, " %llu\n", (unsigned long long)histogram_count_below(&total, (uint64_t)(bucket_bounds[i] * 1e9)));
+    }
+    print_series(out, m->name, "_bucket", m->labels, "le=\"+Inf\"");
+    fprintf(out, " %llu\n", (unsigned long long)total.count);
+    print_series(out, m->name, "_sum", m->labels, "");
+    fprintf(out, " %.9f\n", total.sum / 1e9);
+    print_series(out, m->name, "_count", m->labels, "");
+    fprintf(out, " %llu\n", (unsigned long long)total.count);
+}
+
+// Prometheus text exposition format, version 0.0.4
+void metrics_render(FILE *out) {
+    static const char *type_names[] = {"counter", "gauge", "gauge", "histogram"};
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < registered; i++) {
+        const Metric *m = &registry[i];
+        if (i == 0 || strcmp(m->name, registry[i - 1].name) != 0) {
+            fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_names[m->kind]);
+        }
+        switch (m->kind) {
+        case METRIC_COUNTER:
+        case METRIC_GAUGE:
+            print_series(out, m->name, "", m->labels, "");
+            fprintf(out, " %lld\n", (long long)shard_sum((const Counter *)m->data));
+            break;
+        case METRIC_GAUGE_FN:
+            print_series(out, m->name, "", m->labels, "");
+            fprintf(out, " %g\n", m->read());
+            break;
+        case METRIC_HISTOGRAM:
+            render_histogram(out, m);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static int send_all(int sock, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(sock, data, len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+static void respond(int sock, const char *status, const char *content_type, const char *body, size_t len) {
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                     status, content_type, len);
+    if (send_all(sock, header, n) == 0) send_all(sock, body, len);
+}
+
+// One request per connection: GET /metrics gets the exposition, GET /locks
+// the lock contention report (server run with -l), GET /trace the mission
+// trace (server run with -t), anything else an error
+static void serve_scrape(int sock) {
+    struct timeval timeout = { SCRAPE_TIMEOUT_S, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[REQUEST_SIZE];
+    size_t len = 0;
+    while (len < sizeof(request) - 1) {
+        ssize_t n = recv(sock, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n")) break;
+    }
+    request[len] = '\0';
+
+    const char *text = "text/plain; charset=utf-8";
+    if (strncmp(request, "GET ", 4) != 0) {
+        respond(sock, "405 Method Not Allowed", text, "Only GET is supported\n", 22);
+        return;
+    }
+    const char *path = request + 4;
+    size_t path_len = strcspn(path, " ?\r\n");
+    int locks = path_len == 6 && strncmp(path, "/locks", 6) == 0;
+    int trace = path_len == 6 && strncmp(path, "/trace", 6) == 0;
+    if (trace && !tracing) {
+        respond(sock, "404 Not Found", text, "Tracing is disabled, start the server with -t\n", 46);
+        return;
+    }
+    if (!locks && !trace && !(path_len == 8 && strncmp(path, "/metrics", 8) == 0) &&
+        !(path_len == 1 && path[0] == '/')) {
+        respond(sock, "404 Not Found", text, "Not found, try /metrics\n", 24);
+        return;
+    }
+
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *out = open_memstream(&body, &body_len);
+    if (!out) {
+        respond(sock, "500 Internal Server Error", text, "Out of memory\n", 14);
+        return;
+    }
+    const char *content_type = "text/plain; version=0.0.4";
+    if (locks) {
+        lock_report(out);
+        content_type = text;
+    } else if (trace) {
+        trace_write(out);
+        content_type = "application/json";
+    } else {
+        metrics_render(out);
+    }
+    fclose(out);
+    respond(sock, "200 OK", content_type, body, body_len);
+    free(body);
+}
+
+// Serves scrapes one at a time on the loopback interface. Rendering reads
+// the shards and takes a few list locks briefly; nothing on the hot path
+// waits for a scrape.
+void *metrics_server(void *arg) {
+    (void)arg;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Metrics socket creation failed");
+        return NULL;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = htons(METRICS_PORT)
+    };
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("Metrics endpoint unavailable");
+        close(fd);
+        return NULL;
+    }
+    printf("Serving metrics on http://127.0.0.1:%d/metrics\n", METRICS_PORT);
+
+    while (running) {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("Metrics accept failed");
+            break;
+        }
+        serve_scrape(client);
+        close(client);
+    }
+    close(fd);
+    return NULL;
+}
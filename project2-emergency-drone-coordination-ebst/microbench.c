@@ -0,0 +1,298 @@
+// Microbenchmarks for the server's hot paths: List operations under
+// contention, the AI's idle drone search at several fleet sizes, and
+// send_json/receive_json over a socket pair. Results can be written to a
+// JSON file, and -c compares two such files (from this tool or from
+// loadgen -j) to catch regressions between releases.
+//
+// Usage: ./microbench [-s seconds per case] [-o results.json]
+//        ./microbench -c base.json new.json [-T regression %]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "headers/globals.h"
+#include "headers/list.h"
+#include "headers/drone.h"
+#include "headers/ai.h"
+#include "headers/map.h"
+#include "headers/communication.h"
+#include "headers/histogram.h"
+#include "headers/bench.h"
+
+#define BENCH_ARCHIVE_PATH "microbench.arc"
+#define LIST_BATCH 256             // add/remove pairs between stop checks
+#define MAX_LIST_THREADS 8
+
+static const int list_threads[] = {1, 2, 4, 8};
+static const int fleet_sizes[] = {10, 100, 1000, 10000};
+
+static struct {
+    double seconds;
+    const char *output;
+    const char *compare;
+    double threshold;
+} config = {1.0, NULL, NULL, BENCH_REGRESSION_PCT};
+
+static FILE *report;               // The real stdout; the server code's log goes to /dev/null
+static BenchReport results = { .suite = "micro" };
+
+typedef struct listworker {
+    pthread_t thread;
+    List *list;
+    int pop;                       // add+pop instead of add+removenode
+    int *stop;
+    uint64_t ops;
+} ListWorker;
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-s seconds per case] [-o results.json]\n"
+           "       %s -c base.json new.json [-T regression %%]\n", prog, prog);
+}
+
+static int parse_args(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:o:c:T:")) != -1) {
+        switch (opt) {
+        case 's': config.seconds = atof(optarg); break;
+        case 'o': config.output = optarg; break;
+        case 'c': config.compare = optarg; break;
+        case 'T': config.threshold = atof(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (config.seconds <= 0 || (config.compare && optind >= argc)) {
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+static void record(const char *name, int param, double value, const char *unit, int higher_is_better) {
+    bench_add(&results, name, param, value, unit, higher_is_better);
+    fprintf(report, "  %-28s %7d %14.1f %s\n", name, param, value, unit);
+    fflush(report);
+}
+
+static void *list_worker(void *arg) {
+    ListWorker *w = (ListWorker *)arg;
+    int item;                      // Only its address is stored
+    void *popped;
+    while (!__atomic_load_n(w->stop, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < LIST_BATCH; i++) {
+            Node *node = w->list->add(w->list, &item);
+            if (w->pop) {
+                w->list->pop(w->list, &popped);
+            } else if (node) {
+                w->list->removenode(w->list, node);
+            }
+        }
+        w->ops += 2 * LIST_BATCH;
+    }
+    return NULL;
+}
+
+// Every thread adds one element and takes one off again, so the list stays
+// short and all the time goes to the shared lock and the free list
+static void bench_list(const char *name, int pop, int threads) {
+    List *list = create_ref_list(MAX_LIST_THREADS * 2);
+    if (!list) return;
+    ListWorker workers[MAX_LIST_THREADS];
+    int stop = 0;
+    uint64_t start = monotonic_ns();
+    int started = 0;
+    for (; started < threads; started++) {
+        workers[started] = (ListWorker){ .list = list, .pop = pop, .stop = &stop };
+        if (pthread_create(&workers[started].thread, NULL, list_worker, &workers[started]) != 0) {
+            printf("Failed to create list benchmark thread\n");
+            break;
+        }
+    }
+    usleep((useconds_t)(config.seconds * 1e6));
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    uint64_t ops = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ops += workers[i].ops;
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    list->destroy(list);
+    if (started == threads) record(name, threads, ops / elapsed, "ops/s", 1);
+}
+
+// Replaces the fleet with `size` idle drones spread over the map. Batteries
+// are large enough that every drone can serve every tour, so the search
+// always scans the whole list.
+static int fill_fleet(int size) {
+    Drone old;
+    while (drones->pop(drones, &old)) lock_destroy(&old.lock);
+    for (int i = 0; i < size; i++) {
+        Drone d;
+        memset(&d, 0, sizeof(d));
+        d.id = i + 1;
+        d.status = IDLE;
+        d.coord.x = rand() % map.width;
+        d.coord.y = rand() % map.height;
+        d.max_speed = 30;
+        d.battery_capacity = 1000000;
+        d.battery = 100;
+        d.station = -1;
+        d.sock = -1;
+        if (lock_init(&d.lock, "drone", 0) != 0 || !drones->add(drones, &d)) {
+            printf("Failed to add benchmark drone %d\n", i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void bench_find_closest(int size) {
+    if (fill_fleet(size) != 0) return;
+    Histogram *latency = calloc(1, sizeof(Histogram));
+    if (!latency) return;
+    Tour tour = { .count = 1 };
+    uint64_t start = monotonic_ns();
+    uint64_t deadline = start + (uint64_t)(config.seconds * 1e9);
+    uint64_t now = start;
+    while (now < deadline) {
+        tour.stops[0].coord.x = rand() % map.width;
+        tour.stops[0].coord.y = rand() % map.height;
+        uint64_t before = monotonic_ns();
+        Drone *claimed = find_closest_idle_drone(&tour);
+        now = monotonic_ns();
+        histogram_record(latency, now - before);
+        if (claimed) {
+            // Hand the drone back so every call searches the same fleet
+            lock_acquire(&claimed->lock);
+            claimed->status = IDLE;
+            lock_release(&claimed->lock);
+        }
+    }
+    double elapsed = (now - start) / 1e9;
+    record("find_closest_idle_drone", size, latency->count / elapsed, "calls/s", 1);
+    record("find_closest_idle_drone_p99", size, (double)histogram_percentile(latency, 99), "ns", 0);
+    free(latency);
+}
+
+static struct json_object *status_update() {
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string("STATUS_UPDATE"));
+    json_object_object_add(msg, "drone_id", json_object_new_string("D1"));
+    json_object_object_add(msg, "timestamp", json_object_new_int64(1704067200));
+    struct json_object *location = json_object_new_object();
+    json_object_object_add(location, "x", json_object_new_int(12));
+    json_object_object_add(location, "y", json_object_new_int(7));
+    json_object_object_add(msg, "location", location);
+    json_object_object_add(msg, "status", json_object_new_string("busy"));
+    json_object_object_add(msg, "battery", json_object_new_int(87));
+    json_object_object_add(msg, "speed", json_object_new_int(30));
+    return msg;
+}
+
+// The message assign_tour sends for a tour of `stops` survivors
+static struct json_object *mission_message(int stops) {
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string("ASSIGN_MISSION"));
+    json_object_object_add(msg, "mission_id", json_object_new_string("1782439016284161"));
+    json_object_object_add(msg, "priority", json_object_new_string("high"));
+    struct json_object *target = json_object_new_object();
+    json_object_object_add(target, "x", json_object_new_int(20));
+    json_object_object_add(target, "y", json_object_new_int(15));
+    json_object_object_add(msg, "target", target);
+    struct json_object *waypoints = json_object_new_array();
+    for (int i = 0; i < stops; i++) {
+        struct json_object *wp = json_object_new_object();
+        char id[24];
+        snprintf(id, sizeof(id), "%llu", 1782439016284161ULL + i);
+        json_object_object_add(wp, "mission_id", json_object_new_string(id));
+        json_object_object_add(wp, "x", json_object_new_int(20 + i));
+        json_object_object_add(wp, "y", json_object_new_int(15));
+        json_object_array_add(waypoints, wp);
+    }
+    json_object_object_add(msg, "waypoints", waypoints);
+    json_object_object_add(msg, "expiry", json_object_new_int64(1704070800));
+    json_object_object_add(msg, "checksum", json_object_new_string("a1b2c3"));
+    return msg;
+}
+
+// Encode, write, read and parse one message at a time through a socket
+// pair: the full cost of a message minus the network
+static void bench_json(const char *name, int param, struct json_object *msg) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        perror("Failed to create socket pair");
+        json_object_put(msg);
+        return;
+    }
+    Histogram *latency = calloc(1, sizeof(Histogram));
+    if (latency) {
+        uint64_t start = monotonic_ns();
+        uint64_t deadline = start + (uint64_t)(config.seconds * 1e9);
+        uint64_t now = start;
+        while (now < deadline) {
+            uint64_t before = monotonic_ns();
+            send_json(sv[0], msg);
+            struct json_object *received = receive_json(sv[1]);
+            now = monotonic_ns();
+            if (!received) break;
+            json_object_put(received);
+            histogram_record(latency, now - before);
+        }
+        double elapsed = (now - start) / 1e9;
+        char p99_name[48];
+        snprintf(p99_name, sizeof(p99_name), "%s_p99", name);
+        record(name, param, latency->count / elapsed, "msgs/s", 1);
+        record(p99_name, param, (double)histogram_percentile(latency, 99), "ns", 0);
+        free(latency);
+    }
+    close(sv[0]);
+    close(sv[1]);
+    json_object_put(msg);
+}
+
+int main(int argc, char *argv[]) {
+    if (parse_args(argc, argv) != 0) return 1;
+    if (config.compare) return bench_compare(config.compare, argv[optind], config.threshold);
+
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if (!report) {
+        perror("Failed to open report stream");
+        return 1;
+    }
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("Failed to silence server log");
+        return 1;
+    }
+    unlink(BENCH_ARCHIVE_PATH);
+    max_drones = fleet_sizes[sizeof(fleet_sizes) / sizeof(fleet_sizes[0]) - 1];
+    if (initialize_globals(BENCH_ARCHIVE_PATH) != 0) {
+        fprintf(report, "Failed to initialize globals\n");
+        return 1;
+    }
+    srand(1);  // Same fleets and targets on every run
+
+    fprintf(report, "Microbenchmarks, %.1fs per case\n", config.seconds);
+    for (size_t i = 0; i < sizeof(list_threads) / sizeof(list_threads[0]); i++) {
+        bench_list("list_add_remove", 0, list_threads[i]);
+    }
+    for (size_t i = 0; i < sizeof(list_threads) / sizeof(list_threads[0]); i++) {
+        bench_list("list_add_pop", 1, list_threads[i]);
+    }
+    for (size_t i = 0; i < sizeof(fleet_sizes) / sizeof(fleet_sizes[0]); i++) {
+        bench_find_closest(fleet_sizes[i]);
+    }
+    bench_json("json_status_update", 0, status_update());
+    bench_json("json_assign_mission", 1, mission_message(1));
+    bench_json("json_assign_mission", MAX_TOUR_STOPS, mission_message(MAX_TOUR_STOPS));
+
+    int failed = 0;
+    if (config.output) {
+        failed = bench_write(&results, config.output);
+        if (!failed) fprintf(report, "Results written to %s\n", config.output);
+    }
+    fclose(report);
+    cleanup_globals();
+    unlink(BENCH_ARCHIVE_PATH);
+    return failed;
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "headers/mission_index.h"
+#include "headers/trace.h"
+
+static MissionIndex index_table;
+static int index_ready = 0;
+
+// Mission IDs are sequential, so mix every bit into the slot number
+// (splitmix64 finalizer) to keep neighbouring IDs from clustering
+static uint64_t hash_id(uint64_t id) {
+    id ^= id >> 30;
+    id *= 0xBF58476D1CE4E5B9ULL;
+    id ^= id >> 27;
+    id *= 0x94D049BB133111EBULL;
+    id ^= id >> 31;
+    return id;
+}
+
+// Slot holding `id`, or -1. Caller holds the lock.
+static long find_slot(MissionIndex *t, uint64_t id) {
+    uint64_t i = hash_id(id) & t->mask;
+    while (t->slots[i].id != MISSION_ID_EMPTY) {
+        if (t->slots[i].id == id) return (long)i;
+        i = (i + 1) & t->mask;
+    }
+    return -1;
+}
+
+static void place(MissionIndex *t, const MissionEntry *entry) {
+    uint64_t i = hash_id(entry->id) & t->mask;
+    while (t->slots[i].id != MISSION_ID_EMPTY) {
+        i = (i + 1) & t->mask;
+    }
+    t->slots[i] = *entry;
+}
+
+// Double the table, keeping the load factor under one half. Caller holds
+// the write lock.
+static int grow(MissionIndex *t) {
+    uint64_t old_capacity = t->mask + 1;
+    MissionEntry *old = t->slots;
+    MissionEntry *slots = calloc(old_capacity * 2, sizeof(MissionEntry));
+    if (!slots) {
+        printf("Failed to grow mission index past %llu slots\n", (unsigned long long)old_capacity);
+        return 1;
+    }
+    t->slots = slots;
+    t->mask = old_capacity * 2 - 1;
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old[i].id != MISSION_ID_EMPTY) place(t, &old[i]);
+    }
+    free(old);
+    return 0;
+}
+
+int mission_index_init() {
+    index_table.slots = calloc(MISSION_INDEX_CAPACITY, sizeof(MissionEntry));
+    if (!index_table.slots) {
+        printf("Failed to allocate mission index\n");
+        return 1;
+    }
+    index_table.mask = MISSION_INDEX_CAPACITY - 1;
+    index_table.count = 0;
+    pthread_rwlock_init(&index_table.lock, NULL);
+    index_ready = 1;
+    return 0;
+}
+
+void mission_index_destroy() {
+    if (!index_ready) return;
+    index_ready = 0;
+    pthread_rwlock_destroy(&index_table.lock);
+    free(index_table.slots);
+    index_table.slots = NULL;
+}
+
+// Returns 0 on success, 1 if the ID is already indexed or out of memory
+int mission_index_insert(uint64_t id, Survivor *survivor) {
+    if (!index_ready || id == MISSION_ID_EMPTY) return 1;
+    MissionIndex *t = &index_table;
+    pthread_rwlock_wrlock(&t->lock);
+    if (find_slot(t, id) >= 0 ||
+        ((t->count + 1) * 2 > t->mask + 1 && grow(t) != 0)) {
+        pthread_rwlock_unlock(&t->lock);
+        return 1;
+    }
+    MissionEntry entry = { id, survivor, NULL };
+    place(t, &entry);
+    t->count++;
+    pthread_rwlock_unlock(&t->lock);
+    return 0;
+}
+
+// Record which drone flies the mission (NULL: back to waiting). The slot
+// is written under the read lock: only the entry's pointer changes, and
+// the table shape is what the lock guards.
+int mission_index_set_drone(uint64_t id, Drone *drone) {
+    if (!index_ready) return 1;
+    MissionIndex *t = &index_table;
+    pthread_rwlock_rdlock(&t->lock);
+    long slot = find_slot(t, id);
+    if (slot >= 0) {
+        __atomic_store_n(&t->slots[slot].drone, drone, __ATOMIC_RELEASE);
+    }
+    pthread_rwlock_unlock(&t->lock);
+    return slot < 0;
+}
+
+int mission_index_lookup(uint64_t id, MissionEntry *out) {
+    if (!index_ready) return 1;
+    MissionIndex *t = &index_table;
+    pthread_rwlock_rdlock(&t->lock);
+    long slot = find_slot(t, id);
+    if (slot >= 0 && out) {
+        out->id = id;
+        out->survivor = t->slots[slot].survivor;
+        out->drone = __atomic_load_n(&t->slots[slot].drone, __ATOMIC_ACQUIRE);
+    }
+    pthread_rwlock_unlock(&t->lock);
+    return slot < 0;
+}
+
+// Runs fn on the mission's entry under the read lock. A lookup hands
+// back a pointer that a MISSION_COMPLETE may recycle for another mission
+// as soon as the lock is dropped; while it is held the mission can't be
+// removed, so the survivor is still this mission's. fn may take the
+// survivor's lock but nothing that waits on the index, and touches the
+// entry's drone only atomically, as set_drone does.
+int mission_index_visit(uint64_t id, void (*fn)(MissionEntry *entry, void *arg), void *arg) {
+    if (!index_ready) return 1;
+    MissionIndex *t = &index_table;
+    pthread_rwlock_rdlock(&t->lock);
+    long slot = find_slot(t, id);
+    if (slot >= 0) fn(&t->slots[slot], arg);
+    pthread_rwlock_unlock(&t->lock);
+    return slot < 0;
+}
+
+// Removes the mission and hands back its entry. Only one caller can win
+// for a given ID, which makes a duplicate MISSION_COMPLETE harmless.
+int mission_index_remove(uint64_t id, MissionEntry *out) {
+    if (!index_ready) return 1;
+    MissionIndex *t = &index_table;
+    pthread_rwlock_wrlock(&t->lock);
+    long found = find_slot(t, id);
+    if (found < 0) {
+        pthread_rwlock_unlock(&t->lock);
+        return 1;
+    }
+    if (out) *out = t->slots[found];
+
+    // Backward-shift deletion: pull later entries of the probe run into
+    // the hole unless they already sit at or past their home slot
+    uint64_t hole = (uint64_t)found;
+    uint64_t i = hole;
+    while (1) {
+        i = (i + 1) & t->mask;
+        if (t->slots[i].id == MISSION_ID_EMPTY) break;
+        uint64_t home = hash_id(t->slots[i].id) & t->mask;
+        if (((i - home) & t->mask) >= ((i - hole) & t->mask)) {
+            t->slots[hole] = t->slots[i];
+            hole = i;
+        }
+    }
+    memset(&t->slots[hole], 0, sizeof(MissionEntry));
+    t->count--;
+    pthread_rwlock_unlock(&t->lock);
+    return 0;
+}
+
+// Missions indexed right now, for monitoring
+uint64_t mission_index_count() {
+    if (!index_ready) return 0;
+    pthread_rwlock_rdlock(&index_table.lock);
+    uint64_t count = index_table.count;
+    pthread_rwlock_unlock(&index_table.lock);
+    return count;
+}
+
+// Hands a stop back to waiting if `arg` still flies it. The drone is
+// swapped out atomically, so a stop another drone has just taken over is
+// left alone.
+static void release_stop(MissionEntry *entry, void *arg) {
+    Drone *drone = (Drone *)arg;
+    if (!__atomic_compare_exchange_n(&entry->drone, &drone, NULL, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    trace_stage_end(STAGE_FLYING, entry->id);
+    trace_stage_begin(STAGE_WAITING, entry->id);
+    lock_acquire(&entry->survivor->lock);
+    entry->survivor->status = WAITING;
+    lock_release(&entry->survivor->lock);
+}
+
+// A drone went away for good: its unfinished stops no longer have a drone
+// and their survivors wait for another one. Only the drone's own tour is
+// touched, and each stop under the index lock so a survivor completed
+// meanwhile is not reset after it was recycled. Caller holds drone->lock.
+void mission_index_forget_drone(Drone *drone) {
+    for (int i = drone->tour.count - drone->pending_stops; i < drone->tour.count; i++) {
+        mission_index_visit(drone->tour.stops[i].id, release_stop, drone);
+    }
+}
+
+// Mission IDs travel as decimal strings; JSON numbers lose precision past 2^53
+int parse_mission_id(const char *text, uint64_t *id) {
+    if (!text || *text < '0' || *text > '9') return 1;
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || value == MISSION_ID_EMPTY) return 1;
+    *id = (uint64_t)value;
+    return 0;
+}
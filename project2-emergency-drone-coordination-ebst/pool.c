@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "headers/pool.h"
+
+// Objects are handed out in slabs: a header linking the slab into
+// pool->slabs, then POOL_SLAB_OBJECTS objects. Sizes are rounded up to 16
+// bytes so every object keeps malloc's alignment.
+#define SLAB_HEADER 16
+
+static size_t round_size(size_t size) {
+    if (size < sizeof(void *)) size = sizeof(void *);
+    return (size + 15) & ~(size_t)15;
+}
+
+// Move up to `n` cached objects onto the shared free list
+static void release_objects(Pool *pool, PoolCache *cache, int n) {
+    pthread_mutex_lock(&pool->lock);
+    while (n-- > 0 && cache->count > 0) {
+        void *obj = cache->objects[--cache->count];
+        *(void **)obj = pool->free_list;
+        pool->free_list = obj;
+        pool->free_count++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Thread exit: give the cached objects back to the shared list
+static void flush_cache(void *arg) {
+    PoolCache *cache = (PoolCache *)arg;
+    release_objects(cache->pool, cache, cache->count);
+    free(cache);
+}
+
+static PoolCache *get_cache(Pool *pool) {
+    PoolCache *cache = pthread_getspecific(pool->cache_key);
+    if (!cache) {
+        cache = calloc(1, sizeof(PoolCache));
+        if (!cache) return NULL;
+        cache->pool = pool;
+        pthread_setspecific(pool->cache_key, cache);
+    }
+    return cache;
+}
+
+// Fill half the cache from the shared list, carving a new slab if that runs dry
+static int refill_cache(Pool *pool, PoolCache *cache) {
+    pthread_mutex_lock(&pool->lock);
+    if (!pool->free_list) {
+        char *slab = malloc(SLAB_HEADER + pool->objsize * POOL_SLAB_OBJECTS);
+        if (!slab) {
+            pthread_mutex_unlock(&pool->lock);
+            printf("Failed to allocate pool slab\n");
+            return 1;
+        }
+        *(void **)slab = pool->slabs;
+        pool->slabs = slab;
+        pool->slab_count++;
+        for (int i = POOL_SLAB_OBJECTS - 1; i >= 0; i--) {
+            void *obj = slab + SLAB_HEADER + i * pool->objsize;
+            if (pool->init) pool->init(obj);
+            *(void **)obj = pool->free_list;
+            pool->free_list = obj;
+            pool->free_count++;
+        }
+    }
+    while (pool->free_list && cache->count < POOL_CACHE_SIZE / 2) {
+        void *obj = pool->free_list;
+        pool->free_list = *(void **)obj;
+        pool->free_count--;
+        cache->objects[cache->count++] = obj;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int pool_init(Pool *pool, size_t objsize, void (*init)(void *obj)) {
+    memset(pool, 0, sizeof(Pool));
+    pool->objsize = round_size(objsize);
+    pool->init = init;
+    pthread_mutex_init(&pool->lock, NULL);
+    if (pthread_key_create(&pool->cache_key, flush_cache) != 0) {
+        printf("Failed to create pool cache key\n");
+        pthread_mutex_destroy(&pool->lock);
+        return 1;
+    }
+    return 0;
+}
+
+// The first word of the returned object is garbage (free-list link); the
+// rest is whatever the previous owner left, plus what `init` set up once.
+void *pool_alloc(Pool *pool) {
+    PoolCache *cache = get_cache(pool);
+    if (!cache) return NULL;
+    if (cache->count == 0 && refill_cache(pool, cache) != 0) return NULL;
+    return cache->objects[--cache->count];
+}
+
+void pool_free(Pool *pool, void *obj) {
+    if (!obj) return;
+    PoolCache *cache = get_cache(pool);
+    if (!cache) {
+        // No cache for this thread: hand it straight to the shared list
+        pthread_mutex_lock(&pool->lock);
+        *(void **)obj = pool->free_list;
+        pool->free_list = obj;
+        pool->free_count++;
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+    if (cache->count == POOL_CACHE_SIZE) {
+        release_objects(pool, cache, POOL_CACHE_SIZE / 2);
+    }
+    cache->objects[cache->count++] = obj;
+}
+
+// Frees every slab. Objects still in use become invalid, so call this only
+// at shutdown once no thread touches the pool.
+void pool_destroy(Pool *pool) {
+    PoolCache *cache = pthread_getspecific(pool->cache_key);
+    if (cache) {
+        pthread_setspecific(pool->cache_key, NULL);
+        free(cache);
+    }
+    pthread_key_delete(pool->cache_key);
+
+    pthread_mutex_lock(&pool->lock);
+    void *slab = pool->slabs;
+    while (slab) {
+        void *next = *(void **)slab;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->free_count = 0;
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_destroy(&pool->lock);
+}
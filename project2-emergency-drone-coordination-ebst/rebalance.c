@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/rebalance.h"
+#include "headers/communication.h"
+#include "headers/tour.h"
+#include "headers/globals.h"
+#include "headers/simclock.h"
+
+// Protects the demand field of every map cell
+static pthread_mutex_t demand_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void record_demand(Coord coord) {
+    pthread_mutex_lock(&demand_lock);
+    map.cells[coord.y][coord.x].demand += 1.0;
+    pthread_mutex_unlock(&demand_lock);
+}
+
+void decay_demand() {
+    pthread_mutex_lock(&demand_lock);
+    for (int i = 0; i < map.height; i++) {
+        for (int j = 0; j < map.width; j++) {
+            map.cells[i][j].demand *= DEMAND_DECAY;
+        }
+    }
+    pthread_mutex_unlock(&demand_lock);
+}
+
+// Send an idle drone towards a demand centroid. The drone stays IDLE on the
+// server side, so the AI controller can still dispatch it mid-flight.
+void assign_reposition(Drone *drone, Coord target) {
+    lock_acquire(&drone->lock);
+    if (drone->status != IDLE) {
+        // Dispatched since the rebalancing pass looked at it
+        lock_release(&drone->lock);
+        return;
+    }
+    drone->target = target;
+
+    char mission_id[25];
+    snprintf(mission_id, sizeof(mission_id), "REPOSITION-%d", drone->id);
+
+    struct json_object *mission = json_object_new_object();
+    json_object_object_add(mission, "type", json_object_new_string("ASSIGN_MISSION"));
+    json_object_object_add(mission, "mission_id", json_object_new_string(mission_id));
+    json_object_object_add(mission, "priority", json_object_new_string("low"));
+    json_object_object_add(mission, "reposition", json_object_new_boolean(1));
+
+    struct json_object *target_obj = json_object_new_object();
+    json_object_object_add(target_obj, "x", json_object_new_int(target.x));
+    json_object_object_add(target_obj, "y", json_object_new_int(target.y));
+    json_object_object_add(mission, "target", target_obj);
+    json_object_object_add(mission, "expiry", json_object_new_int64(sim_time() + REBALANCE_INTERVAL * 12));
+
+    send_json(drone->sock, mission);
+    printf("Repositioning idle drone %d from (%d,%d) to (%d,%d)\n",
+           drone->id, drone->coord.x, drone->coord.y, target.x, target.y);
+
+    json_object_put(mission);
+    lock_release(&drone->lock);
+}
+
+// Weighted k-means over the demand heatmap, one centroid per idle drone.
+// Centroids start at the drones' own positions, so centroid i stays paired
+// with drone i and a drone only moves as far as the demand pulls it.
+void rebalance_idle_drones() {
+    lock_acquire(&drones->lock);
+    int capacity = drones->number_of_elements;
+    if (capacity == 0) {
+        lock_release(&drones->lock);
+        return;
+    }
+    Drone **idle = malloc(sizeof(Drone *) * capacity);
+    Coord *position = malloc(sizeof(Coord) * capacity);
+    Coord *planned = malloc(sizeof(Coord) * capacity);
+    double *sum_x = malloc(sizeof(double) * capacity);
+    double *sum_y = malloc(sizeof(double) * capacity);
+    double *weight = malloc(sizeof(double) * capacity);
+    double *cx = malloc(sizeof(double) * capacity);
+    double *cy = malloc(sizeof(double) * capacity);
+    if (!idle || !position || !planned || !sum_x || !sum_y || !weight || !cx || !cy) {
+        printf("Failed to allocate memory for rebalancing\n");
+        lock_release(&drones->lock);
+        goto out;
+    }
+
+    int k = 0;
+    Node *node = drones->head;
+    while (node != NULL && k < capacity) {
+        Drone *d = (Drone *)node->data;
+        lock_acquire(&d->lock);
+        if (d->status == IDLE) {
+            idle[k] = d;
+            position[k] = d->coord;
+            planned[k] = d->target;
+            cx[k] = d->coord.x;
+            cy[k] = d->coord.y;
+            k++;
+        }
+        lock_release(&d->lock);
+        node = node->next;
+    }
+    lock_release(&drones->lock);
+    if (k == 0) goto out;
+
+    pthread_mutex_lock(&demand_lock);
+    for (int iter = 0; iter < KMEANS_ITERATIONS; iter++) {
+        memset(sum_x, 0, sizeof(double) * k);
+        memset(sum_y, 0, sizeof(double) * k);
+        memset(weight, 0, sizeof(double) * k);
+
+        for (int i = 0; i < map.height; i++) {
+            for (int j = 0; j < map.width; j++) {
+                double w = map.cells[i][j].demand;
+                if (w < DEMAND_EPSILON) continue;
+                int best = 0;
+                double best_dist = -1;
+                for (int c = 0; c < k; c++) {
+                    double dx = cx[c] - j, dy = cy[c] - i;
+                    double dist = dx * dx + dy * dy;
+                    if (best_dist < 0 || dist < best_dist) {
+                        best_dist = dist;
+                        best = c;
+                    }
+                }
+                sum_x[best] += w * j;
+                sum_y[best] += w * i;
+                weight[best] += w;
+            }
+        }
+
+        int moved = 0;
+        for (int c = 0; c < k; c++) {
+            if (weight[c] <= 0) continue; // No demand nearby, drone stays put
+            double nx = sum_x[c] / weight[c], ny = sum_y[c] / weight[c];
+            if ((int)(nx + 0.5) != (int)(cx[c] + 0.5) || (int)(ny + 0.5) != (int)(cy[c] + 0.5)) {
+                moved = 1;
+            }
+            cx[c] = nx;
+            cy[c] = ny;
+        }
+        if (!moved) break;
+    }
+    pthread_mutex_unlock(&demand_lock);
+
+    for (int c = 0; c < k; c++) {
+        Coord centroid = { (int)(cx[c] + 0.5), (int)(cy[c] + 0.5) };
+        if (travel_distance(position[c], centroid) < REPOSITION_MIN_DISTANCE) continue;
+        if (travel_distance(planned[c], centroid) <= 1) continue; // Already heading there
+        assign_reposition(idle[c], centroid);
+    }
+
+out:
+    free(idle);
+    free(position);
+    free(planned);
+    free(sum_x);
+    free(sum_y);
+    free(weight);
+    free(cx);
+    free(cy);
+}
+
+void *rebalancer(void *arg) {
+    (void)arg;
+    while (running) {
+        sleep(REBALANCE_INTERVAL);
+        decay_demand();
+        rebalance_idle_drones();
+    }
+    return NULL;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <json-c/json.h>
+#include "headers/frame.h"
+#include "headers/raster.h"
+
+#define CELL_SIZE 30  // As view.c at its default zoom
+#define MAX_IMAGE_WIDTH 1280
+#define MAX_IMAGE_HEIGHT 960
+
+// Offline renderer: replays a recorded world stream (the SNAPSHOT and
+// DELTA lines a viewer receives) and writes one image per tick, as fast as
+// it can draw, with no display. Progress goes to stderr because stdout may
+// be carrying frames.
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <recording.jsonl> <output_dir | -> [cell_size]\n", prog);
+    fprintf(stderr, "  output_dir  one frame_<seq>.ppm per tick\n");
+    fprintf(stderr, "  -           raw rgb24 frames on stdout\n");
+}
+
+// Largest cell size, up to the default, that keeps the image window-sized
+static int fit_cell_size(int width, int height) {
+    int cell = CELL_SIZE;
+    if (width * cell > MAX_IMAGE_WIDTH) cell = MAX_IMAGE_WIDTH / width;
+    if (height * cell > MAX_IMAGE_HEIGHT) cell = MAX_IMAGE_HEIGHT / height;
+    return cell > 0 ? cell : 1;
+}
+
+static int write_frame(Raster *raster, const Frame *frame, const char *out_dir) {
+    raster_draw_frame(raster, frame);
+    if (!out_dir) return raster_write_raw(raster, stdout);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/frame_%06llu.ppm", out_dir, (unsigned long long)frame->seq);
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    int result = raster_write_ppm(raster, file);
+    if (fclose(file) != 0) result = 1;
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *out_dir = strcmp(argv[2], "-") == 0 ? NULL : argv[2];
+    int cell_size = argc > 3 ? atoi(argv[3]) : 0;
+
+    FILE *in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    if (out_dir && mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s: %s\n", out_dir, strerror(errno));
+        return 1;
+    }
+
+    Frame frame;
+    frame_init(&frame);
+    Raster raster = {0};
+    char *line = NULL;
+    size_t capacity = 0;
+    long lines = 0, frames = 0, skipped = 0;
+    int status = 0;
+
+    while (getline(&line, &capacity, in) > 0) {
+        lines++;
+        struct json_object *msg = json_tokener_parse(line);
+        if (!msg) {
+            skipped++;
+            continue;
+        }
+        // A delta that doesn't follow on from the frame held means the
+        // recording has a gap; wait for the next snapshot
+        int result = frame_apply_json(&frame, msg);
+        json_object_put(msg);
+        if (result != 0) {
+            skipped++;
+            continue;
+        }
+
+        if (frame.width != raster.map_width || frame.height != raster.map_height) {
+            raster_free(&raster);
+            int cell = cell_size > 0 ? cell_size : fit_cell_size(frame.width, frame.height);
+            if (raster_init(&raster, frame.width, frame.height, cell) != 0) {
+                fprintf(stderr, "Failed to set up a %dx%d cell raster\n", frame.width, frame.height);
+                status = 1;
+                break;
+            }
+            fprintf(stderr, "Rendering %dx%d map at %d px per cell (%dx%d images)\n",
+                    frame.width, frame.height, cell, raster.width, raster.height);
+        }
+        if (write_frame(&raster, &frame, out_dir) != 0) {
+            fprintf(stderr, "Failed to write frame %llu\n", (unsigned long long)frame.seq);
+            status = 1;
+            break;
+        }
+        frames++;
+    }
+
+    fprintf(stderr, "Rendered %ld frames from %ld lines (%ld skipped)\n", frames, lines, skipped);
+    free(line);
+    if (in != stdin) fclose(in);
+    raster_free(&raster);
+    frame_free(&frame);
+    return status;
+}
@@ -9,129 +9,134 @@
 #include <json-c/json.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <signal.h>
+#include <time.h>
 #include "headers/globals.h"
 #include "headers/ai.h"
+#include "headers/rebalance.h"
+#include "headers/charging.h"
+#include "headers/workload.h"
 #include "headers/map.h"
 #include "headers/drone.h"
 #include "headers/survivor.h"
+#include "headers/mission_index.h"
+#include "headers/sla.h"
+#include "headers/archive.h"
+#include "headers/session.h"
+#include "headers/stream.h"
 #include "headers/communication.h"
+#include "headers/handlers.h"
+#include "headers/metrics.h"
+#include "headers/lockprof.h"
+#include "headers/trace.h"
 #include "headers/view.h"
 
 #define PORT 8080
-#define MAX_DRONES 10
 #define BUFFER_SIZE 4096
 
 void *handle_drone(void *arg);
-void process_handshake(int sock, struct json_object *jobj);
-void process_status_update(int sock, struct json_object *jobj);
-void process_mission_complete(int sock, struct json_object *jobj);
-void process_heartbeat_response(int sock, struct json_object *jobj);
-void *heartbeat_thread(void *arg);
-
-// Global mutex for initialization
-pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
-int initialized = 0;
-
-int initialize_globals() {
-    pthread_mutex_lock(&init_mutex);
-    if (initialized) {
-        printf("Globals already initialized\n");
-        pthread_mutex_unlock(&init_mutex);
-        return 0;
-    }
 
-    printf("Initializing lists...\n");
-    printf("Creating survivors list with capacity 1000...\n");
-    survivors = create_list(sizeof(Survivor), 1000);
-    if (!survivors) {
-        printf("Failed to create survivors list\n");
-        pthread_mutex_unlock(&init_mutex);
-        return 1;
-    }
-    printf("Survivors list created successfully at %p\n", (void*)survivors);
-
-    printf("Creating helped survivors list with capacity 1000...\n");
-    helpedsurvivors = create_list(sizeof(Survivor), 1000);
-    if (!helpedsurvivors) {
-        printf("Failed to create helped survivors list\n");
-        survivors->destroy(survivors);
-        pthread_mutex_unlock(&init_mutex);
-        return 1;
-    }
-    printf("Helped survivors list created successfully at %p\n", (void*)helpedsurvivors);
-
-    printf("Creating drones list with capacity %d...\n", MAX_DRONES);
-    drones = create_list(sizeof(Drone), MAX_DRONES);
-    if (!drones) {
-        printf("Failed to create drones list\n");
-        survivors->destroy(survivors);
-        helpedsurvivors->destroy(helpedsurvivors);
-        pthread_mutex_unlock(&init_mutex);
-        return 1;
+// Add test survivors at fixed positions for debugging
+static void add_test_survivors() {
+    printf("Adding test survivors...\n");
+    
+    // Add survivors in each corner and center
+    Coord spots[5] = {
+        {1, 1},
+        {map.width - 2, 1},
+        {1, map.height - 2},
+        {map.width - 2, map.height - 2},
+        {map.width / 2, map.height / 2}
+    };
+    // Indexed and listed like generated ones, or MISSION_COMPLETE can't find them
+    for (int i = 0; i < 5; i++) {
+        char info[25];
+        snprintf(info, sizeof(info), "M%d", i + 1);
+        if (spawn_survivor(spots[i], info, "") != 0) {
+            printf("Failed to add test survivor %s\n", info);
+            continue;
+        }
+        printf("Added test survivor at (%d,%d) with ID %s\n", spots[i].x, spots[i].y, info);
     }
-    printf("Drones list created successfully at %p\n", (void*)drones);
 
-    printf("Initializing map...\n");
-    init_map(30, 40);  // height = 30, width = 40
-    printf("Map initialized with dimensions: %dx%d\n", map.width, map.height);
-
-    initialized = 1;
-    printf("All globals initialized successfully\n");
-    pthread_mutex_unlock(&init_mutex);
-    return 0;
+    printf("Finished adding test survivors\n");
 }
 
-void cleanup_globals() {
-    pthread_mutex_lock(&init_mutex);
-    if (!initialized) {
-        pthread_mutex_unlock(&init_mutex);
-        return;
-    }
-
-    if (survivors) {
-        survivors->destroy(survivors);
-        survivors = NULL;
-    }
-    if (helpedsurvivors) {
-        helpedsurvivors->destroy(helpedsurvivors);
-        helpedsurvivors = NULL;
-    }
-    if (drones) {
-        drones->destroy(drones);
-        drones = NULL;
+// Usage: ./server [-n max drones] [-l] [-t trace.json] [scenario.json]
+//   -n  drone slots to preallocate (default 64); raise it for loadgen runs
+//   -l  profile List, Drone and Survivor locks; the report is served at
+//       /locks on the metrics port and printed on exit
+//   -t  trace missions; the trace is served at /trace on the metrics port
+//       and written to the file on exit
+int main(int argc, char *argv[]) {
+    // A drone dropping mid-send must not take the server down with it
+    signal(SIGPIPE, SIG_IGN);
+
+    const char *trace_path = NULL;
+    int flag;
+    while ((flag = getopt(argc, argv, "n:lt:")) != -1) {
+        switch (flag) {
+        case 'n':
+            max_drones = atoi(optarg);
+            if (max_drones < 1 || max_drones > MAX_DRONES) {
+                printf("Max drones must be between 1 and %d\n", MAX_DRONES);
+                return 1;
+            }
+            break;
+        case 'l': lock_profiling_enable(); break;
+        case 't':
+            trace_path = optarg;
+            trace_enable();
+            break;
+        default:
+            printf("Usage: %s [-n max drones] [-l] [-t trace.json] [scenario.json]\n", argv[0]);
+            return 1;
+        }
     }
-    freemap();
-    initialized = 0;
-    pthread_mutex_unlock(&init_mutex);
-}
 
-int main() {
-    if (initialize_globals() != 0) {
+    if (initialize_globals(ARCHIVE_PATH) != 0) {
         printf("Failed to initialize globals\n");
         return 1;
     }
+    if (metrics_init() != 0) {
+        cleanup_globals();
+        return 1;
+    }
 
     // Initialize SDL and create window
-    if (init_sdl_window() != 0) {
+    if (init_sdl_window(map.width, map.height) != 0) {
         printf("Failed to initialize SDL window\n");
         cleanup_globals();
         return 1;
     }
 
+    // Add test survivors
+    add_test_survivors();
+
     // Initialize drones
     initialize_drones();
 
     // Set running flag before creating threads
     running = 1;
 
-    // Create survivor generator thread
-    pthread_t survivor_thread;
-    if (pthread_create(&survivor_thread, NULL, survivor_generator, NULL) != 0) {
-        printf("Failed to create survivor generator thread\n");
-        cleanup_globals();
-        return 1;
+    // Survivors come from a scenario file if one is given, otherwise from
+    // the default random generator
+    const char *scenario_path = optind < argc ? argv[optind] : NULL;
+    if (scenario_path) {
+        if (start_workload(scenario_path) != 0) {
+            printf("Failed to start workload from %s\n", scenario_path);
+            cleanup_globals();
+            return 1;
+        }
+    } else {
+        pthread_t survivor_thread;
+        if (pthread_create(&survivor_thread, NULL, survivor_generator, NULL) != 0) {
+            printf("Failed to create survivor generator thread\n");
+            cleanup_globals();
+            return 1;
+        }
+        printf("Survivor generator thread created\n");
     }
-    printf("Survivor generator thread created\n");
 
     // Create AI controller thread
     pthread_t ai_thread;
@@ -142,6 +147,51 @@ int main() {
     }
     printf("AI controller thread created\n");
 
+    // Create rebalancer thread
+    pthread_t rebalance_thread;
+    if (pthread_create(&rebalance_thread, NULL, rebalancer, NULL) != 0) {
+        printf("Failed to create rebalancer thread\n");
+        cleanup_globals();
+        return 1;
+    }
+    printf("Rebalancer thread created\n");
+
+    // Create charging scheduler thread
+    pthread_t charging_thread;
+    if (pthread_create(&charging_thread, NULL, charging_scheduler, NULL) != 0) {
+        printf("Failed to create charging scheduler thread\n");
+        cleanup_globals();
+        return 1;
+    }
+    printf("Charging scheduler thread created\n");
+
+    // Create session reaper thread
+    pthread_t session_thread;
+    if (pthread_create(&session_thread, NULL, session_reaper, NULL) != 0) {
+        printf("Failed to create session reaper thread\n");
+        cleanup_globals();
+        return 1;
+    }
+    printf("Session reaper thread created\n");
+
+    // Create viewer stream publisher thread
+    pthread_t stream_thread;
+    if (pthread_create(&stream_thread, NULL, stream_publisher, NULL) != 0) {
+        printf("Failed to create stream publisher thread\n");
+        cleanup_globals();
+        return 1;
+    }
+    printf("Stream publisher thread created\n");
+
+    // Create metrics endpoint thread
+    pthread_t metrics_thread;
+    if (pthread_create(&metrics_thread, NULL, metrics_server, NULL) != 0) {
+        printf("Failed to create metrics endpoint thread\n");
+        cleanup_globals();
+        return 1;
+    }
+    printf("Metrics endpoint thread created\n");
+
     // Create server socket
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
@@ -170,13 +220,17 @@ int main() {
     }
 
     // Listen for connections
-    if (listen(server_fd, MAX_DRONES) < 0) {
+    if (listen(server_fd, SOMAXCONN) < 0) {
         perror("Listen failed");
         close(server_fd);
         cleanup_globals();
         return 1;
     }
 
+    // The UI loop polls for connections between frames, so accept must not
+    // block or zooming and panning would stall until the next drone connects
+    fcntl(server_fd, F_SETFL, fcntl(server_fd, F_GETFL, 0) | O_NONBLOCK);
+
     printf("Server listening on port %d\n", PORT);
 
     // Main event loop
@@ -194,6 +248,7 @@ int main() {
                 running = 0;
                 break;
             }
+            view_handle_event(&event);
         }
 
         // Update display at target FPS
@@ -212,6 +267,10 @@ int main() {
         socklen_t addr_len = sizeof(client_addr);
         int drone_fd = accept(server_fd, (struct sockaddr*)&client_addr, &addr_len);
         if (drone_fd >= 0) {
+            counter_add(metrics.connections_accepted, 1);
+            gauge_add(metrics.connections, 1);
+            // Some platforms hand the listener's O_NONBLOCK on to the new socket
+            fcntl(drone_fd, F_SETFL, fcntl(drone_fd, F_GETFL, 0) & ~O_NONBLOCK);
             printf("Accepted connection from %s:%d\n", 
                    inet_ntoa(client_addr.sin_addr), 
                    ntohs(client_addr.sin_port));
@@ -227,8 +286,14 @@ int main() {
 
     // Cleanup and exit
     printf("Cleaning up...\n");
+    if (scenario_path) {
+        stop_workload();
+    }
     close(server_fd);
     cleanup_sdl();
+    sla_dump(stdout);
+    if (lock_profiling) lock_report(stdout);
+    if (trace_path) trace_save(trace_path);
     cleanup_globals();
     return 0;
 }
@@ -236,30 +301,35 @@ int main() {
 void *handle_drone(void *arg) {
     int sock = *(int*)arg;
     free(arg);
+    trace_thread_name("drone handler");
 
     while (1) {
         struct json_object *jobj = receive_json(sock);
         if (!jobj) {
             printf("No data received or client disconnected on sock %d\n", sock);
-            pthread_mutex_lock(&drones->lock);
+            lock_acquire(&drones->lock);
             Node *node = drones->head;
             while (node != NULL) {
                 Drone *d = (Drone *)node->data;
                 if (d->sock == sock) {
-                    pthread_mutex_lock(&d->lock);
-                    d->status = DISCONNECTED;
-                    pthread_mutex_unlock(&d->lock);
+                    // Mission and station are held until the session expires
+                    lock_acquire(&d->lock);
+                    session_detach(d);
+                    lock_release(&d->lock);
                     break;
                 }
                 node = node->next;
             }
-            pthread_mutex_unlock(&drones->lock);
+            lock_release(&drones->lock);
+            stream_unsubscribe(sock);
             close(sock);
+            gauge_add(metrics.connections, -1);
             break;
         }
 
         const char *type = json_object_get_string(json_object_object_get(jobj, "type"));
         printf("Received message on sock %d: type=%s\n", sock, type ? type : "NULL");
+        counter_add(message_counter(type), 1);
         if (!type) {
             struct json_object *error = json_object_new_object();
             json_object_object_add(error, "type", json_object_new_string("ERROR"));
@@ -275,6 +345,12 @@ void *handle_drone(void *arg) {
             process_mission_complete(sock, jobj);
         } else if (strcmp(type, "HEARTBEAT_RESPONSE") == 0) {
             process_heartbeat_response(sock, jobj);
+        } else if (strcmp(type, "SLA_QUERY") == 0) {
+            process_sla_query(sock, jobj);
+        } else if (strcmp(type, "SUBSCRIBE") == 0) {
+            process_subscribe(sock);
+        } else if (strcmp(type, "RESYNC") == 0) {
+            stream_resync(sock);
         } else {
             struct json_object *error = json_object_new_object();
             json_object_object_add(error, "type", json_object_new_string("ERROR"));
@@ -288,168 +364,3 @@ void *handle_drone(void *arg) {
     }
     return NULL;
 }
-
-void process_handshake(int sock, struct json_object *jobj) {
-    const char *drone_id = json_object_get_string(json_object_object_get(jobj, "drone_id"));
-    printf("Processing HANDSHAKE for drone_id=%s\n", drone_id);
-    
-    if (!drones) {
-        printf("Error: drones list is NULL\n");
-        struct json_object *error = json_object_new_object();
-        json_object_object_add(error, "type", json_object_new_string("ERROR"));
-        json_object_object_add(error, "code", json_object_new_int(500));
-        json_object_object_add(error, "message", json_object_new_string("Internal server error: drones list not initialized"));
-        send_json(sock, error);
-        json_object_put(error);
-        return;
-    }
-    
-    printf("Allocating memory for drone...\n");
-    Drone *drone = malloc(sizeof(Drone));
-    if (!drone) {
-        printf("Failed to allocate memory for drone\n");
-        struct json_object *error = json_object_new_object();
-        json_object_object_add(error, "type", json_object_new_string("ERROR"));
-        json_object_object_add(error, "code", json_object_new_int(500));
-        json_object_object_add(error, "message", json_object_new_string("Internal server error"));
-        send_json(sock, error);
-        json_object_put(error);
-        return;
-    }
-    printf("Memory allocated successfully\n");
-
-    printf("Initializing drone data...\n");
-    memset(drone, 0, sizeof(Drone));
-    drone->id = atoi(drone_id + 1); // Extract number from "D1"
-    drone->status = IDLE;
-    drone->sock = sock;
-    
-    // Initialize random starting position
-    drone->coord.x = rand() % map.width;
-    drone->coord.y = rand() % map.height;
-    drone->target = drone->coord;  // Initially target is same as current position
-    
-    pthread_mutex_init(&drone->lock, NULL);
-
-    printf("Adding drone to list...\n");
-    printf("Entering add function...\n");
-    drones->add(drones, drone);
-    printf("Drone added to list with ID %d at position (%d,%d)\n", 
-           drone->id, drone->coord.x, drone->coord.y);
-
-    // Send HANDSHAKE_ACK response
-    struct json_object *ack = json_object_new_object();
-    json_object_object_add(ack, "type", json_object_new_string("HANDSHAKE_ACK"));
-    json_object_object_add(ack, "session_id", json_object_new_string(drone_id));
-    
-    struct json_object *config = json_object_new_object();
-    json_object_object_add(config, "status_update_interval", json_object_new_int(5));
-    json_object_object_add(config, "heartbeat_interval", json_object_new_int(10));
-    json_object_object_add(ack, "config", config);
-    
-    send_json(sock, ack);
-    printf("Sent HANDSHAKE_ACK to drone %s\n", drone_id);
-    json_object_put(ack);
-}
-
-void process_status_update(int sock, struct json_object *jobj) {
-    struct json_object *loc = json_object_object_get(jobj, "location");
-    int x = json_object_get_int(json_object_object_get(loc, "x"));
-    int y = json_object_get_int(json_object_object_get(loc, "y"));
-    const char *status_str = json_object_get_string(json_object_object_get(jobj, "status"));
-    printf("Processing STATUS_UPDATE: x=%d, y=%d, status=%s\n", x, y, status_str);
-
-    pthread_mutex_lock(&drones->lock);
-    Node *node = drones->head;
-    while (node != NULL) {
-        Drone *d = (Drone *)node->data;
-        if (d->sock == sock) {
-            pthread_mutex_lock(&d->lock);
-            d->coord.x = x;
-            d->coord.y = y;
-            if (strcmp(status_str, "idle") == 0) d->status = IDLE;
-            else if (strcmp(status_str, "busy") == 0) d->status = ON_MISSION;
-            d->last_update = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
-            pthread_mutex_unlock(&d->lock);
-            break;
-        }
-        node = node->next;
-    }
-    pthread_mutex_unlock(&drones->lock);
-}
-
-void process_mission_complete(int sock, struct json_object *jobj) {
-    const char *mission_id = json_object_get_string(json_object_object_get(jobj, "mission_id"));
-    printf("Processing MISSION_COMPLETE: mission_id=%s\n", mission_id);
-
-    pthread_mutex_lock(&drones->lock);
-    Node *node = drones->head;
-    while (node != NULL) {
-        Drone *d = (Drone *)node->data;
-        if (d->sock == sock) {
-            pthread_mutex_lock(&d->lock);
-            d->status = IDLE;
-            pthread_mutex_unlock(&d->lock);
-            break;
-        }
-        node = node->next;
-    }
-    pthread_mutex_unlock(&drones->lock);
-
-    pthread_mutex_lock(&survivors->lock);
-    Node *snode = survivors->head;
-    while (snode != NULL) {
-        Survivor *s = (Survivor *)snode->data;
-        if (strcmp(s->info, mission_id) == 0) {
-            s->status = 1;
-            s->helped_time = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
-            pthread_mutex_lock(&helpedsurvivors->lock);
-            helpedsurvivors->add(helpedsurvivors, s);
-            pthread_mutex_unlock(&helpedsurvivors->lock);
-            survivors->removedata(survivors, s);
-            survivor_cleanup(s);
-            break;
-        }
-        snode = snode->next;
-    }
-    pthread_mutex_unlock(&survivors->lock);
-}
-
-void process_heartbeat_response(int sock, struct json_object *jobj) {
-    printf("Processing HEARTBEAT_RESPONSE\n");
-    pthread_mutex_lock(&drones->lock);
-    Node *node = drones->head;
-    while (node != NULL) {
-        Drone *d = (Drone *)node->data;
-        if (d->sock == sock) {
-            pthread_mutex_lock(&d->lock);
-            d->last_update = *localtime(&(time_t){json_object_get_int64(json_object_object_get(jobj, "timestamp"))});
-            pthread_mutex_unlock(&d->lock);
-            break;
-        }
-        node = node->next;
-    }
-    pthread_mutex_unlock(&drones->lock);
-}
-
-void *heartbeat_thread(void *arg) {
-    while (1) {
-        sleep(10); // Send heartbeat every 10 seconds
-        pthread_mutex_lock(&drones->lock);
-        Node *node = drones->head;
-        while (node != NULL) {
-            Drone *d = (Drone *)node->data;
-            if (d->status != DISCONNECTED) {
-                struct json_object *heartbeat = json_object_new_object();
-                json_object_object_add(heartbeat, "type", json_object_new_string("HEARTBEAT"));
-                json_object_object_add(heartbeat, "timestamp", json_object_new_int64(time(NULL)));
-                send_json(d->sock, heartbeat);
-                printf("Sent HEARTBEAT to drone D%d\n", d->id);
-                json_object_put(heartbeat);
-            }
-            node = node->next;
-        }
-        pthread_mutex_unlock(&drones->lock);
-    }
-    return NULL;
-}
\ No newline at end of file
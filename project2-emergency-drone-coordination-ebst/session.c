@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "headers/session.h"
+#include "headers/globals.h"
+#include "headers/charging.h"
+#include "headers/mission_index.h"
+#include "headers/simclock.h"
+
+// Tokens only need to be unguessable enough that one drone can't pick up
+// another's session by accident; /dev/urandom when available. A simulated
+// run draws them from its seed so it can be repeated.
+uint64_t new_session_token() {
+    uint64_t token = 0;
+    int fd = sim_is_virtual() ? -1 : open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        if (read(fd, &token, sizeof(token)) != sizeof(token)) token = 0;
+        close(fd);
+    }
+    while (token == 0) {
+        token = sim_random();
+    }
+    return token;
+}
+
+// Tokens travel as 16 hex digits
+void format_session_token(uint64_t token, char *buf, size_t size) {
+    snprintf(buf, size, "%016llx", (unsigned long long)token);
+}
+
+int parse_session_token(const char *text, uint64_t *token) {
+    if (!text || !*text) return 1;
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 16);
+    if (errno != 0 || *end != '\0' || value == 0) return 1;
+    *token = (uint64_t)value;
+    return 0;
+}
+
+// Re-attach a dropped drone to a new socket. Its tour, charging station and
+// mission index entries were kept while it was away, so nothing is
+// re-dispatched. NULL if the token is unknown or the session has expired.
+Drone *session_resume(uint64_t token, int sock) {
+    Drone *resumed = NULL;
+    lock_acquire(&drones->lock);
+    for (Node *node = drones->head; node != NULL; node = node->next) {
+        Drone *d = (Drone *)node->data;
+        lock_acquire(&d->lock);
+        if (d->session_token == token) {
+            // The drone may notice a dead link before we do; the old
+            // connection's thread then finds no drone on its socket and exits
+            if (d->sock >= 0 && d->sock != sock) shutdown(d->sock, SHUT_RDWR);
+            d->sock = sock;
+            d->disconnected_at = 0;
+            if (d->station >= 0) d->status = CHARGING;
+            else d->status = d->pending_stops > 0 ? ON_MISSION : IDLE;
+            resumed = d;
+        }
+        lock_release(&d->lock);
+        if (resumed) break;
+    }
+    lock_release(&drones->lock);
+    return resumed;
+}
+
+// The drone's link dropped: keep everything for SESSION_RESUME_TIMEOUT
+// seconds in case it comes back. Caller holds drone->lock.
+void session_detach(Drone *drone) {
+    drone->status = DISCONNECTED;
+    drone->sock = -1;
+    drone->disconnected_at = sim_time();
+}
+
+// The drone is not coming back: free its station and hand its unfinished
+// stops back to the AI controller. Caller holds drone->lock.
+void session_expire(Drone *drone) {
+    if (drone->station >= 0) {
+        release_station(drone->station);
+        drone->station = -1;
+    }
+    mission_index_forget_drone(drone);
+    drone->pending_stops = 0;
+    drone->session_token = 0;
+    drone->disconnected_at = 0;
+}
+
+// Expired drones leave the list, so their slots go to the next drones that
+// register. Viewers key drones by slot and upsert whole rows, so a slot
+// that changes hands is just an update.
+void session_reap_pass() {
+    time_t now = sim_time();
+    lock_acquire(&drones->lock);
+    Node *node = drones->head;
+    while (node != NULL) {
+        Node *next = node->next;
+        Drone *d = (Drone *)node->data;
+        lock_acquire(&d->lock);
+        int expired = d->status == DISCONNECTED && d->session_token != 0 &&
+                      now - d->disconnected_at >= SESSION_RESUME_TIMEOUT;
+        if (expired) {
+            printf("Session of drone %d expired, releasing %d stop(s)\n", d->id, d->pending_stops);
+            session_expire(d);
+        }
+        lock_release(&d->lock);
+        if (expired) {
+            lock_destroy(&d->lock);
+            drones->removenode(drones, node);
+        }
+        node = next;
+    }
+    lock_release(&drones->lock);
+}
+
+void *session_reaper(void *arg) {
+    (void)arg;
+    while (running) {
+        sleep(SESSION_REAP_INTERVAL);
+        session_reap_pass();
+    }
+    return NULL;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "headers/simclock.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+typedef struct simevent {
+    uint64_t time;   // Virtual ns
+    uint64_t seq;    // Scheduling order, breaks ties between equal times
+    SimEventFn fn;
+    void *arg;
+} SimEvent;
+
+static int virtual_time = 0;
+// Virtual time starts at one second: a zero stamp means "not reached yet"
+// in survivor lifecycle fields
+static uint64_t virtual_now = NS_PER_SEC;
+static uint64_t rng_state = 0;
+
+static SimEvent *heap = NULL;
+static int heap_size = 0, heap_capacity = 0;
+static uint64_t next_seq = 0;
+
+// Switch to virtual time before any server logic runs. Everything then runs
+// on the thread calling sim_run(); nothing else may touch the clock.
+void sim_use_virtual_time(uint64_t seed) {
+    virtual_time = 1;
+    virtual_now = NS_PER_SEC;
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    if (rng_state == 0) rng_state = 1;
+}
+
+int sim_is_virtual() {
+    return virtual_time;
+}
+
+// CLOCK_MONOTONIC nanoseconds, or virtual ones
+uint64_t sim_now_ns() {
+    if (virtual_time) return virtual_now;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// Wall-clock seconds, for message timestamps and struct tm fields
+time_t sim_time() {
+    if (virtual_time) return SIM_EPOCH + (time_t)(virtual_now / NS_PER_SEC);
+    return time(NULL);
+}
+
+int64_t sim_wall_ms() {
+    if (virtual_time) return (int64_t)SIM_EPOCH * 1000 + (int64_t)(virtual_now / 1000000);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// xorshift64*. Threads share one state, advanced with a compare-and-swap
+// so no draw is lost or repeated; in virtual time there is only one thread
+// and the sequence follows from the seed.
+uint64_t sim_random() {
+    uint64_t old = __atomic_load_n(&rng_state, __ATOMIC_RELAXED), x;
+    do {
+        if (old == 0) {
+            // Wall-clock mode: seed on first use
+            x = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ULL ^ (uint64_t)getpid();
+            if (x == 0) x = 1;
+        } else {
+            x = old;
+        }
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+    } while (!__atomic_compare_exchange_n(&rng_state, &old, x, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform in [0, n)
+int sim_random_below(int n) {
+    if (n <= 1) return 0;
+    return (int)((sim_random() >> 11) % (uint64_t)n);
+}
+
+static int earlier(const SimEvent *a, const SimEvent *b) {
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+// Run fn(arg) delay_ns of virtual time from now. Events at the same time
+// run in the order they were scheduled.
+int sim_schedule(uint64_t delay_ns, SimEventFn fn, void *arg) {
+    if (heap_size == heap_capacity) {
+        int capacity = heap_capacity ? heap_capacity * 2 : 1024;
+        SimEvent *grown = realloc(heap, capacity * sizeof(SimEvent));
+        if (!grown) {
+            printf("Failed to grow the event queue\n");
+            return 1;
+        }
+        heap = grown;
+        heap_capacity = capacity;
+    }
+    SimEvent event = { virtual_now + delay_ns, next_seq++, fn, arg };
+    int i = heap_size++;
+    while (i > 0 && earlier(&event, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = event;
+    return 0;
+}
+
+static SimEvent pop_event() {
+    SimEvent top = heap[0];
+    SimEvent last = heap[--heap_size];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= heap_size) break;
+        if (child + 1 < heap_size && earlier(&heap[child + 1], &heap[child])) child++;
+        if (!earlier(&heap[child], &last)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heap_size > 0) heap[i] = last;
+    return top;
+}
+
+// Run events in time order until the queue is empty or the next one is
+// later than until_ns. The clock jumps straight from one event to the
+// next. Returns the number of events run.
+uint64_t sim_run(uint64_t until_ns) {
+    uint64_t events = 0;
+    while (heap_size > 0 && heap[0].time <= until_ns) {
+        SimEvent event = pop_event();
+        virtual_now = event.time;
+        event.fn(event.arg);
+        events++;
+    }
+    if (virtual_now < until_ns) virtual_now = until_ns;
+    return events;
+}
@@ -0,0 +1,490 @@
+// Discrete-event simulation: runs the server's dispatch, completion,
+// charging, rebalancing and heartbeat logic against in-process drones on a
+// virtual clock, so hours of incident time take seconds. The same seed and
+// scenario always give the same run; the digest at the end covers every
+// message exchanged, so two runs can be compared at a glance.
+//
+// Usage: ./simulate [-n drones] [-H hours] [-s seed] [-o archive] [-v] [-l]
+//                   [-t trace.json] [scenario.json]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <json-c/json.h>
+#include "headers/globals.h"
+#include "headers/simclock.h"
+#include "headers/handlers.h"
+#include "headers/communication.h"
+#include "headers/ai.h"
+#include "headers/rebalance.h"
+#include "headers/charging.h"
+#include "headers/session.h"
+#include "headers/workload.h"
+#include "headers/sla.h"
+#include "headers/lockprof.h"
+#include "headers/trace.h"
+
+#define NS_PER_SEC 1000000000ULL
+#define SIM_ARCHIVE_PATH "simulated_survivors.arc"
+#define SIM_MAX_SPEED 30          // m/s, as drone_client advertises by default
+#define BATTERY_CAPACITY 100
+
+// One in-process drone, behaving as drone_client does: flies its waypoints
+// one cell at a time, spends and recharges energy, reports on schedule
+typedef struct simdrone {
+    int id;
+    int sock;                 // Below -1, so send_json hands messages to us
+    char drone_id[10];
+    const char *payload;
+    int max_speed;
+    int status;               // IDLE or ON_MISSION, as the client sees it
+    Coord coord, target;
+    TourStop waypoints[MAX_TOUR_STOPS];
+    int num_waypoints;
+    int current_waypoint;
+    int repositioning;
+    double energy;
+    enum { NOT_CHARGING, TO_STATION, DOCKED } charge_state;
+    uint64_t docked_at;       // sim_now_ns() when it docked
+    int status_interval;      // Seconds, from HANDSHAKE_ACK
+    int moving;               // A move event is queued
+} SimDrone;
+
+typedef struct delivery {
+    SimDrone *drone;
+    struct json_object *msg;
+} Delivery;
+
+// A server thread's loop body, run at its thread's interval
+typedef struct periodic {
+    void (*pass)();
+    uint64_t interval;
+} Periodic;
+
+static struct {
+    int drones;
+    double hours;
+    unsigned long long seed;
+    const char *archive;
+    int verbose;
+    const char *scenario;
+    const char *trace;
+} config = {10, 1.0, 1, SIM_ARCHIVE_PATH, 0, NULL, NULL};
+
+static SimDrone *fleet = NULL;
+static uint64_t digest = 0xcbf29ce484222325ULL;  // FNV-1a over every message
+static unsigned long to_drones = 0, from_drones = 0, stops_reported = 0;
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-n drones] [-H hours] [-s seed] [-o archive] [-v] [-l] [-t trace.json] "
+           "[scenario.json]\n", prog);
+}
+
+static int parse_args(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:H:s:o:vlt:")) != -1) {
+        switch (opt) {
+        case 'n': config.drones = atoi(optarg); break;
+        case 'H': config.hours = atof(optarg); break;
+        case 's': config.seed = strtoull(optarg, NULL, 10); break;
+        case 'o': config.archive = optarg; break;
+        case 'v': config.verbose = 1; break;
+        case 'l': lock_profiling_enable(); break;
+        case 't':
+            config.trace = optarg;
+            trace_enable();
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc) config.scenario = argv[optind];
+    if (config.drones < 1 || config.drones > MAX_DRONES || config.hours <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+static void hash_message(char direction, struct json_object *msg) {
+    uint64_t now = sim_now_ns();
+    const char *text = json_object_to_json_string_ext(msg, JSON_C_TO_STRING_PLAIN);
+    for (int i = 0; i < 8; i++) {
+        digest = (digest ^ ((now >> (i * 8)) & 0xff)) * 0x100000001b3ULL;
+    }
+    digest = (digest ^ (unsigned char)direction) * 0x100000001b3ULL;
+    for (const char *p = text; p && *p; p++) {
+        digest = (digest ^ (unsigned char)*p) * 0x100000001b3ULL;
+    }
+}
+
+// Drone to server: straight into the handler the connection thread would call
+static void to_server(SimDrone *d, struct json_object *msg) {
+    from_drones++;
+    hash_message('>', msg);
+    const char *type = json_object_get_string(json_object_object_get(msg, "type"));
+    if (strcmp(type, "HANDSHAKE") == 0) process_handshake(d->sock, msg);
+    else if (strcmp(type, "STATUS_UPDATE") == 0) process_status_update(d->sock, msg);
+    else if (strcmp(type, "MISSION_COMPLETE") == 0) process_mission_complete(d->sock, msg);
+    else if (strcmp(type, "HEARTBEAT_RESPONSE") == 0) process_heartbeat_response(d->sock, msg);
+    json_object_put(msg);
+}
+
+static double current_energy(const SimDrone *d) {
+    if (d->charge_state != DOCKED) return d->energy;
+    double energy = d->energy + CHARGE_RATE * (double)(sim_now_ns() - d->docked_at) / NS_PER_SEC;
+    return energy > BATTERY_CAPACITY ? BATTERY_CAPACITY : energy;
+}
+
+static int battery_percent(const SimDrone *d) {
+    return (int)(current_energy(d) * 100 / BATTERY_CAPACITY);
+}
+
+static const char *status_string(const SimDrone *d) {
+    if (d->charge_state == DOCKED) return "charging";
+    return d->status == IDLE ? "idle" : "busy";
+}
+
+static int is_moving(const SimDrone *d) {
+    return (d->status == ON_MISSION && d->charge_state != DOCKED) || d->repositioning;
+}
+
+static void send_mission_complete(SimDrone *d, const char *mission_id) {
+    struct json_object *complete = json_object_new_object();
+    json_object_object_add(complete, "type", json_object_new_string("MISSION_COMPLETE"));
+    json_object_object_add(complete, "drone_id", json_object_new_string(d->drone_id));
+    json_object_object_add(complete, "mission_id", json_object_new_string(mission_id));
+    json_object_object_add(complete, "timestamp", json_object_new_int64(sim_time()));
+    json_object_object_add(complete, "success", json_object_new_boolean(1));
+    json_object_object_add(complete, "details", json_object_new_string("Delivered aid to survivor"));
+    stops_reported++;
+    to_server(d, complete);
+}
+
+static void charged_event(void *arg) {
+    SimDrone *d = (SimDrone *)arg;
+    if (d->charge_state != DOCKED) return;
+    d->energy = BATTERY_CAPACITY;
+    d->charge_state = NOT_CHARGING;
+    d->status = IDLE;
+}
+
+// One cell towards the target; drone_client's navigate_to_target
+static void navigate(SimDrone *d) {
+    if (d->coord.x != d->target.x || d->coord.y != d->target.y) {
+        d->energy -= ENERGY_PER_CELL;
+        if (d->energy < 0) d->energy = 0;
+    }
+    if (d->coord.x < d->target.x) d->coord.x++;
+    else if (d->coord.x > d->target.x) d->coord.x--;
+    if (d->coord.y < d->target.y) d->coord.y++;
+    else if (d->coord.y > d->target.y) d->coord.y--;
+    int arrived = d->coord.x == d->target.x && d->coord.y == d->target.y;
+
+    if (d->charge_state == TO_STATION) {
+        if (arrived) {
+            d->charge_state = DOCKED;
+            d->docked_at = sim_now_ns();
+            double seconds = (BATTERY_CAPACITY - d->energy) / CHARGE_RATE;
+            sim_schedule((uint64_t)(seconds * NS_PER_SEC), charged_event, d);
+        }
+        return;
+    }
+    if (d->repositioning) {
+        if (arrived) d->repositioning = 0;
+        return;
+    }
+    if (arrived) {
+        send_mission_complete(d, d->num_waypoints > 0 ? d->waypoints[d->current_waypoint].mission_id : "");
+        d->current_waypoint++;
+        if (d->current_waypoint < d->num_waypoints) {
+            d->target = d->waypoints[d->current_waypoint].coord;
+        } else {
+            d->num_waypoints = 0;
+            d->current_waypoint = 0;
+            d->status = IDLE;
+        }
+    }
+}
+
+// A cell takes METERS_PER_CELL / max_speed seconds to cross
+static uint64_t cell_time(const SimDrone *d) {
+    return (uint64_t)METERS_PER_CELL * NS_PER_SEC / d->max_speed;
+}
+
+static void move_event(void *arg);
+
+static void start_moving(SimDrone *d) {
+    if (d->moving || !is_moving(d)) return;
+    d->moving = 1;
+    sim_schedule(cell_time(d), move_event, d);
+}
+
+static void move_event(void *arg) {
+    SimDrone *d = (SimDrone *)arg;
+    d->moving = 0;
+    if (!is_moving(d)) return;
+    navigate(d);
+    start_moving(d);
+}
+
+static void telemetry_event(void *arg) {
+    SimDrone *d = (SimDrone *)arg;
+    struct json_object *status = json_object_new_object();
+    json_object_object_add(status, "type", json_object_new_string("STATUS_UPDATE"));
+    json_object_object_add(status, "drone_id", json_object_new_string(d->drone_id));
+    json_object_object_add(status, "timestamp", json_object_new_int64(sim_time()));
+    struct json_object *loc = json_object_new_object();
+    json_object_object_add(loc, "x", json_object_new_int(d->coord.x));
+    json_object_object_add(loc, "y", json_object_new_int(d->coord.y));
+    json_object_object_add(status, "location", loc);
+    json_object_object_add(status, "status", json_object_new_string(status_string(d)));
+    json_object_object_add(status, "battery", json_object_new_int(battery_percent(d)));
+    json_object_object_add(status, "speed", json_object_new_int(is_moving(d) ? d->max_speed : 0));
+    to_server(d, status);
+    sim_schedule((uint64_t)d->status_interval * NS_PER_SEC, telemetry_event, d);
+}
+
+static void handle_assign_mission(SimDrone *d, struct json_object *msg) {
+    struct json_object *target = json_object_object_get(msg, "target");
+    struct json_object *wps = json_object_object_get(msg, "waypoints");
+    struct json_object *reposition = json_object_object_get(msg, "reposition");
+    struct json_object *charge = json_object_object_get(msg, "charge");
+    Coord to = {
+        json_object_get_int(json_object_object_get(target, "x")),
+        json_object_get_int(json_object_object_get(target, "y"))
+    };
+    if (charge && json_object_get_boolean(charge)) {
+        d->target = to;
+        d->status = ON_MISSION;
+        d->charge_state = TO_STATION;
+        d->repositioning = 0;
+        d->num_waypoints = 0;
+    } else if (reposition && json_object_get_boolean(reposition)) {
+        if (d->status == IDLE) {
+            d->target = to;
+            d->repositioning = 1;
+        }
+    } else {
+        d->repositioning = 0;
+        d->num_waypoints = 0;
+        d->current_waypoint = 0;
+        size_t n = wps ? json_object_array_length(wps) : 0;
+        for (size_t i = 0; i < n && d->num_waypoints < MAX_TOUR_STOPS; i++) {
+            struct json_object *wp = json_object_array_get_idx(wps, i);
+            TourStop *stop = &d->waypoints[d->num_waypoints++];
+            stop->coord.x = json_object_get_int(json_object_object_get(wp, "x"));
+            stop->coord.y = json_object_get_int(json_object_object_get(wp, "y"));
+            snprintf(stop->mission_id, sizeof(stop->mission_id), "%s",
+                     json_object_get_string(json_object_object_get(wp, "mission_id")));
+        }
+        if (d->num_waypoints == 0) {
+            const char *mission_id = json_object_get_string(json_object_object_get(msg, "mission_id"));
+            d->waypoints[0].coord = to;
+            snprintf(d->waypoints[0].mission_id, sizeof(d->waypoints[0].mission_id), "%s",
+                     mission_id ? mission_id : "");
+            d->num_waypoints = 1;
+        }
+        d->target = d->waypoints[0].coord;
+        d->status = ON_MISSION;
+    }
+    start_moving(d);
+}
+
+// Server to drone: what drone_client's receive thread does with each message
+static void deliver_event(void *arg) {
+    Delivery *delivery = (Delivery *)arg;
+    SimDrone *d = delivery->drone;
+    struct json_object *msg = delivery->msg;
+    const char *type = json_object_get_string(json_object_object_get(msg, "type"));
+    if (!type) {
+        // Malformed; skip it
+    } else if (strcmp(type, "HANDSHAKE_ACK") == 0) {
+        struct json_object *config_obj, *field;
+        if (json_object_object_get_ex(msg, "config", &config_obj) &&
+            json_object_object_get_ex(config_obj, "status_update_interval", &field) &&
+            json_object_get_int(field) > 0) {
+            d->status_interval = json_object_get_int(field);
+        }
+        telemetry_event(d);
+    } else if (strcmp(type, "ASSIGN_MISSION") == 0) {
+        handle_assign_mission(d, msg);
+    } else if (strcmp(type, "MISSION_CANCEL") == 0) {
+        int kept = d->current_waypoint;
+        for (int i = d->current_waypoint; d->status == ON_MISSION && i < d->num_waypoints; i++) {
+            if (!cancel_withdraws(msg, d->waypoints[i].mission_id)) d->waypoints[kept++] = d->waypoints[i];
+        }
+        if (d->status == ON_MISSION && kept < d->num_waypoints) {
+            d->num_waypoints = kept;
+            if (d->current_waypoint < d->num_waypoints) {
+                d->target = d->waypoints[d->current_waypoint].coord;
+                start_moving(d);
+            } else {
+                d->num_waypoints = 0;
+                d->current_waypoint = 0;
+                d->status = IDLE;
+                d->target = d->coord;
+            }
+        }
+    } else if (strcmp(type, "HEARTBEAT") == 0) {
+        struct json_object *response = json_object_new_object();
+        json_object_object_add(response, "type", json_object_new_string("HEARTBEAT_RESPONSE"));
+        json_object_object_add(response, "drone_id", json_object_new_string(d->drone_id));
+        json_object_object_add(response, "timestamp", json_object_new_int64(sim_time()));
+        to_server(d, response);
+    }
+    json_object_put(msg);
+    free(delivery);
+}
+
+// send_json's hook for our sockets. Senders often hold drone or list
+// locks, so the message is queued as an event rather than handled here.
+static void deliver(int sock, struct json_object *msg) {
+    int index = -2 - sock;
+    if (index < 0 || index >= config.drones) return;
+    Delivery *delivery = malloc(sizeof(Delivery));
+    if (!delivery) {
+        printf("Failed to allocate memory for message delivery\n");
+        return;
+    }
+    to_drones++;
+    hash_message('<', msg);
+    delivery->drone = &fleet[index];
+    delivery->msg = json_object_get(msg);
+    sim_schedule(0, deliver_event, delivery);
+}
+
+static void handshake(SimDrone *d) {
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string("HANDSHAKE"));
+    json_object_object_add(msg, "drone_id", json_object_new_string(d->drone_id));
+    struct json_object *capabilities = json_object_new_object();
+    json_object_object_add(capabilities, "max_speed", json_object_new_int(d->max_speed));
+    json_object_object_add(capabilities, "battery_capacity", json_object_new_int(BATTERY_CAPACITY));
+    json_object_object_add(capabilities, "payload", json_object_new_string(d->payload));
+    json_object_object_add(msg, "capabilities", capabilities);
+    to_server(d, msg);
+}
+
+static void rebalance_pass() {
+    decay_demand();
+    rebalance_idle_drones();
+}
+
+static void periodic_event(void *arg) {
+    Periodic *p = (Periodic *)arg;
+    p->pass();
+    sim_schedule(p->interval, periodic_event, p);
+}
+
+static void generator_event(void *arg) {
+    (void)arg;
+    sim_schedule((uint64_t)generate_survivor() * NS_PER_SEC, generator_event, NULL);
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    if (parse_args(argc, argv) != 0) return 1;
+    trace_thread_name("simulation");
+
+    // The server logic logs every message; the report goes to the real
+    // stdout and the log to /dev/null unless -v
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    if (!report) {
+        perror("Failed to open report stream");
+        return 1;
+    }
+    if (!config.verbose && !freopen("/dev/null", "w", stdout)) {
+        perror("Failed to silence server log");
+        return 1;
+    }
+
+    sim_use_virtual_time(config.seed);
+    max_drones = config.drones;
+    set_local_delivery(deliver);
+    // A fresh archive per run, so its rows are this run's and nothing else
+    unlink(config.archive);
+    if (initialize_globals(config.archive) != 0) {
+        fprintf(report, "Failed to initialize globals\n");
+        return 1;
+    }
+    running = 1;
+
+    fleet = calloc(config.drones, sizeof(SimDrone));
+    if (!fleet) {
+        fprintf(report, "Failed to allocate simulated drones\n");
+        cleanup_globals();
+        return 1;
+    }
+
+    if (config.scenario) {
+        if (schedule_workload(config.scenario) != 0) {
+            fprintf(report, "Failed to schedule workload from %s\n", config.scenario);
+            cleanup_globals();
+            return 1;
+        }
+    } else {
+        sim_schedule(0, generator_event, NULL);
+    }
+
+    static Periodic passes[] = {
+        { ai_dispatch_pass, AI_PASS_INTERVAL_MS * 1000000ULL },
+        { rebalance_pass, REBALANCE_INTERVAL * NS_PER_SEC },
+        { charging_pass, CHARGE_CHECK_INTERVAL * NS_PER_SEC },
+        { session_reap_pass, SESSION_REAP_INTERVAL * NS_PER_SEC },
+        { send_heartbeats, HEARTBEAT_INTERVAL * NS_PER_SEC },
+    };
+    // The AI controller runs its first pass at once, the others sleep first
+    sim_schedule(0, periodic_event, &passes[0]);
+    for (size_t i = 1; i < sizeof(passes) / sizeof(passes[0]); i++) {
+        sim_schedule(passes[i].interval, periodic_event, &passes[i]);
+    }
+
+    for (int i = 0; i < config.drones; i++) {
+        SimDrone *d = &fleet[i];
+        d->id = i + 1;
+        d->sock = -2 - i;
+        snprintf(d->drone_id, sizeof(d->drone_id), "D%d", d->id);
+        d->payload = payload_types[sim_random_below(NUM_PAYLOAD_TYPES)];
+        d->max_speed = SIM_MAX_SPEED;
+        d->status = IDLE;
+        d->coord.x = sim_random_below(map.width);
+        d->coord.y = sim_random_below(map.height);
+        d->target = d->coord;
+        d->energy = BATTERY_CAPACITY;
+        d->status_interval = STATUS_UPDATE_INTERVAL;
+        handshake(d);
+    }
+
+    uint64_t horizon = sim_now_ns() + (uint64_t)(config.hours * 3600 * NS_PER_SEC);
+    double start = now_seconds();
+    uint64_t events = sim_run(horizon);
+    double elapsed = now_seconds() - start;
+    running = 0;
+    if (config.scenario) stop_workload();
+
+    fprintf(report, "Simulated %.2f h with %d drones (seed %llu) in %.2fs: %.0fx real time\n",
+            config.hours, config.drones, config.seed, elapsed,
+            elapsed > 0 ? config.hours * 3600 / elapsed : 0.0);
+    fprintf(report, "%llu events, %lu messages to drones, %lu from drones\n",
+            (unsigned long long)events, to_drones, from_drones);
+    fprintf(report, "%lu stops reported complete, %d survivors still waiting\n",
+            stops_reported, survivors->number_of_elements);
+    sla_dump(report);
+    fprintf(report, "Message digest: %016llx\n", (unsigned long long)digest);
+    if (lock_profiling) lock_report(report);
+    if (config.trace && trace_save(config.trace) == 0) {
+        fprintf(report, "Trace written to %s\n", config.trace);
+    }
+    fclose(report);
+
+    cleanup_globals();
+    free(fleet);
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "headers/sla.h"
+#include "headers/globals.h"
+#include "headers/mission_index.h"
+#include "headers/simclock.h"
+#include "headers/metrics.h"
+
+static Histogram histograms[SLA_STAGES][SLA_REGIONS][NUM_PRIORITIES];
+
+static const char *stage_names[SLA_STAGES] = {"wait", "dispatch", "flight", "total"};
+static const char *priority_names[NUM_PRIORITIES] = {"low", "medium", "high"};
+
+int sla_region(Coord coord) {
+    int col = map.width > 0 ? coord.x * SLA_REGION_COLS / map.width : 0;
+    int row = map.height > 0 ? coord.y * SLA_REGION_ROWS / map.height : 0;
+    if (col < 0) col = 0;
+    if (col >= SLA_REGION_COLS) col = SLA_REGION_COLS - 1;
+    if (row < 0) row = 0;
+    if (row >= SLA_REGION_ROWS) row = SLA_REGION_ROWS - 1;
+    return row * SLA_REGION_COLS + col;
+}
+
+typedef struct stampjob {
+    size_t field;
+    uint64_t now;
+    MetricsHistogram *latency;
+} StampJob;
+
+static void stamp_survivor(MissionEntry *entry, void *arg) {
+    StampJob *job = (StampJob *)arg;
+    Survivor *s = entry->survivor;
+    uint64_t *stamp = (uint64_t *)((char *)s + job->field);
+    lock_acquire(&s->lock);
+    if (*stamp == 0) {
+        *stamp = job->now;
+        if (job->latency) metrics_observe(job->latency, job->now - s->discovered_ns);
+    }
+    lock_release(&s->lock);
+}
+
+// Stamp one lifecycle stage on the survivors behind tour stops, keeping
+// the first time each stage was reached (a reassigned mission keeps its
+// original assignment and departure). Each first stamp also records the
+// time since discovery into `latency`, if given. Stamping happens under
+// the index lock, so a stop completed meanwhile is skipped rather than
+// stamped onto the recycled survivor of another mission.
+static void mark_stops(const Tour *tour, int first_stop, size_t field, MetricsHistogram *latency) {
+    StampJob job = { field, sim_now_ns(), latency };
+    for (int i = first_stop; i < tour->count; i++) {
+        mission_index_visit(tour->stops[i].id, stamp_survivor, &job);
+    }
+}
+
+void sla_mark_assigned(const Tour *tour) {
+    mark_stops(tour, 0, offsetof(Survivor, assigned_ns), metrics.dispatch_latency);
+}
+
+void sla_mark_departed(const Tour *tour, int first_stop) {
+    mark_stops(tour, first_stop, offsetof(Survivor, departed_ns), NULL);
+}
+
+static void record_stage(int stage, int region, int priority, uint64_t from, uint64_t to) {
+    if (from == 0 || to < from) return;
+    histogram_record(&histograms[stage][region][priority], to - from);
+}
+
+// Called once per survivor, when it is helped. Stages that were skipped
+// (e.g. no departure seen before completion) count as zero.
+void sla_record_helped(const Survivor *s) {
+    int region = sla_region(s->coord);
+    int priority = s->priority;
+    if (priority < 0 || priority >= NUM_PRIORITIES) priority = PRIORITY_LOW;
+
+    uint64_t assigned = s->assigned_ns ? s->assigned_ns : s->helped_ns;
+    uint64_t departed = s->departed_ns ? s->departed_ns : s->helped_ns;
+    record_stage(SLA_WAIT, region, priority, s->discovered_ns, assigned);
+    record_stage(SLA_DISPATCH, region, priority, assigned, departed);
+    record_stage(SLA_FLIGHT, region, priority, departed, s->helped_ns);
+    record_stage(SLA_TOTAL, region, priority, s->discovered_ns, s->helped_ns);
+}
+
+// -1 (all stages) for an unknown name
+int sla_stage_by_name(const char *name) {
+    for (int i = 0; name && i < SLA_STAGES; i++) {
+        if (strcmp(name, stage_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static double to_ms(uint64_t ns) {
+    return ns / 1e6;
+}
+
+static void add_stats(struct json_object *row, const Histogram *h, uint64_t count) {
+    json_object_object_add(row, "count", json_object_new_int64((int64_t)count));
+    json_object_object_add(row, "mean_ms", json_object_new_double(to_ms(h->sum) / count));
+    json_object_object_add(row, "p50_ms", json_object_new_double(to_ms(histogram_percentile(h, 50))));
+    json_object_object_add(row, "p90_ms", json_object_new_double(to_ms(histogram_percentile(h, 90))));
+    json_object_object_add(row, "p99_ms", json_object_new_double(to_ms(histogram_percentile(h, 99))));
+    json_object_object_add(row, "max_ms", json_object_new_double(to_ms(h->max)));
+}
+
+// Non-empty histograms of one stage (or every stage when stage < 0), plus
+// each stage over all regions and priorities
+struct json_object *sla_report_json(int stage) {
+    struct json_object *report = json_object_new_object();
+    json_object_object_add(report, "type", json_object_new_string("SLA_REPORT"));
+    json_object_object_add(report, "regions", json_object_new_int(SLA_REGIONS));
+    struct json_object *stages = json_object_new_object();
+    struct json_object *overall = json_object_new_object();
+    Histogram *merged = malloc(sizeof(Histogram));
+    for (int st = 0; st < SLA_STAGES; st++) {
+        if (stage >= 0 && st != stage) continue;
+        if (merged) memset(merged, 0, sizeof(Histogram));
+        struct json_object *rows = json_object_new_array();
+        for (int r = 0; r < SLA_REGIONS; r++) {
+            for (int p = 0; p < NUM_PRIORITIES; p++) {
+                const Histogram *h = &histograms[st][r][p];
+                uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+                if (count == 0) continue;
+                struct json_object *row = json_object_new_object();
+                json_object_object_add(row, "region", json_object_new_int(r));
+                json_object_object_add(row, "priority", json_object_new_string(priority_names[p]));
+                add_stats(row, h, count);
+                json_object_array_add(rows, row);
+                if (merged) histogram_merge(merged, h);
+            }
+        }
+        json_object_object_add(stages, stage_names[st], rows);
+        if (merged && merged->count > 0) {
+            struct json_object *all = json_object_new_object();
+            add_stats(all, merged, merged->count);
+            json_object_object_add(overall, stage_names[st], all);
+        }
+    }
+    free(merged);
+    json_object_object_add(report, "stages", stages);
+    json_object_object_add(report, "overall", overall);
+    return report;
+}
+
+void sla_dump(FILE *out) {
+    fprintf(out, "\n=== Response time SLA (ms) ===\n");
+    for (int st = 0; st < SLA_STAGES; st++) {
+        fprintf(out, "Stage %s:\n", stage_names[st]);
+        fprintf(out, "  %-6s %-8s %8s %10s %10s %10s %10s %10s\n",
+                "region", "priority", "count", "mean", "p50", "p90", "p99", "max");
+        int rows = 0;
+        for (int r = 0; r < SLA_REGIONS; r++) {
+            for (int p = 0; p < NUM_PRIORITIES; p++) {
+                const Histogram *h = &histograms[st][r][p];
+                if (h->count == 0) continue;
+                fprintf(out, "  %-6d %-8s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                        r, priority_names[p], (unsigned long long)h->count,
+                        to_ms(h->sum) / h->count,
+                        to_ms(histogram_percentile(h, 50)),
+                        to_ms(histogram_percentile(h, 90)),
+                        to_ms(histogram_percentile(h, 99)),
+                        to_ms(h->max));
+                rows++;
+            }
+        }
+        if (rows == 0) fprintf(out, "  (no survivors helped)\n");
+    }
+}
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include "headers/snapshot.h"
+
+// Three frames: the publisher fills the back one, the renderer draws the
+// front one, and the middle one holds the newest finished frame. Handing
+// one over is a single atomic exchange of the middle index, so neither
+// side ever waits for the other and a slow renderer only skips frames.
+#define FRESH 4  // Set in middle when it holds a frame the renderer hasn't taken
+
+static Frame frames[3];
+static int middle = 1;
+static int back = 0;   // Publisher side only
+static int front = 2;  // Renderer side only
+static int have_front = 0;
+
+// The frame to fill next. Its arrays are kept from the last time it was
+// used, so once the world stops growing publishing allocates nothing.
+Frame *snapshot_back() {
+    return &frames[back];
+}
+
+void snapshot_publish() {
+    back = __atomic_exchange_n(&middle, back | FRESH, __ATOMIC_ACQ_REL) & ~FRESH;
+}
+
+// Newest published frame, or NULL before the first. Stays valid and
+// unchanged until the next call.
+const Frame *snapshot_latest() {
+    if (__atomic_load_n(&middle, __ATOMIC_RELAXED) & FRESH) {
+        front = __atomic_exchange_n(&middle, front, __ATOMIC_ACQ_REL) & ~FRESH;
+        have_front = 1;
+    }
+    return have_front ? &frames[front] : NULL;
+}
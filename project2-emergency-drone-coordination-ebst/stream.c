@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <json-c/json.h>
+#include "headers/stream.h"
+#include "headers/snapshot.h"
+#include "headers/globals.h"
+#include "headers/view.h"
+#include "headers/fleet.h"
+
+// A viewer connection. Bytes the socket would not take yet wait in the
+// backlog; the publisher never blocks on a slow viewer.
+typedef struct subscriber {
+    int sock;
+    int want_snapshot;  // Next message must be a full SNAPSHOT
+    char *backlog;
+    size_t backlog_len, backlog_cap;
+    int mid_line;       // The backlog starts with the rest of a partly sent line
+} Subscriber;
+
+static Subscriber subscribers[STREAM_MAX_SUBSCRIBERS];
+static int num_subscribers = 0;
+// Protects subscribers and the published frame below
+static pthread_mutex_t stream_lock = PTHREAD_MUTEX_INITIALIZER;
+// Last frame sent to viewers; deltas are taken against it
+static Frame published;
+
+// Simulated drones go after the real ones, keyed past the end of the drone
+// list and already in key order, so they need no sorting
+static void capture_fleet(Frame *frame) {
+    const FleetState *state = fleet_latest(sim_fleet);
+    if (!state) return;
+    int count = sim_fleet->count;
+    if (frame_reserve(frame, frame->num_drones + count, 0) != 0) return;
+    int base = drones->capacity;
+    FrameDrone *fd = &frame->drones[frame->num_drones];
+    for (int i = 0; i < count; i++, fd++) {
+        fd->key = base + i;
+        fd->id = base + i;
+        fd->coord.x = state->x[i];
+        fd->coord.y = state->y[i];
+        fd->target.x = state->target_x[i];
+        fd->target.y = state->target_y[i];
+        fd->status = state->status[i];
+    }
+    frame->num_drones += count;
+}
+
+// Copy what a viewer draws out of the simulation. Drones are keyed by
+// their slot in the drone list, survivors by mission ID.
+void capture_frame(Frame *frame) {
+    frame->width = map.width;
+    frame->height = map.height;
+    frame->num_stations = map.num_stations < FRAME_MAX_STATIONS ? map.num_stations : FRAME_MAX_STATIONS;
+    for (int i = 0; i < frame->num_stations; i++) {
+        frame->stations[i] = map.stations[i].coord;
+    }
+
+    lock_acquire(&drones->lock);
+    frame->num_drones = 0;
+    if (frame_reserve(frame, drones->number_of_elements, 0) == 0) {
+        for (Node *node = drones->head; node != NULL; node = node->next) {
+            Drone *d = (Drone *)node->data;
+            FrameDrone *fd = &frame->drones[frame->num_drones++];
+            fd->key = (int)(((char *)node - drones->startaddress) / drones->nodesize);
+            fd->id = d->id;
+            fd->coord = d->coord;
+            fd->target = d->target;
+            fd->status = d->status;
+        }
+    }
+    lock_release(&drones->lock);
+
+    lock_acquire(&survivors->lock);
+    frame->num_survivors = 0;
+    if (frame_reserve(frame, 0, survivors->number_of_elements) == 0) {
+        for (Node *node = survivors->head; node != NULL; node = node->next) {
+            Survivor *s = (Survivor *)node->data;
+            FrameSurvivor *fs = &frame->survivors[frame->num_survivors++];
+            fs->id = s->mission_id;
+            fs->coord = s->coord;
+            fs->status = s->status;
+        }
+    }
+    lock_release(&survivors->lock);
+
+    frame_sort(frame);
+    if (sim_fleet) capture_fleet(frame);
+}
+
+// Throw away queued messages, except the unsent end of a line the viewer
+// already has the start of: cutting it would glue half a message onto the
+// next one
+static void drop_backlog(Subscriber *sub) {
+    size_t keep = 0;
+    if (sub->mid_line) {
+        char *end = memchr(sub->backlog, '\n', sub->backlog_len);
+        keep = end ? (size_t)(end - sub->backlog) + 1 : sub->backlog_len;
+    }
+    sub->backlog_len = keep;
+}
+
+static void remove_subscriber(Subscriber *sub) {
+    printf("Viewer on sock %d unsubscribed\n", sub->sock);
+    free(sub->backlog);
+    *sub = subscribers[--num_subscribers];
+}
+
+static Subscriber *find_subscriber(int sock) {
+    for (int i = 0; i < num_subscribers; i++) {
+        if (subscribers[i].sock == sock) return &subscribers[i];
+    }
+    return NULL;
+}
+
+int stream_subscribe(int sock) {
+    pthread_mutex_lock(&stream_lock);
+    Subscriber *sub = find_subscriber(sock);
+    if (!sub) {
+        if (num_subscribers == STREAM_MAX_SUBSCRIBERS) {
+            pthread_mutex_unlock(&stream_lock);
+            printf("Viewer on sock %d rejected: %d viewers already subscribed\n", sock, STREAM_MAX_SUBSCRIBERS);
+            return 1;
+        }
+        sub = &subscribers[num_subscribers++];
+        memset(sub, 0, sizeof(Subscriber));
+        sub->sock = sock;
+    }
+    sub->want_snapshot = 1;
+    pthread_mutex_unlock(&stream_lock);
+    printf("Viewer subscribed on sock %d\n", sock);
+    return 0;
+}
+
+void stream_resync(int sock) {
+    pthread_mutex_lock(&stream_lock);
+    Subscriber *sub = find_subscriber(sock);
+    if (sub) {
+        // Anything still queued is older than the snapshot that replaces it
+        drop_backlog(sub);
+        sub->want_snapshot = 1;
+    }
+    pthread_mutex_unlock(&stream_lock);
+}
+
+// Called before the socket is closed, so the publisher never writes to a
+// descriptor that has been reused
+void stream_unsubscribe(int sock) {
+    pthread_mutex_lock(&stream_lock);
+    Subscriber *sub = find_subscriber(sock);
+    if (sub) remove_subscriber(sub);
+    pthread_mutex_unlock(&stream_lock);
+}
+
+// Viewer count and the bytes queued for them, for monitoring
+void stream_stats(int *subscriber_count, size_t *backlog_bytes) {
+    pthread_mutex_lock(&stream_lock);
+    *subscriber_count = num_subscribers;
+    *backlog_bytes = 0;
+    for (int i = 0; i < num_subscribers; i++) {
+        *backlog_bytes += subscribers[i].backlog_len;
+    }
+    pthread_mutex_unlock(&stream_lock);
+}
+
+// Push queued bytes without blocking. Returns 1 if the socket failed.
+static int flush_backlog(Subscriber *sub) {
+    size_t sent_total = 0;
+    while (sent_total < sub->backlog_len) {
+        ssize_t sent = send(sub->sock, sub->backlog + sent_total, sub->backlog_len - sent_total,
+                            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        sent_total += sent;
+    }
+    if (sent_total > 0) sub->mid_line = sub->backlog[sent_total - 1] != '\n';
+    memmove(sub->backlog, sub->backlog + sent_total, sub->backlog_len - sent_total);
+    sub->backlog_len -= sent_total;
+    return 0;
+}
+
+// Queue one serialized message. A viewer too far behind loses the delta
+// and gets a fresh snapshot once its backlog drains.
+static void enqueue(Subscriber *sub, const char *msg, size_t len) {
+    if (sub->backlog_len + len > STREAM_MAX_BACKLOG) {
+        sub->want_snapshot = 1;
+        return;
+    }
+    if (sub->backlog_len + len > sub->backlog_cap) {
+        size_t capacity = sub->backlog_cap ? sub->backlog_cap : 4096;
+        while (capacity < sub->backlog_len + len) capacity *= 2;
+        char *grown = realloc(sub->backlog, capacity);
+        if (!grown) {
+            sub->want_snapshot = 1;
+            return;
+        }
+        sub->backlog = grown;
+        sub->backlog_cap = capacity;
+    }
+    memcpy(sub->backlog + sub->backlog_len, msg, len);
+    sub->backlog_len += len;
+}
+
+// Serialize a message once, newline-terminated, for every viewer
+static char *serialize(struct json_object *msg, size_t *len) {
+    const char *text = json_object_to_json_string_ext(msg, JSON_C_TO_STRING_PLAIN);
+    *len = strlen(text) + 1;
+    char *line = malloc(*len);
+    if (!line) return NULL;
+    memcpy(line, text, *len - 1);
+    line[*len - 1] = '\n';
+    return line;
+}
+
+// Each tick: capture the world into the renderer's back buffer, diff it
+// against what viewers last saw, serialize the delta once and queue the
+// same bytes for every subscriber. Viewers that just joined, fell behind
+// or asked for a resync get a snapshot instead, built at most once per
+// tick. Capturing here rather than in the render loop keeps the list
+// locks at the simulation's tick rate, not the display's.
+void *stream_publisher(void *arg) {
+    (void)arg;
+    frame_init(&published);
+    // Start from the world as it is, so even an empty map has a size
+    pthread_mutex_lock(&stream_lock);
+    capture_frame(&published);
+    pthread_mutex_unlock(&stream_lock);
+
+    while (running) {
+        usleep(STREAM_TICK_MS * 1000);
+        Frame *current = snapshot_back();
+        capture_frame(current);
+
+        pthread_mutex_lock(&stream_lock);
+        int changes = 0;
+        struct json_object *delta = NULL;
+        char *delta_line = NULL;
+        size_t delta_len = 0;
+        // With no viewers there is nothing to serialize; a large simulated
+        // fleet would otherwise build a delta of every drone each tick
+        if (num_subscribers > 0) {
+            delta = frame_delta_json(&published, current, &changes);
+        } else {
+            changes = !frame_equal(&published, current);
+        }
+        if (changes > 0) {
+            current->seq = published.seq + 1;
+            if (delta) {
+                json_object_object_add(delta, "seq", json_object_new_int64((int64_t)current->seq));
+                delta_line = serialize(delta, &delta_len);
+            }
+        } else {
+            current->seq = published.seq;
+        }
+        if (delta) json_object_put(delta);
+        // An unchanged world needs no copy; a failed one leaves viewers a
+        // delta behind, which their sequence check turns into a resync
+        if (changes > 0 && frame_copy(&published, current) != 0) {
+            for (int i = 0; i < num_subscribers; i++) subscribers[i].want_snapshot = 1;
+        }
+
+        char *snapshot_line = NULL;
+        size_t snapshot_len = 0;
+        for (int i = 0; i < num_subscribers; i++) {
+            Subscriber *sub = &subscribers[i];
+            if (sub->want_snapshot) {
+                // Wait for room so the snapshot isn't dropped as well
+                if (sub->backlog_len > STREAM_MAX_BACKLOG / 2) {
+                    if (flush_backlog(sub) != 0) remove_subscriber(&subscribers[i--]);
+                    continue;
+                }
+                if (!snapshot_line) {
+                    struct json_object *snapshot = frame_snapshot_json(&published);
+                    snapshot_line = serialize(snapshot, &snapshot_len);
+                    json_object_put(snapshot);
+                    if (!snapshot_line) continue;
+                }
+                sub->want_snapshot = 0;
+                enqueue(sub, snapshot_line, snapshot_len);
+            } else if (delta_line) {
+                enqueue(sub, delta_line, delta_len);
+            }
+            if (flush_backlog(sub) != 0) {
+                // Dead socket: stop queueing for it now. The handler thread
+                // sees the error too and its unsubscribe finds nothing left.
+                remove_subscriber(&subscribers[i--]);
+            }
+        }
+        pthread_mutex_unlock(&stream_lock);
+        free(delta_line);
+        free(snapshot_line);
+        snapshot_publish();
+    }
+    return NULL;
+}
+
+// The server's own window draws the newest frame the publisher captured:
+// no list locks and no allocation in the render loop
+int draw_map() {
+    const Frame *frame = snapshot_latest();
+    if (!frame) return 0;  // Nothing published yet
+    return draw_frame(frame);
+}
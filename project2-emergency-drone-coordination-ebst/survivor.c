@@ -3,29 +3,230 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <time.h>
 #include <unistd.h>
 #include "headers/globals.h"
 #include "headers/map.h"
+#include "headers/rebalance.h"
+#include "headers/pool.h"
+#include "headers/mission_index.h"
+#include "headers/sla.h"
+#include "headers/simclock.h"
+#include "headers/metrics.h"
+#include "headers/trace.h"
 
-Survivor *create_survivor(Coord *coord, char *info, struct tm *discovery_time) {
-    Survivor *s = malloc(sizeof(Survivor));
+// Aid types a survivor can need; drones advertise one in HANDSHAKE
+const char *payload_types[NUM_PAYLOAD_TYPES] = {"medical", "food", "water"};
+
+// Survivors come from a pool rather than malloc: the generators create
+// thousands per second and every list holds the same object by reference,
+// so one allocation lives from discovery until the survivor is archived.
+static Pool survivor_pool;
+
+// Runs once per pooled object; the mutex then survives every reuse
+static void init_pooled_survivor(void *obj) {
+    lock_init(&((Survivor *)obj)->lock, "survivor", 0);
+}
+
+// Mission IDs start at the server's boot second shifted left 20 bits and
+// count up, so a restarted server doesn't reuse IDs that drones from the
+// previous run may still report (unless that run made over 2^20 survivors
+// per second of uptime)
+static uint64_t next_mission_id = 0;
+
+int init_survivor_pool() {
+    next_mission_id = (uint64_t)sim_time() << 20;
+    return pool_init(&survivor_pool, sizeof(Survivor), init_pooled_survivor);
+}
+
+void destroy_survivor_pool() {
+    pool_destroy(&survivor_pool);
+}
+
+// Medical aid is the most urgent, then water, then everything else
+int payload_priority(const char *payload) {
+    if (payload && strcmp(payload, "medical") == 0) return PRIORITY_HIGH;
+    if (payload && strcmp(payload, "water") == 0) return PRIORITY_MEDIUM;
+    return PRIORITY_LOW;
+}
+
+Survivor *create_survivor(Coord *coord, char *info, const char *payload, struct tm *discovery_time) {
+    Survivor *s = pool_alloc(&survivor_pool);
     if (!s) return NULL;
-    memset(s, 0, sizeof(Survivor));
+    // Every field but the lock, which init_pooled_survivor already set up
+    s->status = WAITING;
     s->coord = *coord;
+    s->mission_id = __atomic_add_fetch(&next_mission_id, 1, __ATOMIC_RELAXED);
+    s->node = NULL;
     memcpy(&s->discovery_time, discovery_time, sizeof(struct tm));
+    memset(&s->helped_time, 0, sizeof(struct tm));
     strncpy(s->info, info, sizeof(s->info) - 1);
     s->info[sizeof(s->info) - 1] = '\0';
-    s->status = WAITING;
-    pthread_mutex_init(&s->lock, NULL);
+    snprintf(s->payload, sizeof(s->payload), "%s", payload ? payload : "");
+    s->priority = payload_priority(s->payload);
+    s->discovered_ns = sim_now_ns();
+    s->assigned_ns = 0;
+    s->departed_ns = 0;
+    s->helped_ns = 0;
     return s;
 }
 
-void *survivor_generator(void *args) {
-    (void)args;
+// Returns a survivor to the pool. It must already be out of every list.
+void destroy_survivor(Survivor *s) {
+    pool_free(&survivor_pool, s);
+}
+
+// Quiet insertion path for bulk workloads: indexes a new survivor and adds
+// it to the global list and its map cell. Returns 0 on success, 1 if the
+// index or either list is full (the survivor is dropped).
+int spawn_survivor(Coord coord, const char *info, const char *payload) {
+    time_t t = sim_time();
+    struct tm discovery_time;
+    localtime_r(&t, &discovery_time);
+
+    Survivor *s = create_survivor(&coord, (char *)info, payload, &discovery_time);
+    if (!s) return 1;
+    uint64_t id = s->mission_id;
+
+    // Indexed before it is listed, so the AI can never assign a mission
+    // that MISSION_COMPLETE then fails to find. Both lists share this object.
+    if (mission_index_insert(id, s) != 0) {
+        destroy_survivor(s);
+        return 1;
+    }
+    // Once listed, the AI may assign it and end the stage at any moment
+    trace_stage_begin(STAGE_WAITING, id);
+    // The AI only walks the global list, so that add comes last: a survivor
+    // that doesn't fit is still private and can go back to the pool
+    int failed = 0;
+    List *cell = map.cells[coord.y][coord.x].survivors;
+    if (!cell->add(cell, s)) {
+        failed = 1;
+    } else {
+        lock_acquire(&survivors->lock);
+        s->node = survivors->add(survivors, s);
+        lock_release(&survivors->lock);
+        if (!s->node) {
+            lock_acquire(&cell->lock);
+            cell->removedata(cell, s);
+            lock_release(&cell->lock);
+            failed = 1;
+        }
+    }
+    if (failed) {
+        trace_stage_end(STAGE_WAITING, id);
+        mission_index_remove(id, NULL);
+        destroy_survivor(s);
+    } else {
+        record_demand(coord);
+        counter_add(metrics.survivors_created, 1);
+    }
+    return failed;
+}
+
+// Adds one random survivor and returns the seconds to wait before the
+// next one (2-4, or 1 to retry after a failure)
+int generate_survivor() {
+    uint64_t span = trace_start();
     time_t t;
     struct tm discovery_time;
-    srand(time(NULL));
+    printf("\n=== Generating new survivor ===\n");
+    // Create coordinates within map bounds
+    Coord coord = {
+        .x = sim_random_below(map.width),
+        .y = sim_random_below(map.height)
+    };
+    
+    // Generate unique survivor ID
+    char info[25];
+    snprintf(info, sizeof(info), "SURV-%04d", sim_random_below(10000));
+    printf("Generated survivor ID: %s at position (%d,%d)\n", info, coord.x, coord.y);
+    
+    // Get current time
+    t = sim_time();
+    localtime_r(&t, &discovery_time);
+
+    // Create survivor
+    printf("Creating survivor object...\n");
+    const char *payload = payload_types[sim_random_below(NUM_PAYLOAD_TYPES)];
+    Survivor *s = create_survivor(&coord, info, payload, &discovery_time);
+    if (!s) {
+        printf("Failed to create survivor\n");
+        return 1;
+    }
+    printf("Survivor object created at %p\n", (void*)s);
+    printf("Survivor status: %d\n", s->status);
+    printf("Survivor coordinates: (%d,%d)\n", s->coord.x, s->coord.y);
+
+    uint64_t id = s->mission_id;
+    printf("Indexing mission %" PRIu64 "...\n", id);
+    if (mission_index_insert(id, s) != 0) {
+        printf("Failed to index survivor\n");
+        destroy_survivor(s);
+        return 1;
+    }
+    // Before it is listed: the AI may assign it as soon as it is
+    trace_stage_begin(STAGE_WAITING, id);
+
+    // Add to map cell's survivors list first: the AI only walks the global
+    // list, so until that add the survivor is private and a failure can
+    // still hand it back to the pool
+    List *cell = map.cells[coord.y][coord.x].survivors;
+    printf("Adding survivor to map cell [%d][%d]...\n", coord.y, coord.x);
+    lock_acquire(&cell->lock);
+    printf("Map cell list locked, current count: %d\n", cell->number_of_elements);
+    Node *node = cell->add(cell, s);
+    printf("Add operation completed, new count: %d\n", cell->number_of_elements);
+    lock_release(&cell->lock);
+
+    if (!node) {
+        printf("Failed to add survivor to map cell\n");
+        trace_stage_end(STAGE_WAITING, id);
+        mission_index_remove(id, NULL);
+        destroy_survivor(s);
+        return 1;
+    }
+    printf("Successfully added to map cell at node %p\n", (void*)node);
+
+    // Add to global survivors list
+    printf("Adding survivor to global list...\n");
+    lock_acquire(&survivors->lock);
+    printf("Global list locked, current count: %d\n", survivors->number_of_elements);
+    printf("Global list head before add: %p\n", (void*)survivors->head);
+    node = survivors->add(survivors, s);
+    s->node = node;
+    printf("Add operation completed, new count: %d\n", survivors->number_of_elements);
+    printf("Global list head after add: %p\n", (void*)survivors->head);
+    printf("Added node address: %p\n", (void*)node);
+    lock_release(&survivors->lock);
+    
+    if (!node) {
+        printf("Failed to add survivor to global list\n");
+        lock_acquire(&cell->lock);
+        cell->removedata(cell, s);
+        lock_release(&cell->lock);
+        trace_stage_end(STAGE_WAITING, id);
+        mission_index_remove(id, NULL);
+        destroy_survivor(s);
+        return 1;
+    }
+    printf("Successfully added to global list at node %p\n", (void*)node);
+    record_demand(coord);
+    counter_add(metrics.survivors_created, 1);
+    trace_span("generate_survivor", id, span);
+
+    printf("Successfully created new survivor at (%d,%d): %s\n", coord.x, coord.y, info);
+    
+    // Wait 2-4 seconds before generating next survivor
+    int delay = sim_random_below(3) + 2;
+    printf("Sleeping for %d seconds before next survivor...\n\n", delay);
+    return delay;
+}
+
+void *survivor_generator(void *args) {
+    (void)args;
+    trace_thread_name("survivor_generator");
     printf("\n=== Survivor Generator Started ===\n");
     printf("Map dimensions: %dx%d\n", map.width, map.height);
     printf("Survivors list address: %p\n", (void*)survivors);
@@ -33,89 +234,21 @@ void *survivor_generator(void *args) {
     printf("Survivors list current elements: %d\n", survivors->number_of_elements);
 
     while (running) {
-        printf("\n=== Generating new survivor ===\n");
-        // Create coordinates within map bounds
-        Coord coord = {
-            .x = rand() % map.width,
-            .y = rand() % map.height
-        };
-        
-        // Generate unique survivor ID
-        char info[25];
-        snprintf(info, sizeof(info), "SURV-%04d", rand() % 10000);
-        printf("Generated survivor ID: %s at position (%d,%d)\n", info, coord.x, coord.y);
-        
-        // Get current time
-        time(&t);
-        localtime_r(&t, &discovery_time);
-
-        // Create survivor
-        printf("Creating survivor object...\n");
-        Survivor *s = create_survivor(&coord, info, &discovery_time);
-        if (!s) {
-            printf("Failed to create survivor\n");
-            continue;
-        }
-        printf("Survivor object created at %p\n", (void*)s);
-        printf("Survivor status: %d\n", s->status);
-        printf("Survivor coordinates: (%d,%d)\n", s->coord.x, s->coord.y);
-
-        // Add to global survivors list
-        printf("Adding survivor to global list...\n");
-        pthread_mutex_lock(&survivors->lock);
-        printf("Global list locked, current count: %d\n", survivors->number_of_elements);
-        printf("Global list head before add: %p\n", (void*)survivors->head);
-        Node *node = survivors->add(survivors, s);
-        printf("Add operation completed, new count: %d\n", survivors->number_of_elements);
-        printf("Global list head after add: %p\n", (void*)survivors->head);
-        printf("Added node address: %p\n", (void*)node);
-        pthread_mutex_unlock(&survivors->lock);
-        
-        if (!node) {
-            printf("Failed to add survivor to global list\n");
-            free(s);
-            continue;
-        }
-        printf("Successfully added to global list at node %p\n", (void*)node);
-
-        // Add to map cell's survivors list
-        printf("Adding survivor to map cell [%d][%d]...\n", coord.y, coord.x);
-        pthread_mutex_lock(&map.cells[coord.y][coord.x].survivors->lock);
-        printf("Map cell list locked, current count: %d\n", 
-               map.cells[coord.y][coord.x].survivors->number_of_elements);
-        node = map.cells[coord.y][coord.x].survivors->add(map.cells[coord.y][coord.x].survivors, s);
-        printf("Add operation completed, new count: %d\n", 
-               map.cells[coord.y][coord.x].survivors->number_of_elements);
-        pthread_mutex_unlock(&map.cells[coord.y][coord.x].survivors->lock);
-
-        if (!node) {
-            printf("Failed to add survivor to map cell\n");
-            pthread_mutex_lock(&survivors->lock);
-            survivors->removedata(survivors, s);
-            pthread_mutex_unlock(&survivors->lock);
-            free(s);
-            continue;
-        }
-        printf("Successfully added to map cell at node %p\n", (void*)node);
-
-        printf("Successfully created new survivor at (%d,%d): %s\n", coord.x, coord.y, info);
-        
-        // Sleep for 2-4 seconds before generating next survivor
-        int sleep_time = rand() % 3 + 2;
-        printf("Sleeping for %d seconds before next survivor...\n\n", sleep_time);
-        sleep(sleep_time);
+        sleep(generate_survivor());
     }
     printf("Survivor generator thread exiting\n");
     return NULL;
 }
 
+// Takes a survivor off its map cell once it has been helped. The caller
+// still owns the object.
 void survivor_cleanup(Survivor *s) {
     if (!s) return;
-    
-    pthread_mutex_lock(&map.cells[s->coord.x][s->coord.y].survivors->lock);
-    map.cells[s->coord.x][s->coord.y].survivors->removedata(map.cells[s->coord.x][s->coord.y].survivors, s);
-    pthread_mutex_unlock(&map.cells[s->coord.x][s->coord.y].survivors->lock);
-    
-    pthread_mutex_destroy(&s->lock);
-    free(s);
-}
\ No newline at end of file
+
+    uint64_t span = trace_start();
+    List *cell = map.cells[s->coord.y][s->coord.x].survivors;
+    lock_acquire(&cell->lock);
+    cell->removedata(cell, s);
+    lock_release(&cell->lock);
+    trace_span("survivor_cleanup", s->mission_id, span);
+}
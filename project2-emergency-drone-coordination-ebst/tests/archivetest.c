@@ -0,0 +1,122 @@
+/*archive: rows written through the delta + zigzag +
+varint encoding read back unchanged, across full
+and partial blocks and a reopened file*/
+
+#include "../headers/archive.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define TEST_ARCHIVE "archivetest.arc"
+#define NUM_ROWS (ARCHIVE_BLOCK_ROWS * 2 + 123)   // Two full blocks and a partial one
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// Row i: slowly growing IDs and times, as the server writes them, mixed
+// with jumps both ways and values needing every varint length
+static void make_row(int i, ArchiveRecord *r) {
+    static const int64_t extremes[] = {
+        0, 1, -1, 63, -64, 64, 8191, -8192, 1LL << 35, -(1LL << 35),
+        (1LL << 62) - 1, -(1LL << 62),
+    };
+    int n = sizeof(extremes) / sizeof(extremes[0]);
+    r->values[COL_MISSION_ID] = 1782439016284161LL + i;
+    r->values[COL_X] = i % 40;
+    r->values[COL_Y] = (i * 7) % 30;
+    r->values[COL_DRONE_ID] = extremes[i % n];
+    r->values[COL_DISCOVERED_MS] = 1704067200000LL + (int64_t)i * 250 - (i % 5) * 100000;
+    r->values[COL_HELPED_MS] = 1704067200000LL + (int64_t)i * 250;
+}
+
+typedef struct readback {
+    long rows;
+} Readback;
+
+static void check_row(const ArchiveRecord *record, void *ctx) {
+    Readback *rb = (Readback *)ctx;
+    ArchiveRecord expected;
+    make_row((int)(rb->rows % NUM_ROWS), &expected);  // The second copy starts over
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++) {
+        CHECK(record->values[c] == expected.values[c], "row %ld column %d: %lld, expected %lld",
+              rb->rows, c, (long long)record->values[c], (long long)expected.values[c]);
+    }
+    rb->rows++;
+}
+
+typedef struct inrange {
+    int64_t from_ms, to_ms;
+    long rows;
+} InRange;
+
+static void count_in_range(const ArchiveRecord *record, void *ctx) {
+    InRange *range = (InRange *)ctx;
+    int64_t helped = record->values[COL_HELPED_MS];
+    CHECK(helped >= range->from_ms && helped <= range->to_ms, "row helped at %lld is out of range",
+          (long long)helped);
+    range->rows++;
+}
+
+static void read_all(int expected_rows) {
+    ArchiveReader reader;
+    if (archive_reader_open(TEST_ARCHIVE, &reader) != 0) {
+        CHECK(0, "cannot read %s", TEST_ARCHIVE);
+        return;
+    }
+    Readback rb = { 0 };
+    archive_scan(&reader, ALL_COLUMNS, INT64_MIN, INT64_MAX, check_row, &rb);
+    archive_reader_close(&reader);
+    CHECK(rb.rows == expected_rows, "read %ld rows, expected %d", rb.rows, expected_rows);
+}
+
+static void write_rows() {
+    if (archive_open(TEST_ARCHIVE) != 0) {
+        CHECK(0, "cannot open %s", TEST_ARCHIVE);
+        return;
+    }
+    for (int i = 0; i < NUM_ROWS; i++) {
+        ArchiveRecord r;
+        make_row(i, &r);
+        CHECK(archive_append(&r) == 0, "append %d", i);
+    }
+    CHECK(archive_flush() == 0, "flush");
+    archive_close();
+}
+
+int main() {
+    unlink(TEST_ARCHIVE);
+
+    printf("\n\nwrite %d rows\n", NUM_ROWS);
+    write_rows();
+    read_all(NUM_ROWS);
+
+    printf("reopen and append the same rows again\n");
+    write_rows();
+    read_all(NUM_ROWS * 2);
+
+    printf("filter on helped time\n");
+    ArchiveReader reader;
+    if (archive_reader_open(TEST_ARCHIVE, &reader) == 0) {
+        ArchiveRecord first, last;
+        make_row(ARCHIVE_BLOCK_ROWS, &first);
+        make_row(ARCHIVE_BLOCK_ROWS + 9, &last);
+        InRange range = { first.values[COL_HELPED_MS], last.values[COL_HELPED_MS], 0 };
+        archive_scan(&reader, COLUMN_BIT(COL_HELPED_MS), range.from_ms, range.to_ms, count_in_range, &range);
+        // Ten rows from each copy
+        CHECK(range.rows == 20, "filtered %ld rows, expected 20", range.rows);
+        archive_reader_close(&reader);
+    }
+
+    unlink(TEST_ARCHIVE);
+    printf("%s: %d failure(s)\n", failures ? "FAILED" : "passed", failures);
+    return failures != 0;
+}
@@ -0,0 +1,97 @@
+/*mission index: insert, lookup, removal with
+backward shifting, growth and forget_drone*/
+
+#include "../headers/mission_index.h"
+#include "../headers/tour.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define NUM_MISSIONS 10000   // Enough to grow the table twice
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static Survivor survivors_table[NUM_MISSIONS];
+
+// IDs step by a large odd number so they spread over every bit, the way
+// lookups see them, and none is MISSION_ID_EMPTY
+static uint64_t mission(int i) {
+    return 1782439016284161ULL + (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+}
+
+int main() {
+    if (mission_index_init() != 0) return 1;
+    MissionEntry entry;
+
+    printf("\n\ninsert %d missions\n", NUM_MISSIONS);
+    for (int i = 0; i < NUM_MISSIONS; i++) {
+        CHECK(mission_index_insert(mission(i), &survivors_table[i]) == 0, "insert %d", i);
+    }
+    CHECK(mission_index_count() == NUM_MISSIONS, "count %llu", (unsigned long long)mission_index_count());
+    CHECK(mission_index_insert(mission(7), &survivors_table[7]) != 0, "duplicate insert accepted");
+    CHECK(mission_index_insert(MISSION_ID_EMPTY, &survivors_table[0]) != 0, "empty ID accepted");
+    for (int i = 0; i < NUM_MISSIONS; i++) {
+        CHECK(mission_index_lookup(mission(i), &entry) == 0 && entry.survivor == &survivors_table[i] &&
+              entry.drone == NULL, "lookup %d after growth", i);
+    }
+
+    printf("remove every third mission\n");
+    for (int i = 0; i < NUM_MISSIONS; i += 3) {
+        CHECK(mission_index_remove(mission(i), &entry) == 0 && entry.survivor == &survivors_table[i],
+              "remove %d", i);
+        CHECK(mission_index_remove(mission(i), NULL) != 0, "second remove of %d", i);
+    }
+    // Backward shifting must leave every later entry of a probe run reachable
+    for (int i = 0; i < NUM_MISSIONS; i++) {
+        int found = mission_index_lookup(mission(i), &entry) == 0;
+        CHECK(found == (i % 3 != 0), "lookup %d after removals", i);
+        if (found) CHECK(entry.survivor == &survivors_table[i], "survivor of %d", i);
+    }
+
+    printf("reinsert the removed missions into the freed slots\n");
+    for (int i = 0; i < NUM_MISSIONS; i += 3) {
+        CHECK(mission_index_insert(mission(i), &survivors_table[i]) == 0, "reinsert %d", i);
+    }
+    CHECK(mission_index_count() == NUM_MISSIONS, "count after reinsert %llu",
+          (unsigned long long)mission_index_count());
+    for (int i = 0; i < NUM_MISSIONS; i++) {
+        CHECK(mission_index_lookup(mission(i), &entry) == 0 && entry.survivor == &survivors_table[i],
+              "lookup %d after reinsert", i);
+    }
+
+    printf("forget a drone with two of its three stops pending\n");
+    Drone drone = { .id = 1 }, other = { .id = 2 };
+    drone.tour.count = 3;
+    drone.pending_stops = 2;
+    for (int i = 0; i < 3; i++) {
+        drone.tour.stops[i].id = mission(i + 1);
+        lock_init(&survivors_table[i + 1].lock, "survivor", 0);
+        survivors_table[i + 1].status = ASSIGNED;
+    }
+    mission_index_set_drone(mission(1), &drone);   // Completed stop, left alone
+    mission_index_set_drone(mission(2), &drone);
+    mission_index_set_drone(mission(3), &other);   // Already handed to another drone
+    lock_init(&drone.lock, "drone", 0);
+    lock_acquire(&drone.lock);
+    mission_index_forget_drone(&drone);
+    lock_release(&drone.lock);
+
+    CHECK(mission_index_lookup(mission(1), &entry) == 0 && entry.drone == &drone, "completed stop touched");
+    CHECK(survivors_table[1].status == ASSIGNED, "completed stop released");
+    CHECK(mission_index_lookup(mission(2), &entry) == 0 && entry.drone == NULL, "pending stop kept its drone");
+    CHECK(survivors_table[2].status == WAITING, "pending stop not waiting");
+    CHECK(mission_index_lookup(mission(3), &entry) == 0 && entry.drone == &other, "other drone's stop taken");
+    CHECK(survivors_table[3].status == ASSIGNED, "other drone's stop released");
+
+    mission_index_destroy();
+    printf("%s: %d failure(s)\n", failures ? "FAILED" : "passed", failures);
+    return failures != 0;
+}
@@ -0,0 +1,88 @@
+/*tour planner: plan_tour keeps every stop, never
+does worse than nearest-neighbour and leaves no
+segment reversal that would shorten the path*/
+
+#include "../headers/tour.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define NUM_TOURS 20000
+#define MAP_SIZE 40
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// Same construction as plan_tour, without the 2-opt passes
+static int nearest_neighbour_length(Coord start, Tour tour) {
+    Coord current = start;
+    for (int i = 0; i < tour.count; i++) {
+        int best = i;
+        for (int j = i + 1; j < tour.count; j++) {
+            if (travel_distance(current, tour.stops[j].coord) <
+                travel_distance(current, tour.stops[best].coord)) best = j;
+        }
+        TourStop tmp = tour.stops[i];
+        tour.stops[i] = tour.stops[best];
+        tour.stops[best] = tmp;
+        current = tour.stops[i].coord;
+    }
+    return tour_length(start, &tour);
+}
+
+// Length after reversing stops i..k
+static int reversed_length(Coord start, Tour tour, int i, int k) {
+    for (; i < k; i++, k--) {
+        TourStop tmp = tour.stops[i];
+        tour.stops[i] = tour.stops[k];
+        tour.stops[k] = tmp;
+    }
+    return tour_length(start, &tour);
+}
+
+int main() {
+    srand(1);
+    printf("\n\nplan %d random tours\n", NUM_TOURS);
+    for (int t = 0; t < NUM_TOURS; t++) {
+        Coord start = { rand() % MAP_SIZE, rand() % MAP_SIZE };
+        Tour tour = { .count = 1 + rand() % MAX_TOUR_STOPS };
+        for (int i = 0; i < tour.count; i++) {
+            tour.stops[i].coord.x = rand() % MAP_SIZE;
+            tour.stops[i].coord.y = rand() % MAP_SIZE;
+            tour.stops[i].id = (uint64_t)i + 1;
+        }
+        Tour planned = tour;
+        plan_tour(start, &planned);
+        int length = tour_length(start, &planned);
+
+        // The same stops, each once
+        CHECK(planned.count == tour.count, "tour %d lost stops", t);
+        unsigned seen = 0;
+        for (int i = 0; i < planned.count; i++) {
+            uint64_t id = planned.stops[i].id;
+            CHECK(id >= 1 && id <= (uint64_t)tour.count && !(seen & (1u << id)), "tour %d stop %d", t, i);
+            seen |= 1u << id;
+            CHECK(planned.stops[i].coord.x == tour.stops[id - 1].coord.x &&
+                  planned.stops[i].coord.y == tour.stops[id - 1].coord.y, "tour %d stop moved", t);
+        }
+
+        int nn = nearest_neighbour_length(start, tour);
+        CHECK(length <= nn, "tour %d: 2-opt lengthened %d to %d", t, nn, length);
+        for (int i = 0; i < planned.count - 1; i++) {
+            for (int k = i + 1; k < planned.count; k++) {
+                CHECK(reversed_length(start, planned, i, k) >= length,
+                      "tour %d: reversing %d..%d still shortens it", t, i, k);
+            }
+        }
+    }
+
+    printf("%s: %d failure(s)\n", failures ? "FAILED" : "passed", failures);
+    return failures != 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "headers/tour.h"
+#include "headers/survivor.h"
+#include "headers/globals.h"
+
+// Drones step diagonally, so the flight time between two cells is the
+// larger of the two axis differences, not their sum.
+int travel_distance(Coord a, Coord b) {
+    int dx = abs(a.x - b.x);
+    int dy = abs(a.y - b.y);
+    return dx > dy ? dx : dy;
+}
+
+int tour_length(Coord start, const Tour *tour) {
+    int length = 0;
+    Coord prev = start;
+    for (int i = 0; i < tour->count; i++) {
+        length += travel_distance(prev, tour->stops[i].coord);
+        prev = tour->stops[i].coord;
+    }
+    return length;
+}
+
+// Reserve the first WAITING survivor (after skipping `skip` of them) and
+// every other WAITING survivor needing the same aid within
+// TOUR_CLUSTER_RADIUS of it. Reserved survivors are marked ASSIGNED so the
+// next pass of the AI controller skips them.
+int collect_tour(Tour *tour, int skip) {
+    tour->count = 0;
+    tour->payload[0] = '\0';
+
+    lock_acquire(&survivors->lock);
+    Node *node = survivors->head;
+    while (node != NULL && tour->count < MAX_TOUR_STOPS) {
+        Survivor *s = (Survivor *)node->data;
+        lock_acquire(&s->lock);
+        if (s->status == WAITING && tour->count == 0 && skip > 0) {
+            skip--;
+        } else if (s->status == WAITING &&
+                   (tour->count == 0 ||
+                    (strcmp(tour->payload, s->payload) == 0 &&
+                     travel_distance(tour->stops[0].coord, s->coord) <= TOUR_CLUSTER_RADIUS))) {
+            if (tour->count == 0) {
+                snprintf(tour->payload, sizeof(tour->payload), "%s", s->payload);
+            }
+            TourStop *stop = &tour->stops[tour->count++];
+            stop->coord = s->coord;
+            stop->survivor = s;
+            stop->id = s->mission_id;
+            snprintf(stop->mission_id, sizeof(stop->mission_id), "%" PRIu64, s->mission_id);
+            s->status = ASSIGNED;
+        }
+        lock_release(&s->lock);
+        node = node->next;
+    }
+    lock_release(&survivors->lock);
+
+    if (tour->count > 1) {
+        printf("Grouped %d survivors around (%d,%d) into one tour\n",
+               tour->count, tour->stops[0].coord.x, tour->stops[0].coord.y);
+    }
+    return tour->count;
+}
+
+// Hand reserved survivors back to the WAITING pool (no drone available)
+void release_tour(Tour *tour) {
+    for (int i = 0; i < tour->count; i++) {
+        Survivor *s = tour->stops[i].survivor;
+        if (!s) continue;
+        lock_acquire(&s->lock);
+        s->status = WAITING;
+        lock_release(&s->lock);
+    }
+    tour->count = 0;
+}
+
+static void reverse_stops(Tour *tour, int i, int k) {
+    while (i < k) {
+        TourStop tmp = tour->stops[i];
+        tour->stops[i] = tour->stops[k];
+        tour->stops[k] = tmp;
+        i++;
+        k--;
+    }
+}
+
+// Order the stops of an open path that starts at the drone's position:
+// nearest-neighbour construction followed by 2-opt until no segment
+// reversal shortens the path. Tours are tiny (MAX_TOUR_STOPS), so the
+// O(n^2) passes cost nothing next to one extra cell of flight.
+void plan_tour(Coord start, Tour *tour) {
+    int n = tour->count;
+    if (n < 2) return;
+
+    Coord current = start;
+    for (int i = 0; i < n; i++) {
+        int best = i;
+        int best_dist = travel_distance(current, tour->stops[i].coord);
+        for (int j = i + 1; j < n; j++) {
+            int dist = travel_distance(current, tour->stops[j].coord);
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = j;
+            }
+        }
+        if (best != i) {
+            TourStop tmp = tour->stops[i];
+            tour->stops[i] = tour->stops[best];
+            tour->stops[best] = tmp;
+        }
+        current = tour->stops[i].coord;
+    }
+
+    int before = tour_length(start, tour);
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        for (int i = 0; i < n - 1; i++) {
+            Coord prev = (i == 0) ? start : tour->stops[i - 1].coord;
+            for (int k = i + 1; k < n; k++) {
+                int delta = travel_distance(prev, tour->stops[k].coord)
+                          - travel_distance(prev, tour->stops[i].coord);
+                if (k + 1 < n) {
+                    delta += travel_distance(tour->stops[i].coord, tour->stops[k + 1].coord)
+                           - travel_distance(tour->stops[k].coord, tour->stops[k + 1].coord);
+                }
+                if (delta < 0) {
+                    reverse_stops(tour, i, k);
+                    improved = 1;
+                }
+            }
+        }
+    }
+
+    printf("Planned %d-stop tour from (%d,%d): length %d (nearest-neighbour %d)\n",
+           n, start.x, start.y, tour_length(start, tour), before);
+}
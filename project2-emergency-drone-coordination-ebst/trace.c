@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "headers/trace.h"
+
+// Each recording thread appends to its own ring, so recording takes no
+// lock and shares no cache line. A ring starts small and doubles up to
+// TRACE_RING_MAX, then keeps the newest events. When its thread exits the
+// ring is kept, events and all, for the next new thread to continue.
+typedef struct tracering {
+    int tid;                  // Track number in the exported trace
+    char name[32];
+    TraceEvent *events;
+    uint64_t capacity;
+    uint64_t head;            // Events ever written; published with release
+    int in_use;
+    struct tracering *next;
+} TraceRing;
+
+int tracing = 0;
+
+static TraceRing *rings = NULL;
+static int num_rings = 0;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;  // List, reuse and growth
+static pthread_key_t ring_key;
+static __thread TraceRing *my_ring = NULL;
+
+static void retire_ring(void *arg) {
+    TraceRing *ring = arg;
+    pthread_mutex_lock(&rings_lock);
+    ring->in_use = 0;
+    pthread_mutex_unlock(&rings_lock);
+}
+
+// Like lock profiling, only switched on at startup, before the threads
+// that record exist
+void trace_enable() {
+    if (pthread_key_create(&ring_key, retire_ring) != 0) {
+        printf("Failed to enable tracing\n");
+        return;
+    }
+    tracing = 1;
+    printf("Mission tracing enabled\n");
+}
+
+static TraceRing *thread_ring() {
+    if (my_ring) return my_ring;
+
+    pthread_mutex_lock(&rings_lock);
+    TraceRing *ring = rings;
+    while (ring && ring->in_use) ring = ring->next;
+    if (!ring) {
+        ring = calloc(1, sizeof(TraceRing));
+        if (ring) ring->events = malloc(sizeof(TraceEvent) * TRACE_RING_MIN);
+        if (!ring || !ring->events) {
+            free(ring);
+            pthread_mutex_unlock(&rings_lock);
+            return NULL;
+        }
+        ring->capacity = TRACE_RING_MIN;
+        ring->tid = ++num_rings;
+        snprintf(ring->name, sizeof(ring->name), "thread %d", ring->tid);
+        ring->next = rings;
+        rings = ring;
+    }
+    ring->in_use = 1;
+    pthread_mutex_unlock(&rings_lock);
+
+    pthread_setspecific(ring_key, ring);
+    my_ring = ring;
+    return ring;
+}
+
+// Names the calling thread's track in the trace
+void trace_thread_name(const char *name) {
+    if (!tracing) return;
+    TraceRing *ring = thread_ring();
+    if (!ring) return;
+    pthread_mutex_lock(&rings_lock);
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+    pthread_mutex_unlock(&rings_lock);
+}
+
+void trace_record(char phase, const char *name, uint64_t mission, uint64_t ts_ns, uint64_t dur_ns) {
+    TraceRing *ring = thread_ring();
+    if (!ring) return;
+    uint64_t head = ring->head;
+
+    // Growing happens a handful of times per thread, under the lock so an
+    // export never reads a freed array
+    if (head == ring->capacity && ring->capacity < TRACE_RING_MAX) {
+        pthread_mutex_lock(&rings_lock);
+        TraceEvent *grown = realloc(ring->events, sizeof(TraceEvent) * ring->capacity * 2);
+        if (grown) {
+            ring->events = grown;
+            ring->capacity *= 2;
+        }
+        pthread_mutex_unlock(&rings_lock);
+    }
+
+    TraceEvent *event = &ring->events[head % ring->capacity];
+    event->name = name;
+    event->mission = mission;
+    event->ts_ns = ts_ns;
+    event->dur_ns = dur_ns;
+    event->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void write_event(FILE *out, int tid, const TraceEvent *e, int *first) {
+    fprintf(out, "%s\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+            *first ? "" : ",", e->phase, e->name, tid, e->ts_ns / 1e3);
+    *first = 0;
+    if (e->phase == 'X') {
+        fprintf(out, ",\"dur\":%.3f,\"cat\":\"server\"", e->dur_ns / 1e3);
+    } else {
+        // Stage events of one mission pair up by id into its own track
+        fprintf(out, ",\"cat\":\"mission\",\"id\":\"0x%llx\"", (unsigned long long)e->mission);
+    }
+    // As a string: mission IDs don't fit a JSON number
+    if (e->mission) fprintf(out, ",\"args\":{\"mission\":\"%llu\"}", (unsigned long long)e->mission);
+    fputc('}', out);
+}
+
+// Writes every ring in the Chrome trace event format, which Perfetto and
+// chrome://tracing open directly. Timestamps are sim_now_ns(), so a trace
+// from simulate is in virtual time. Recording goes on meanwhile; an event
+// overwritten while it is copied can come out garbled, never out of bounds.
+void trace_write(FILE *out) {
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    int first = 1;
+    pthread_mutex_lock(&rings_lock);
+    for (TraceRing *ring = rings; ring; ring = ring->next) {
+        fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}", first ? "" : ",", ring->tid, ring->name);
+        first = 0;
+
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t oldest = head > ring->capacity ? head - ring->capacity : 0;
+        for (uint64_t i = oldest; i < head; i++) {
+            TraceEvent e = ring->events[i % ring->capacity];
+            if (e.name) write_event(out, ring->tid, &e, &first);
+        }
+    }
+    pthread_mutex_unlock(&rings_lock);
+    fprintf(out, "\n]}\n");
+}
+
+int trace_save(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror("Failed to open trace file");
+        return 1;
+    }
+    trace_write(out);
+    fclose(out);
+    printf("Trace written to %s\n", path);
+    return 0;
+}
@@ -1,15 +1,20 @@
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "headers/view.h"
 #include "headers/drone.h"
-#include "headers/map.h"
 #include "headers/survivor.h"
-#include "headers/globals.h"
 #include <pthread.h>
-#include <time.h>
 
-#define CELL_SIZE 30  // Make cells bigger
+#define CELL_SIZE 30          // Pixels per cell at the default zoom
+#define MAX_WINDOW_WIDTH 1280
+#define MAX_WINDOW_HEIGHT 960
+#define MAX_CELL_SIZE 120     // Closest zoom
+#define MIN_DETAIL_CELL 6     // Zoomed out past this, draw density tiles
+#define TILE_PIXELS 8         // Smallest density tile on screen
+#define ZOOM_STEP 1.25        // Per wheel notch or +/- key
+#define PAN_STEP 0.1          // Fraction of the window per arrow key
 
 // SDL variables
 SDL_Window* window = NULL;
@@ -29,300 +34,666 @@ const SDL_Color BLUE = {0, 0, 255, 255};      // Pure bright blue
 const SDL_Color YELLOW = {255, 255, 0, 255};  // Pure bright yellow
 const SDL_Color GRID_COLOR = {128, 128, 128, 255}; // Brighter grid
 
-void draw_cell(int x, int y, SDL_Color color) {
-    if (!renderer) {
-        printf("Cannot draw cell: renderer is NULL\n");
-        return;
+// The window shows a viewport onto the map: scale is pixels per cell and
+// origin the map cell at the window's top-left corner. At MIN_DETAIL_CELL
+// pixels per cell and above every cell is drawn, snapped to whole pixels;
+// below it the map is drawn as density tiles that count the drones and
+// survivors in each block of cells. Either way only what is on screen is
+// drawn, so a city-sized map costs what the window does.
+typedef struct viewport {
+    double scale;
+    double origin_x, origin_y;
+    int map_width, map_height;
+    int changed;  // Moved or zoomed since the scene was drawn
+} Viewport;
+
+static Viewport view;
+static int drag_panning = 0;
+
+// Derived from the viewport before each redraw
+static int detail;              // Cells rather than density tiles
+static int cell_px;             // Detail mode: whole pixels per cell
+static int offset_x, offset_y;  // Detail mode: pixel position of cell (0,0)
+static int first_x, first_y, last_x, last_y;  // Visible cells, last exclusive
+static int block;               // Density mode: cells per tile side
+
+// Entities are queued per color and submitted with one SDL_RenderFillRects
+// call per color, then one SDL_RenderDrawRects for every white border, so a
+// frame costs a handful of draw calls however many drones and survivors it
+// holds. The arrays grow to the largest frame seen and are then reused.
+typedef enum {
+    COLOR_BLACK,  // Clears a cell back to the background
+    COLOR_WHITE,
+    COLOR_RED,
+    COLOR_GREEN,
+    COLOR_BLUE,
+    COLOR_YELLOW,
+    NUM_BATCH_COLORS
+} BatchColor;
+
+// Density tiles are shaded by survivor count (red) and drone count (blue),
+// each on a log scale of TILE_LEVELS steps, with one batch per shade
+#define TILE_LEVELS 5
+#define NUM_TILE_SHADES (TILE_LEVELS * TILE_LEVELS)
+
+typedef struct rectbatch {
+    SDL_Rect *rects;
+    int count, capacity;
+} RectBatch;
+
+static RectBatch fills[NUM_BATCH_COLORS];
+static RectBatch borders;
+static RectBatch tiles[NUM_TILE_SHADES];
+static int *tile_counts = NULL;  // Survivors then drones per visible tile
+static int tile_counts_size = 0;
+static SDL_Texture *grid_texture = NULL;  // Grid lines for the current viewport
+static int grid_valid = 0;
+static int no_targets = 0;  // Creating a render target failed; don't try again
+static SDL_Texture *scene = NULL;  // Grid and cells as of the frame in drawn
+static Frame drawn;
+static unsigned char *dirty = NULL;
+static int *dirty_list = NULL;
+static int num_dirty = 0;
+
+static const SDL_Color *batch_color(BatchColor color) {
+    switch (color) {
+        case COLOR_BLACK: return &BLACK;
+        case COLOR_WHITE: return &WHITE;
+        case COLOR_RED: return &RED;
+        case COLOR_GREEN: return &GREEN;
+        case COLOR_BLUE: return &BLUE;
+        default: return &YELLOW;
+    }
+}
+
+static SDL_Rect *batch_push(RectBatch *batch) {
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity ? batch->capacity * 2 : 256;
+        SDL_Rect *grown = realloc(batch->rects, capacity * sizeof(SDL_Rect));
+        if (!grown) return NULL;
+        batch->rects = grown;
+        batch->capacity = capacity;
     }
+    return &batch->rects[batch->count++];
+}
 
-    // Make cells MUCH bigger and more visible
-    SDL_Rect rect = {
-        .x = x * CELL_SIZE + 2,         // Add padding
-        .y = y * CELL_SIZE + 2,         // Add padding
-        .w = CELL_SIZE - 4,             // Slightly smaller for visibility
-        .h = CELL_SIZE - 4              // Slightly smaller for visibility
-    };
-    
-    // Draw the colored cell
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderFillRect(renderer, &rect);
-    
-    // Draw thick white border
-    SDL_SetRenderDrawColor(renderer, WHITE.r, WHITE.g, WHITE.b, WHITE.a);
-    
-    // Draw multiple lines for thicker border
+// Smallest scale at which the whole map still fills the window
+static double fit_scale() {
+    if (view.map_width <= 0 || view.map_height <= 0) return CELL_SIZE;
+    double sx = (double)window_width / view.map_width;
+    double sy = (double)window_height / view.map_height;
+    return sx < sy ? sx : sy;
+}
+
+// Keep the map on screen: no panning past its edges, and a map smaller
+// than the window stays at the top-left
+static void clamp_view() {
+    double min_scale = fit_scale();
+    if (min_scale > MAX_CELL_SIZE) min_scale = MAX_CELL_SIZE;
+    if (view.scale < min_scale) view.scale = min_scale;
+    if (view.scale > MAX_CELL_SIZE) view.scale = MAX_CELL_SIZE;
+    double max_x = view.map_width - window_width / view.scale;
+    double max_y = view.map_height - window_height / view.scale;
+    if (view.origin_x > max_x) view.origin_x = max_x;
+    if (view.origin_y > max_y) view.origin_y = max_y;
+    if (view.origin_x < 0) view.origin_x = 0;
+    if (view.origin_y < 0) view.origin_y = 0;
+    view.changed = 1;
+}
+
+// Default zoom if the whole map fits at it, otherwise the whole map
+static void fit_view() {
+    double fit = fit_scale();
+    view.scale = fit < CELL_SIZE ? fit : CELL_SIZE;
+    if (view.scale >= MIN_DETAIL_CELL) view.scale = (int)view.scale;
+    view.origin_x = 0;
+    view.origin_y = 0;
+    clamp_view();
+}
+
+// Zoom by steps, keeping the map point under (x, y) in place. Detail
+// zoom moves by at least a whole pixel per cell.
+static void zoom_at(int x, int y, int steps) {
+    double world_x = view.origin_x + x / view.scale;
+    double world_y = view.origin_y + y / view.scale;
+    for (int i = 0; i < abs(steps); i++) {
+        double next = steps > 0 ? view.scale * ZOOM_STEP : view.scale / ZOOM_STEP;
+        if (next >= MIN_DETAIL_CELL) {
+            next = (int)(next + 0.5);
+            if (steps > 0 && next <= view.scale) next = (int)view.scale + 1;
+            if (steps < 0 && next >= view.scale) next = (int)view.scale - 1;
+        }
+        view.scale = next;
+    }
+    clamp_view();
+    view.origin_x = world_x - x / view.scale;
+    view.origin_y = world_y - y / view.scale;
+    clamp_view();
+}
+
+static void pan_by(double dx_pixels, double dy_pixels) {
+    view.origin_x += dx_pixels / view.scale;
+    view.origin_y += dy_pixels / view.scale;
+    clamp_view();
+}
+
+// Mouse wheel zooms at the cursor, left-drag pans; +/- zoom at the centre,
+// arrow keys pan and 0 or r fits the whole map. Returns 1 if the event was used.
+int view_handle_event(const SDL_Event *event) {
+    int x, y;
+    switch (event->type) {
+        case SDL_MOUSEWHEEL:
+            SDL_GetMouseState(&x, &y);
+            if (event->wheel.y != 0) zoom_at(x, y, event->wheel.y > 0 ? 1 : -1);
+            return 1;
+        case SDL_MOUSEBUTTONDOWN:
+            if (event->button.button == SDL_BUTTON_LEFT) drag_panning = 1;
+            return 1;
+        case SDL_MOUSEBUTTONUP:
+            if (event->button.button == SDL_BUTTON_LEFT) drag_panning = 0;
+            return 1;
+        case SDL_MOUSEMOTION:
+            if (drag_panning && (event->motion.state & SDL_BUTTON_LMASK)) {
+                pan_by(-event->motion.xrel, -event->motion.yrel);
+            }
+            return 1;
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+                case SDLK_PLUS:
+                case SDLK_EQUALS: zoom_at(window_width / 2, window_height / 2, 1); return 1;
+                case SDLK_MINUS: zoom_at(window_width / 2, window_height / 2, -1); return 1;
+                case SDLK_LEFT: pan_by(-window_width * PAN_STEP, 0); return 1;
+                case SDLK_RIGHT: pan_by(window_width * PAN_STEP, 0); return 1;
+                case SDLK_UP: pan_by(0, -window_height * PAN_STEP); return 1;
+                case SDLK_DOWN: pan_by(0, window_height * PAN_STEP); return 1;
+                case SDLK_0:
+                case SDLK_r: fit_view(); return 1;
+                default: return 0;
+            }
+        default:
+            return 0;
+    }
+}
+
+static int clampi(int value, int low, int high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+// Work out the pixel geometry of the viewport for this redraw
+static void layout_view() {
+    detail = view.scale >= MIN_DETAIL_CELL;
+    if (detail) {
+        cell_px = (int)(view.scale + 0.5);
+        offset_x = -(int)(view.origin_x * cell_px + 0.5);
+        offset_y = -(int)(view.origin_y * cell_px + 0.5);
+        first_x = clampi(-offset_x / cell_px, 0, view.map_width);
+        first_y = clampi(-offset_y / cell_px, 0, view.map_height);
+        last_x = clampi((window_width - offset_x + cell_px - 1) / cell_px, 0, view.map_width);
+        last_y = clampi((window_height - offset_y + cell_px - 1) / cell_px, 0, view.map_height);
+    } else {
+        block = (int)(TILE_PIXELS / view.scale + 0.999);
+        if (block < 1) block = 1;
+        // Whole tiles, so a tile's count never depends on where it is cut
+        first_x = clampi((int)view.origin_x / block * block, 0, view.map_width);
+        first_y = clampi((int)view.origin_y / block * block, 0, view.map_height);
+        last_x = clampi((int)(view.origin_x + window_width / view.scale) + 1, 0, view.map_width);
+        last_y = clampi((int)(view.origin_y + window_height / view.scale) + 1, 0, view.map_height);
+    }
+}
+
+static int cell_visible(int x, int y) {
+    return x >= first_x && x < last_x && y >= first_y && y < last_y;
+}
+
+// Queue a cell: padded fill in its color plus, when cells are big enough
+// to show it, a two-pixel white border
+static void queue_cell(int x, int y, BatchColor color) {
+    int px = offset_x + x * cell_px;
+    int py = offset_y + y * cell_px;
+    int pad = cell_px >= 12 ? 2 : 1;
+    SDL_Rect *rect = batch_push(&fills[color]);
+    if (!rect) return;
+    rect->x = px + pad;
+    rect->y = py + pad;
+    rect->w = cell_px - 2 * pad;
+    rect->h = cell_px - 2 * pad;
+    if (cell_px < 12) return;
     for (int i = 0; i < 2; i++) {
-        SDL_Rect border = {
-            .x = rect.x - i,
-            .y = rect.y - i,
-            .w = rect.w + (2 * i),
-            .h = rect.h + (2 * i)
-        };
-        SDL_RenderDrawRect(renderer, &border);
+        SDL_Rect *border = batch_push(&borders);
+        if (!border) return;
+        border->x = px + pad - i;
+        border->y = py + pad - i;
+        border->w = cell_px - 2 * pad + 2 * i;
+        border->h = cell_px - 2 * pad + 2 * i;
     }
 }
 
-void draw_grid() {
-    if (!renderer) {
-        printf("Cannot draw grid: renderer is NULL\n");
-        return;
+// Submit everything queued since the last flush
+static void flush_cells() {
+    for (int c = 0; c < NUM_BATCH_COLORS; c++) {
+        if (fills[c].count == 0) continue;
+        const SDL_Color *color = batch_color(c);
+        SDL_SetRenderDrawColor(renderer, color->r, color->g, color->b, color->a);
+        SDL_RenderFillRects(renderer, fills[c].rects, fills[c].count);
+        fills[c].count = 0;
+    }
+    if (borders.count > 0) {
+        SDL_SetRenderDrawColor(renderer, WHITE.r, WHITE.g, WHITE.b, WHITE.a);
+        SDL_RenderDrawRects(renderer, borders.rects, borders.count);
+        borders.count = 0;
     }
+}
 
-    printf("Drawing grid: map dimensions %dx%d, window dimensions %dx%d\n", 
-           map.width, map.height, window_width, window_height);
-    
+// Visible grid lines only, clipped to the map
+static void draw_grid_lines() {
+    int top = clampi(offset_y, 0, window_height);
+    int bottom = clampi(offset_y + view.map_height * cell_px, 0, window_height);
+    int left = clampi(offset_x, 0, window_width);
+    int right = clampi(offset_x + view.map_width * cell_px, 0, window_width);
     SDL_SetRenderDrawColor(renderer, GRID_COLOR.r, GRID_COLOR.g, GRID_COLOR.b, GRID_COLOR.a);
-    
-    // Draw vertical lines
-    for (int x = 0; x <= map.width; x++) {
-        printf("Drawing vertical line at x=%d (screen_x=%d)\n", x, x * CELL_SIZE);
-        SDL_RenderDrawLine(renderer, x * CELL_SIZE, 0, x * CELL_SIZE, window_height);
+    for (int x = first_x; x <= last_x; x++) {
+        SDL_RenderDrawLine(renderer, offset_x + x * cell_px, top, offset_x + x * cell_px, bottom);
     }
-    
-    // Draw horizontal lines
-    for (int y = 0; y <= map.height; y++) {
-        printf("Drawing horizontal line at y=%d (screen_y=%d)\n", y, y * CELL_SIZE);
-        SDL_RenderDrawLine(renderer, 0, y * CELL_SIZE, window_width, y * CELL_SIZE);
+    for (int y = first_y; y <= last_y; y++) {
+        SDL_RenderDrawLine(renderer, left, offset_y + y * cell_px, right, offset_y + y * cell_px);
     }
-    
-    printf("Grid drawing complete\n");
 }
 
-void draw_drones() {
-    if (!renderer) {
-        printf("Cannot draw drones: renderer is NULL\n");
-        return;
+// A render target texture in window coordinates. SDL draws into targets
+// at scale 1, so these are sized in logical pixels and stretched to the
+// display when copied out. A failure is remembered, so a renderer
+// without targets is asked (and the fallback logged) only once.
+static SDL_Texture *create_target() {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                             window_width, window_height);
+    if (!texture) {
+        no_targets = 1;
+        return NULL;
     }
-    
-    printf("\n=== Drawing Drones ===\n");
-    
-    // First, collect all drone data under lock
-    typedef struct {
-        Coord coord;
-        Coord target;
-        int status;
-    } DroneSnapshot;
-    
-    DroneSnapshot* snapshots = NULL;
-    int count = 0;
-    
-    // Lock the drones list for the entire duration of data collection
-    pthread_mutex_lock(&drones->lock);
-    
-    // Create a local copy of all drones
-    Node* node = drones->head;
-    while (node != NULL) {
-        snapshots = realloc(snapshots, (count + 1) * sizeof(DroneSnapshot));
-        if (!snapshots) {
-            printf("Failed to allocate memory for drone snapshot\n");
-            pthread_mutex_unlock(&drones->lock);
-            return;
-        }
-        
-        Drone* d = (Drone*)node->data;
-        snapshots[count].coord = d->coord;
-        snapshots[count].target = d->target;
-        snapshots[count].status = d->status;
-        count++;
-        node = node->next;
+    // Not every renderer supports targets; find out now, not mid-frame
+    SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+    int usable = SDL_SetRenderTarget(renderer, texture) == 0;
+    SDL_SetRenderTarget(renderer, previous);
+    if (!usable) {
+        SDL_DestroyTexture(texture);
+        no_targets = 1;
+        return NULL;
     }
-    
-    // Release the lock after collecting all data
-    pthread_mutex_unlock(&drones->lock);
-    
-    printf("Found %d drones\n", count);
-    
-    // Now draw without holding any locks
-    printf("\nDrawing all drones...\n");
-    for (int i = 0; i < count; i++) {
-        // Draw drone with appropriate color
-        SDL_Color color = (snapshots[i].status == IDLE) ? BLUE : GREEN;
-        draw_cell(snapshots[i].coord.x, snapshots[i].coord.y, color);
-        
-        // Draw mission line if on mission
-        if (snapshots[i].status == ON_MISSION) {
-            SDL_SetRenderDrawColor(renderer, GREEN.r, GREEN.g, GREEN.b, GREEN.a);
-            SDL_RenderDrawLine(
-                renderer,
-                snapshots[i].coord.x * CELL_SIZE + CELL_SIZE / 2,
-                snapshots[i].coord.y * CELL_SIZE + CELL_SIZE / 2,
-                snapshots[i].target.x * CELL_SIZE + CELL_SIZE / 2,
-                snapshots[i].target.y * CELL_SIZE + CELL_SIZE / 2
-            );
+    return texture;
+}
+
+// Render the grid into a texture the first time (and whenever the viewport
+// changes); every later use is a single copy. Falls back to drawing the
+// lines if the renderer has no render targets.
+static int build_grid_texture() {
+    if (!grid_texture) {
+        if (no_targets) return 1;
+        grid_texture = create_target();
+        if (!grid_texture) {
+            printf("Grid texture unavailable, drawing grid lines each frame: %s\n", SDL_GetError());
+            return 1;
         }
     }
-    
-    free(snapshots);
-    printf("Finished drawing drones\n");
-    printf("=== Drones Complete ===\n\n");
+    SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, grid_texture);
+    SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, BLACK.a);
+    SDL_RenderClear(renderer);
+    draw_grid_lines();
+    SDL_SetRenderTarget(renderer, previous);
+    grid_valid = 1;
+    return 0;
 }
 
-void draw_survivors() {
+// Clears the current target to the background grid of the visible part
+// of a map this size
+void draw_grid(int width, int height) {
     if (!renderer) {
-        printf("Cannot draw survivors: renderer is NULL\n");
+        printf("Cannot draw grid: renderer is NULL\n");
         return;
     }
-    
-    printf("\n=== Drawing Survivors ===\n");
-    printf("Renderer status: %p\n", (void*)renderer);
-    
-    // First, collect all survivor data under lock
-    typedef struct {
-        Coord coord;
-        int status;
-    } SurvivorSnapshot;
-    
-    SurvivorSnapshot* snapshots = NULL;
-    int count = 0;
-    
-    // Get waiting survivors
-    printf("\nCollecting waiting survivors...\n");
-    printf("Survivors list address: %p\n", (void*)survivors);
-    
-    // Lock the survivors list for the entire duration of data collection
-    pthread_mutex_lock(&survivors->lock);
-    
-    // Create a local copy of all survivors
-    Node* node = survivors->head;
-    while (node != NULL) {
-        snapshots = realloc(snapshots, (count + 1) * sizeof(SurvivorSnapshot));
-        if (!snapshots) {
-            printf("Failed to allocate memory for survivor snapshot\n");
-            pthread_mutex_unlock(&survivors->lock);
-            return;
+
+    if (width != view.map_width || height != view.map_height) {
+        view.map_width = width;
+        view.map_height = height;
+        fit_view();
+        layout_view();
+        grid_valid = 0;
+    }
+    if (!detail) {
+        SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, BLACK.a);
+        SDL_RenderClear(renderer);
+        return;
+    }
+    if (!grid_valid) build_grid_texture();
+    if (grid_valid && SDL_RenderCopy(renderer, grid_texture, NULL, NULL) == 0) return;
+
+    SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, BLACK.a);
+    SDL_RenderClear(renderer);
+    draw_grid_lines();
+}
+
+// Cells touched since the scene was last brought up to date: a flag per
+// cell to test membership and a list to visit and reset only those. Only
+// visible cells are tracked; the rest are redrawn when panned into view.
+static int is_dirty(int x, int y) {
+    return cell_visible(x, y) && dirty[y * drawn.width + x];
+}
+
+static void mark_dirty(Coord c) {
+    if (!cell_visible(c.x, c.y)) return;
+    int cell = c.y * drawn.width + c.x;
+    if (dirty[cell]) return;
+    dirty[cell] = 1;
+    dirty_list[num_dirty++] = cell;
+}
+
+// Both frames are sorted, so one merge pass finds every entity that
+// appeared, vanished or changed; its old and new cells need redrawing
+static void mark_changes(const Frame *frame) {
+    int i = 0, j = 0;
+    while (i < drawn.num_drones || j < frame->num_drones) {
+        const FrameDrone *p = i < drawn.num_drones ? &drawn.drones[i] : NULL;
+        const FrameDrone *c = j < frame->num_drones ? &frame->drones[j] : NULL;
+        if (p && (!c || p->key < c->key)) {
+            mark_dirty(p->coord);
+            i++;
+        } else if (c && (!p || c->key < p->key)) {
+            mark_dirty(c->coord);
+            j++;
+        } else {
+            if (p->coord.x != c->coord.x || p->coord.y != c->coord.y || p->status != c->status) {
+                mark_dirty(p->coord);
+                mark_dirty(c->coord);
+            }
+            i++;
+            j++;
         }
-        
-        Survivor* s = (Survivor*)node->data;
-        snapshots[count].coord = s->coord;
-        snapshots[count].status = s->status;
-        count++;
-        node = node->next;
     }
-    
-    // Release the lock after collecting all data
-    pthread_mutex_unlock(&survivors->lock);
-    
-    printf("Found %d survivors\n", count);
-    
-    // Now draw without holding any locks
-    printf("\nDrawing all survivors...\n");
-    for (int i = 0; i < count; i++) {
-        SDL_Color color;
-        if (snapshots[i].status == WAITING) {
-            color = RED;
-            printf("Drawing waiting survivor at (%d,%d) in RED\n", 
-                   snapshots[i].coord.x, snapshots[i].coord.y);
-        } else if (snapshots[i].status == ASSIGNED) {
-            color = YELLOW;
-            printf("Drawing assigned survivor at (%d,%d) in YELLOW\n", 
-                   snapshots[i].coord.x, snapshots[i].coord.y);
-        } else { // HELPED
-            color = GREEN;
-            printf("Drawing helped survivor at (%d,%d) in GREEN\n", 
-                   snapshots[i].coord.x, snapshots[i].coord.y);
+
+    i = 0;
+    j = 0;
+    while (i < drawn.num_survivors || j < frame->num_survivors) {
+        const FrameSurvivor *p = i < drawn.num_survivors ? &drawn.survivors[i] : NULL;
+        const FrameSurvivor *c = j < frame->num_survivors ? &frame->survivors[j] : NULL;
+        if (p && (!c || p->id < c->id)) {
+            mark_dirty(p->coord);
+            i++;
+        } else if (c && (!p || c->id < p->id)) {
+            mark_dirty(c->coord);
+            j++;
+        } else {
+            if (p->coord.x != c->coord.x || p->coord.y != c->coord.y || p->status != c->status) {
+                mark_dirty(p->coord);
+                mark_dirty(c->coord);
+            }
+            i++;
+            j++;
         }
-        
-        draw_cell(snapshots[i].coord.x, snapshots[i].coord.y, color);
     }
-    
-    free(snapshots);
-    printf("Finished drawing survivors\n");
-    printf("=== Survivors Complete ===\n\n");
 }
 
-int draw_map() {
+// Queue the visible cells of every layer, bottom to top, flushing between
+// layers so drones stay on top. With only_dirty set, cells outside the
+// dirty set are skipped.
+static void draw_cells(const Frame *frame, int only_dirty) {
+    for (int i = 0; i < frame->num_stations; i++) {
+        const Coord *c = &frame->stations[i];
+        if (only_dirty ? is_dirty(c->x, c->y) : cell_visible(c->x, c->y)) queue_cell(c->x, c->y, COLOR_WHITE);
+    }
+    flush_cells();
+
+    for (int i = 0; i < frame->num_survivors; i++) {
+        const FrameSurvivor *s = &frame->survivors[i];
+        if (only_dirty ? !is_dirty(s->coord.x, s->coord.y) : !cell_visible(s->coord.x, s->coord.y)) continue;
+        BatchColor color = (s->status == WAITING) ? COLOR_RED :
+                           (s->status == ASSIGNED) ? COLOR_YELLOW : COLOR_GREEN;
+        queue_cell(s->coord.x, s->coord.y, color);
+    }
+    flush_cells();
+
+    for (int i = 0; i < frame->num_drones; i++) {
+        const FrameDrone *d = &frame->drones[i];
+        if (only_dirty ? !is_dirty(d->coord.x, d->coord.y) : !cell_visible(d->coord.x, d->coord.y)) continue;
+        BatchColor color = (d->status == IDLE) ? COLOR_BLUE :
+                           (d->status == CHARGING) ? COLOR_YELLOW : COLOR_GREEN;
+        queue_cell(d->coord.x, d->coord.y, color);
+    }
+    flush_cells();
+}
+
+static int tile_level(int count) {
+    int level = 0;
+    while (count > 0 && level < TILE_LEVELS - 1) {
+        level++;
+        count >>= 2;
+    }
+    return level;
+}
+
+// Zoomed out: one rect per visible block of cells that holds anything,
+// shaded by how many survivors and drones are in it, and a dot per station
+static void draw_density(const Frame *frame) {
+    int tiles_x = (last_x - first_x + block - 1) / block;
+    int tiles_y = (last_y - first_y + block - 1) / block;
+    int needed = 2 * tiles_x * tiles_y;
+    if (needed <= 0) return;
+    if (needed > tile_counts_size) {
+        int *grown = realloc(tile_counts, needed * sizeof(int));
+        if (!grown) return;
+        tile_counts = grown;
+        tile_counts_size = needed;
+    }
+    memset(tile_counts, 0, needed * sizeof(int));
+    int *survivor_counts = tile_counts;
+    int *drone_counts = tile_counts + tiles_x * tiles_y;
+
+    for (int i = 0; i < frame->num_survivors; i++) {
+        const Coord *c = &frame->survivors[i].coord;
+        if (!cell_visible(c->x, c->y)) continue;
+        survivor_counts[(c->y - first_y) / block * tiles_x + (c->x - first_x) / block]++;
+    }
+    for (int i = 0; i < frame->num_drones; i++) {
+        const Coord *c = &frame->drones[i].coord;
+        if (!cell_visible(c->x, c->y)) continue;
+        drone_counts[(c->y - first_y) / block * tiles_x + (c->x - first_x) / block]++;
+    }
+
+    for (int ty = 0; ty < tiles_y; ty++) {
+        int cell_y = first_y + ty * block;
+        int y0 = (int)((cell_y - view.origin_y) * view.scale);
+        int y1 = (int)((cell_y + block - view.origin_y) * view.scale);
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int t = ty * tiles_x + tx;
+            int shade = tile_level(survivor_counts[t]) * TILE_LEVELS + tile_level(drone_counts[t]);
+            if (shade == 0) continue;
+            int cell_x = first_x + tx * block;
+            SDL_Rect *rect = batch_push(&tiles[shade]);
+            if (!rect) continue;
+            rect->x = (int)((cell_x - view.origin_x) * view.scale);
+            rect->y = y0;
+            rect->w = (int)((cell_x + block - view.origin_x) * view.scale) - rect->x;
+            rect->h = y1 - y0;
+            if (rect->w < 1) rect->w = 1;
+            if (rect->h < 1) rect->h = 1;
+        }
+    }
+    for (int shade = 1; shade < NUM_TILE_SHADES; shade++) {
+        if (tiles[shade].count == 0) continue;
+        int level = TILE_LEVELS - 1;
+        SDL_SetRenderDrawColor(renderer, (shade / TILE_LEVELS) * 255 / level, 32,
+                               (shade % TILE_LEVELS) * 255 / level, 255);
+        SDL_RenderFillRects(renderer, tiles[shade].rects, tiles[shade].count);
+        tiles[shade].count = 0;
+    }
+
+    for (int i = 0; i < frame->num_stations; i++) {
+        const Coord *c = &frame->stations[i];
+        if (!cell_visible(c->x, c->y)) continue;
+        SDL_Rect *rect = batch_push(&fills[COLOR_WHITE]);
+        if (!rect) break;
+        rect->x = (int)((c->x + 0.5 - view.origin_x) * view.scale) - 2;
+        rect->y = (int)((c->y + 0.5 - view.origin_y) * view.scale) - 2;
+        rect->w = rect->h = 4;
+    }
+    flush_cells();
+}
+
+// Whether the line between two cell centres crosses the visible cells:
+// it misses them if all four corners of the visible area lie on one side
+static int segment_visible(Coord a, Coord b) {
+    double dx = b.x - a.x, dy = b.y - a.y;
+    int above = 0, below = 0;
+    for (int i = 0; i < 4; i++) {
+        double cx = ((i & 1) ? last_x : first_x) - (a.x + 0.5);
+        double cy = ((i & 2) ? last_y : first_y) - (a.y + 0.5);
+        double side = dx * cy - dy * cx;
+        if (side >= 0) above = 1;
+        if (side <= 0) below = 1;
+    }
+    return above && below;
+}
+
+// Mission lines cross many cells, so they are not part of the scene; they
+// are drawn over it each presented frame, skipping any that miss the
+// window. They are separate segments, which SDL2 can only draw one at a
+// time; the color is set once.
+static void draw_mission_lines(const Frame *frame) {
+    if (!detail) return;
+    SDL_SetRenderDrawColor(renderer, GREEN.r, GREEN.g, GREEN.b, GREEN.a);
+    for (int i = 0; i < frame->num_drones; i++) {
+        const FrameDrone *d = &frame->drones[i];
+        if (d->status != ON_MISSION) continue;
+        int min_x = d->coord.x < d->target.x ? d->coord.x : d->target.x;
+        int max_x = d->coord.x < d->target.x ? d->target.x : d->coord.x;
+        int min_y = d->coord.y < d->target.y ? d->coord.y : d->target.y;
+        int max_y = d->coord.y < d->target.y ? d->target.y : d->coord.y;
+        if (max_x < first_x || min_x >= last_x || max_y < first_y || min_y >= last_y) continue;
+        if (!segment_visible(d->coord, d->target)) continue;
+        SDL_RenderDrawLine(
+            renderer,
+            offset_x + d->coord.x * cell_px + cell_px / 2,
+            offset_y + d->coord.y * cell_px + cell_px / 2,
+            offset_x + d->target.x * cell_px + cell_px / 2,
+            offset_y + d->target.y * cell_px + cell_px / 2
+        );
+    }
+}
+
+// Everything visible, from scratch, into the current target
+static void draw_full(const Frame *frame) {
+    draw_grid(frame->width, frame->height);
+    if (detail) {
+        draw_cells(frame, 0);
+    } else {
+        draw_density(frame);
+    }
+}
+
+// Start a fresh scene for a map of this size: the target texture, the
+// dirty-cell bookkeeping and an empty record of what it shows
+static int reset_scene(int width, int height) {
+    if (scene) {
+        SDL_DestroyTexture(scene);
+        scene = NULL;
+    }
+    drawn.width = drawn.height = 0;
+    size_t cells = (size_t)width * height;
+    unsigned char *flags = realloc(dirty, cells ? cells : 1);
+    int *list = realloc(dirty_list, (cells ? cells : 1) * sizeof(int));
+    if (flags) dirty = flags;
+    if (list) dirty_list = list;
+    if (!flags || !list) return 1;
+    memset(dirty, 0, cells);
+    num_dirty = 0;
+
+    scene = create_target();
+    if (!scene) {
+        printf("Scene texture unavailable, redrawing every frame in full: %s\n", SDL_GetError());
+        return 1;
+    }
+    return 0;
+}
+
+// Draw one frame of world state. Works from the frame alone, so the same
+// code renders inside the server or in a remote viewer.
+//
+// The grid and every visible cell are kept in a persistent scene texture.
+// Each frame only the cells whose contents changed since the scene was
+// last updated are cleared and redrawn into it, and a frame with the same
+// sequence number as the last one is not redrawn or presented at all, so
+// steady-state cost follows how much moved rather than the map size.
+// Zooming, panning or a new map size redraws the visible part in full.
+int draw_frame(const Frame *frame) {
     if (!renderer) {
         printf("Cannot draw map: renderer is NULL\n");
         return 1;
     }
-    
-    printf("\n=== Drawing Map Frame ===\n");
-    
-    // Clear the screen with black
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    if (SDL_RenderClear(renderer) != 0) {
-        printf("Failed to clear renderer: %s\n", SDL_GetError());
-        return 1;
+
+    if (frame->width != view.map_width || frame->height != view.map_height) {
+        view.map_width = frame->width;
+        view.map_height = frame->height;
+        fit_view();
     }
-    printf("Screen cleared with black\n");
-    
-    // Draw grid first
-    printf("Drawing grid...\n");
-    draw_grid();
-    printf("Grid drawn\n");
-    
-    // Draw survivors and drones
-    printf("\n=== Drawing Game Objects ===\n");
-    printf("Drawing survivors...\n");
-    draw_survivors();
-    printf("Survivors drawn\n");
-    
-    printf("Drawing drones...\n");
-    draw_drones();
-    printf("Drones drawn\n");
-    
-    // Present the final frame only once at the end
-    printf("Presenting final frame...\n");
+    if (view.changed) {
+        layout_view();
+        grid_valid = 0;
+    }
+
+    int rebuild = view.changed;
+    if (!scene || frame->width != drawn.width || frame->height != drawn.height) {
+        if (no_targets || reset_scene(frame->width, frame->height) != 0) {
+            // No render targets: draw everything straight to the screen
+            view.changed = 0;
+            draw_full(frame);
+            draw_mission_lines(frame);
+            SDL_RenderPresent(renderer);
+            return 0;
+        }
+        rebuild = 1;
+    } else if (!rebuild && frame->seq == drawn.seq) {
+        return 0;  // Nothing changed; the window still shows this frame
+    }
+    view.changed = 0;
+
+    SDL_SetRenderTarget(renderer, scene);
+    if (rebuild || !detail) {
+        // Density tiles are few enough to redraw whenever anything moves
+        draw_full(frame);
+    } else {
+        mark_changes(frame);
+        if (num_dirty > 0) {
+            // Clear each dirty cell inside its grid lines, then redraw
+            // whatever now occupies it
+            for (int i = 0; i < num_dirty; i++) {
+                SDL_Rect *rect = batch_push(&fills[COLOR_BLACK]);
+                if (!rect) break;
+                rect->x = offset_x + (dirty_list[i] % drawn.width) * cell_px + 1;
+                rect->y = offset_y + (dirty_list[i] / drawn.width) * cell_px + 1;
+                rect->w = cell_px - 1;
+                rect->h = cell_px - 1;
+            }
+            flush_cells();
+            draw_cells(frame, 1);
+        }
+        for (int i = 0; i < num_dirty; i++) {
+            dirty[dirty_list[i]] = 0;
+        }
+        num_dirty = 0;
+    }
+    SDL_SetRenderTarget(renderer, NULL);
+
+    // If the copy fails the next frame starts from a fresh scene
+    if (frame_copy(&drawn, frame) != 0) {
+        drawn.width = drawn.height = 0;
+    }
+
+    SDL_RenderCopy(renderer, scene, NULL, NULL);
+    draw_mission_lines(frame);
     SDL_RenderPresent(renderer);
-    printf("Frame presented\n");
-    
     return 0;
 }
 
-// Add test survivors at fixed positions for debugging
-void add_test_survivors() {
-    printf("Adding test survivors...\n");
-    
-    // Add survivors in each corner and center
-    Survivor *s1 = malloc(sizeof(Survivor));
-    s1->coord.x = 1;
-    s1->coord.y = 1;
-    s1->status = WAITING;
-    snprintf(s1->info, sizeof(s1->info), "M%d", 1);
-    pthread_mutex_init(&s1->lock, NULL);
-    survivors->add(survivors, s1);
-    printf("Added test survivor at (1,1) with ID %s\n", s1->info);
-
-    Survivor *s2 = malloc(sizeof(Survivor));
-    s2->coord.x = map.width - 2;
-    s2->coord.y = 1;
-    s2->status = WAITING;
-    snprintf(s2->info, sizeof(s2->info), "M%d", 2);
-    pthread_mutex_init(&s2->lock, NULL);
-    survivors->add(survivors, s2);
-    printf("Added test survivor at (%d,1) with ID %s\n", map.width - 2, s2->info);
-
-    Survivor *s3 = malloc(sizeof(Survivor));
-    s3->coord.x = 1;
-    s3->coord.y = map.height - 2;
-    s3->status = WAITING;
-    snprintf(s3->info, sizeof(s3->info), "M%d", 3);
-    pthread_mutex_init(&s3->lock, NULL);
-    survivors->add(survivors, s3);
-    printf("Added test survivor at (1,%d) with ID %s\n", map.height - 2, s3->info);
-
-    Survivor *s4 = malloc(sizeof(Survivor));
-    s4->coord.x = map.width - 2;
-    s4->coord.y = map.height - 2;
-    s4->status = WAITING;
-    snprintf(s4->info, sizeof(s4->info), "M%d", 4);
-    pthread_mutex_init(&s4->lock, NULL);
-    survivors->add(survivors, s4);
-    printf("Added test survivor at (%d,%d) with ID %s\n", map.width - 2, map.height - 2, s4->info);
-
-    Survivor *s5 = malloc(sizeof(Survivor));
-    s5->coord.x = map.width / 2;
-    s5->coord.y = map.height / 2;
-    s5->status = WAITING;
-    snprintf(s5->info, sizeof(s5->info), "M%d", 5);
-    pthread_mutex_init(&s5->lock, NULL);
-    survivors->add(survivors, s5);
-    printf("Added test survivor at center (%d,%d) with ID %s\n", map.width / 2, map.height / 2, s5->info);
-
-    printf("Finished adding test survivors\n");
-}
-
-int init_sdl_window() {
+int init_sdl_window(int width, int height) {
     printf("Starting SDL initialization...\n");
     
     // Initialize SDL with video subsystem
@@ -332,9 +703,10 @@ int init_sdl_window() {
     }
     printf("SDL video subsystem initialized\n");
     
-    // Calculate window dimensions based on map size
-    window_width = map.width * CELL_SIZE;
-    window_height = map.height * CELL_SIZE;
+    // Size the window to the map at the default zoom, up to a limit; larger
+    // maps start zoomed out to fit and can be zoomed and panned
+    window_width = width * CELL_SIZE < MAX_WINDOW_WIDTH ? width * CELL_SIZE : MAX_WINDOW_WIDTH;
+    window_height = height * CELL_SIZE < MAX_WINDOW_HEIGHT ? height * CELL_SIZE : MAX_WINDOW_HEIGHT;
     printf("Initial window dimensions: %dx%d\n", window_width, window_height);
     
     // Set up SDL hints for better rendering
@@ -397,27 +769,31 @@ int init_sdl_window() {
     }
     printf("Blend mode set successfully\n");
     
-    // Add test survivors
-    printf("Adding test survivors...\n");
-    add_test_survivors();
-    printf("Test survivors added successfully\n");
-    
-    // Perform initial render
-    printf("Performing initial render...\n");
-    if (draw_map() != 0) {
-        printf("Initial render failed\n");
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return 1;
-    }
-    printf("Initial render completed\n");
-    
     printf("SDL initialization complete\n");
     return 0;
 }
 
 void cleanup_sdl() {
+    if (scene) {
+        SDL_DestroyTexture(scene);
+        scene = NULL;
+    }
+    no_targets = 0;
+    frame_free(&drawn);
+    free(dirty);
+    free(dirty_list);
+    dirty = NULL;
+    dirty_list = NULL;
+    num_dirty = 0;
+    free(tile_counts);
+    tile_counts = NULL;
+    tile_counts_size = 0;
+    if (grid_texture) {
+        SDL_DestroyTexture(grid_texture);
+        grid_texture = NULL;
+        grid_valid = 0;
+    }
+    view.map_width = view.map_height = 0;
     if (renderer) {
         SDL_DestroyRenderer(renderer);
         renderer = NULL;
@@ -0,0 +1,212 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/frame.h"
+#include "headers/snapshot.h"
+#include "headers/view.h"
+#include "headers/communication.h"
+
+#define SERVER_IP "127.0.0.1"
+#define PORT 8080
+#define READ_CHUNK 65536
+#define TARGET_FPS 60
+
+// Remote viewer: subscribes to the server's world stream and draws it with
+// the same view.c the server uses, without touching any server state
+
+int running = 1;
+static int sock = -1;
+// World as last received, owned by the receive thread. Each change is
+// published to the render loop through the snapshot triple buffer.
+static Frame world;
+// Optional copy of every stream line received, for replaying with render
+static FILE *record = NULL;
+
+static void send_type(const char *type) {
+    struct json_object *msg = json_object_new_object();
+    json_object_object_add(msg, "type", json_object_new_string(type));
+    send_json(sock, msg);
+    json_object_put(msg);
+}
+
+// Apply one line from the server. A delta that doesn't follow on from the
+// frame we hold means something was missed: ask for a snapshot and ignore
+// deltas until it arrives.
+static void handle_line(char *line) {
+    static int resync_pending = 0;
+    if (record) fprintf(record, "%s\n", line);
+    struct json_object *msg = json_tokener_parse(line);
+    if (!msg) {
+        printf("Failed to parse stream message\n");
+        return;
+    }
+    const char *type = json_object_get_string(json_object_object_get(msg, "type"));
+    if (type && strcmp(type, "ERROR") == 0) {
+        printf("Server error: %s\n", json_object_get_string(json_object_object_get(msg, "message")));
+        running = 0;
+        json_object_put(msg);
+        return;
+    }
+
+    int result = frame_apply_json(&world, msg);
+    if (result == 0) {
+        if (type && strcmp(type, "SNAPSHOT") == 0) resync_pending = 0;
+        if (frame_copy(snapshot_back(), &world) == 0) snapshot_publish();
+    } else if (result == 1 && !resync_pending) {
+        printf("Stream gap at seq %llu, requesting resync\n", (unsigned long long)world.seq);
+        resync_pending = 1;
+        send_type("RESYNC");
+    } else if (result < 0) {
+        printf("Malformed %s message ignored\n", type ? type : "stream");
+    }
+    json_object_put(msg);
+}
+
+// Snapshots of a large world can be far longer than receive_json's fixed
+// buffer, so the viewer splits lines itself into a buffer that grows
+static void *receive_thread(void *arg) {
+    (void)arg;
+    size_t capacity = READ_CHUNK, len = 0;
+    char *buffer = malloc(capacity);
+    if (!buffer) {
+        running = 0;
+        return NULL;
+    }
+
+    while (running) {
+        if (capacity - len < READ_CHUNK) {
+            char *grown = realloc(buffer, capacity * 2);
+            if (!grown) break;
+            buffer = grown;
+            capacity *= 2;
+        }
+        ssize_t n = recv(sock, buffer + len, capacity - len, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            printf("Connection to server lost\n");
+            break;
+        }
+        len += n;
+
+        size_t start = 0;
+        char *newline;
+        while ((newline = memchr(buffer + start, '\n', len - start)) != NULL) {
+            *newline = '\0';
+            handle_line(buffer + start);
+            start = newline - buffer + 1;
+        }
+        memmove(buffer, buffer + start, len - start);
+        len -= start;
+    }
+
+    free(buffer);
+    running = 0;
+    return NULL;
+}
+
+static int open_connection(const char *host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Socket creation failed");
+        return -1;
+    }
+
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = inet_addr(host)
+    };
+
+    if (connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        perror("Connection failed");
+        close(fd);
+        return -1;
+    }
+    printf("Connected to server at %s:%d\n", host, port);
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = argc > 1 ? argv[1] : SERVER_IP;
+    int port = argc > 2 ? atoi(argv[2]) : PORT;
+    if (argc > 3) {
+        record = fopen(argv[3], "w");
+        if (!record) {
+            perror("Failed to open recording file");
+            return 1;
+        }
+        printf("Recording stream to %s\n", argv[3]);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    sock = open_connection(host, port);
+    if (sock < 0) return 1;
+    frame_init(&world);
+    send_type("SUBSCRIBE");
+
+    pthread_t receiver;
+    if (pthread_create(&receiver, NULL, receive_thread, NULL) != 0) {
+        printf("Failed to create receive thread\n");
+        close(sock);
+        return 1;
+    }
+
+    // The window is sized from the map, which arrives with the first snapshot
+    const Frame *frame = NULL;
+    while (running && !(frame = snapshot_latest())) {
+        usleep(10000);
+    }
+    if (!frame) {
+        close(sock);
+        return 1;
+    }
+    if (init_sdl_window(frame->width, frame->height) != 0) {
+        printf("Failed to initialize SDL window\n");
+        close(sock);
+        return 1;
+    }
+
+    SDL_Event event;
+    Uint32 lastDrawTime = SDL_GetTicks();
+    const int FRAME_TIME = 1000 / TARGET_FPS;
+
+    while (running) {
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT ||
+                (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_q)) {
+                printf("Received quit event\n");
+                running = 0;
+                break;
+            }
+            view_handle_event(&event);
+        }
+
+        Uint32 currentTime = SDL_GetTicks();
+        if (currentTime - lastDrawTime >= FRAME_TIME) {
+            if (draw_frame(snapshot_latest()) != 0) {
+                printf("Error drawing frame\n");
+                running = 0;
+                break;
+            }
+            lastDrawTime = currentTime;
+        }
+        SDL_Delay(1);
+    }
+
+    // Unblocks the receive thread's recv
+    shutdown(sock, SHUT_RDWR);
+    pthread_join(receiver, NULL);
+    close(sock);
+    if (record) fclose(record);
+    cleanup_sdl();
+    frame_free(&world);
+    return 0;
+}
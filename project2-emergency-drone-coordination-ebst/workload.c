@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <json-c/json.h>
+#include "headers/workload.h"
+#include "headers/survivor.h"
+#include "headers/globals.h"
+#include "headers/fleet.h"
+#include "headers/simclock.h"
+#include "headers/trace.h"
+
+typedef struct generatorstate {
+    int index;
+    uint64_t rng;
+    unsigned long generated;
+    unsigned long dropped;
+    // Position in the phase list, for the event-driven generator
+    int phase;
+    double phase_start;
+    double t;
+} GeneratorState;
+
+typedef struct tracerecord {
+    double offset;     // Seconds since scenario start
+    Coord coord;
+    char payload[16];
+} TraceRecord;
+
+static Scenario scenario;
+static GeneratorState states[MAX_WORKLOAD_THREADS];
+static pthread_t threads[MAX_WORKLOAD_THREADS];
+static int num_threads = 0;
+static int num_states = 0;
+static FILE *trace = NULL;
+static uint64_t scenario_start;  // sim_now_ns() at start
+static TraceRecord *replay_records = NULL;
+static size_t replay_count = 0, replay_next = 0;
+static unsigned long next_survivor_id = 0;
+static Fleet fleet;
+
+// xorshift64*: every generator thread owns its stream, so threads never
+// share RNG state and a seed reproduces the same arrivals
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform in [0, 1)
+static double random_unit(uint64_t *state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double random_exponential(uint64_t *state, double rate) {
+    return -log(1.0 - random_unit(state)) / rate;
+}
+
+static double elapsed_seconds() {
+    return (sim_now_ns() - scenario_start) / 1e9;
+}
+
+// Sleep until `offset` seconds after the scenario start. When a thread is
+// behind schedule it does not sleep at all, which is what lets high rates
+// catch up instead of paying one timer wake-up per survivor. Long waits
+// are cut into 100ms naps so shutdown isn't held up.
+static void wait_until(double offset) {
+    double ahead;
+    while (running && (ahead = offset - elapsed_seconds()) >= 0.001) {
+        if (ahead > 0.1) ahead = 0.1;
+        struct timespec ts = { 0, (long)(ahead * 1e9) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static Coord sample_location(uint64_t *rng, const Phase *phase) {
+    Coord c;
+    if (scenario.num_hotspots > 0 && random_unit(rng) < phase->hotspot_share) {
+        double pick = random_unit(rng) * scenario.hotspot_weight;
+        const Hotspot *h = &scenario.hotspots[scenario.num_hotspots - 1];
+        for (int i = 0; i < scenario.num_hotspots; i++) {
+            pick -= scenario.hotspots[i].weight;
+            if (pick < 0) {
+                h = &scenario.hotspots[i];
+                break;
+            }
+        }
+        // Triangular offsets: denser towards the hotspot centre
+        double dx = (random_unit(rng) + random_unit(rng) - 1.0) * h->radius;
+        double dy = (random_unit(rng) + random_unit(rng) - 1.0) * h->radius;
+        c.x = clamp(h->center.x + (int)lround(dx), 0, map.width - 1);
+        c.y = clamp(h->center.y + (int)lround(dy), 0, map.height - 1);
+    } else {
+        c.x = (int)(random_unit(rng) * map.width);
+        c.y = (int)(random_unit(rng) * map.height);
+    }
+    return c;
+}
+
+static void emit(GeneratorState *state, double offset, Coord coord, const char *payload) {
+    char info[25];
+    unsigned long id = __atomic_add_fetch(&next_survivor_id, 1, __ATOMIC_RELAXED);
+    snprintf(info, sizeof(info), "SURV-%lu", id);
+
+    if (spawn_survivor(coord, info, payload) == 0) {
+        state->generated++;
+    } else {
+        state->dropped++;
+    }
+    if (trace) {
+        // stdio locks the stream, so lines from different threads don't mix
+        fprintf(trace, "%.6f,%d,%d,%s\n", offset, coord.x, coord.y, payload);
+    }
+}
+
+static void *generator_thread(void *arg) {
+    GeneratorState *state = (GeneratorState *)arg;
+    double phase_start = 0;
+    trace_thread_name("workload");
+
+    do {
+        for (int p = 0; p < scenario.num_phases && running; p++) {
+            const Phase *phase = &scenario.phases[p];
+            double phase_end = phase_start + phase->duration;
+            double rate = phase->rate / scenario.threads; // This thread's share
+            int batch = phase->arrival == ARRIVAL_BURSTY ? phase->burst_size : 1;
+            double event_rate = rate / batch;
+
+            if (event_rate > 0) {
+                double t = phase_start;
+                while (running) {
+                    t += phase->arrival == ARRIVAL_CONSTANT ? 1.0 / event_rate
+                                                            : random_exponential(&state->rng, event_rate);
+                    if (t >= phase_end) break;
+                    wait_until(t);
+                    for (int i = 0; i < batch; i++) {
+                        Coord c = sample_location(&state->rng, phase);
+                        const char *payload = payload_types[next_random(&state->rng) % NUM_PAYLOAD_TYPES];
+                        emit(state, t, c, payload);
+                    }
+                }
+            }
+            wait_until(phase_end);
+            phase_start = phase_end;
+        }
+    } while (scenario.loop && running);
+
+    return NULL;
+}
+
+static int compare_records(const void *a, const void *b) {
+    double da = ((const TraceRecord *)a)->offset;
+    double db = ((const TraceRecord *)b)->offset;
+    return (da > db) - (da < db);
+}
+
+// Reads a recorded trace. Records from several generator threads are
+// sorted back into time order. NULL if the file can't be read.
+static TraceRecord *load_trace(size_t *loaded) {
+    FILE *f = fopen(scenario.replay, "r");
+    if (!f) {
+        perror("Failed to open trace for replay");
+        return NULL;
+    }
+
+    size_t count = 0, capacity = 1024;
+    TraceRecord *records = malloc(sizeof(TraceRecord) * capacity);
+    char line[128];
+    while (records && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        if (count == capacity) {
+            capacity *= 2;
+            TraceRecord *grown = realloc(records, sizeof(TraceRecord) * capacity);
+            if (!grown) break;
+            records = grown;
+        }
+        TraceRecord *r = &records[count];
+        if (sscanf(line, "%lf,%d,%d,%15s", &r->offset, &r->coord.x, &r->coord.y, r->payload) == 4 &&
+            r->coord.x >= 0 && r->coord.x < map.width && r->coord.y >= 0 && r->coord.y < map.height) {
+            count++;
+        }
+    }
+    fclose(f);
+    if (!records) {
+        printf("Failed to allocate memory for trace replay\n");
+        return NULL;
+    }
+
+    qsort(records, count, sizeof(TraceRecord), compare_records);
+    printf("Replaying %zu survivors from %s\n", count, scenario.replay);
+    *loaded = count;
+    return records;
+}
+
+// Replays a recorded trace: same cells, same aid, same offsets
+static void *replay_thread(void *arg) {
+    GeneratorState *state = (GeneratorState *)arg;
+    size_t count = 0;
+    trace_thread_name("workload");
+    TraceRecord *records = load_trace(&count);
+    if (!records) return NULL;
+
+    for (size_t i = 0; i < count && running; i++) {
+        wait_until(records[i].offset);
+        emit(state, records[i].offset, records[i].coord, records[i].payload);
+    }
+    free(records);
+    return NULL;
+}
+
+static ArrivalKind parse_arrival(const char *name) {
+    if (name && strcmp(name, "bursty") == 0) return ARRIVAL_BURSTY;
+    if (name && strcmp(name, "constant") == 0) return ARRIVAL_CONSTANT;
+    return ARRIVAL_POISSON;
+}
+
+static double get_double(struct json_object *obj, const char *key, double fallback) {
+    struct json_object *field;
+    return json_object_object_get_ex(obj, key, &field) ? json_object_get_double(field) : fallback;
+}
+
+static void get_string(struct json_object *obj, const char *key, char *dest, size_t size) {
+    struct json_object *field;
+    dest[0] = '\0';
+    if (json_object_object_get_ex(obj, key, &field)) {
+        snprintf(dest, size, "%s", json_object_get_string(field));
+    }
+}
+
+int load_scenario(const char *path, Scenario *sc) {
+    struct json_object *root = json_object_from_file(path);
+    if (!root) {
+        printf("Failed to read scenario file %s\n", path);
+        return 1;
+    }
+
+    memset(sc, 0, sizeof(Scenario));
+    // Unseeded scenarios follow the simulation seed in virtual time
+    sc->seed = (uint64_t)get_double(root, "seed", sim_is_virtual() ? (double)(sim_random() >> 11) : (double)time(NULL));
+    sc->threads = (int)get_double(root, "threads", 1);
+    if (sc->threads < 1) sc->threads = 1;
+    if (sc->threads > MAX_WORKLOAD_THREADS) sc->threads = MAX_WORKLOAD_THREADS;
+    sc->loop = (int)get_double(root, "loop", 0);
+    get_string(root, "trace_out", sc->trace_out, sizeof(sc->trace_out));
+    get_string(root, "replay", sc->replay, sizeof(sc->replay));
+
+    struct json_object *hotspots;
+    if (json_object_object_get_ex(root, "hotspots", &hotspots)) {
+        size_t n = json_object_array_length(hotspots);
+        for (size_t i = 0; i < n && sc->num_hotspots < MAX_HOTSPOTS; i++) {
+            struct json_object *h = json_object_array_get_idx(hotspots, i);
+            Hotspot *spot = &sc->hotspots[sc->num_hotspots++];
+            spot->center.x = (int)get_double(h, "x", 0);
+            spot->center.y = (int)get_double(h, "y", 0);
+            spot->radius = (int)get_double(h, "radius", 2);
+            spot->weight = get_double(h, "weight", 1);
+            sc->hotspot_weight += spot->weight;
+        }
+    }
+
+    struct json_object *phases;
+    if (json_object_object_get_ex(root, "phases", &phases)) {
+        size_t n = json_object_array_length(phases);
+        for (size_t i = 0; i < n && sc->num_phases < MAX_PHASES; i++) {
+            struct json_object *ph = json_object_array_get_idx(phases, i);
+            char arrival[16];
+            get_string(ph, "arrival", arrival, sizeof(arrival));
+            Phase *phase = &sc->phases[sc->num_phases++];
+            phase->duration = get_double(ph, "duration", 60);
+            phase->arrival = parse_arrival(arrival);
+            phase->rate = get_double(ph, "rate", 0.33);
+            phase->burst_size = (int)get_double(ph, "burst_size", 10);
+            if (phase->burst_size < 1) phase->burst_size = 1;
+            phase->hotspot_share = get_double(ph, "hotspot_share", 0);
+        }
+    }
+    struct json_object *fleet_config;
+    if (json_object_object_get_ex(root, "fleet", &fleet_config)) {
+        sc->fleet_drones = (int)get_double(fleet_config, "drones", 0);
+        sc->fleet_threads = (int)get_double(fleet_config, "threads", 1);
+    }
+    json_object_put(root);
+
+    if (sc->num_phases == 0 && sc->replay[0] == '\0' && sc->fleet_drones <= 0) {
+        printf("Scenario %s has no phases, no replay trace and no fleet\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// Loads the scenario and opens its trace output
+static int prepare_workload(const char *path) {
+    if (load_scenario(path, &scenario) != 0) return 1;
+
+    if (scenario.trace_out[0]) {
+        trace = fopen(scenario.trace_out, "w");
+        if (!trace) {
+            perror("Failed to open trace output");
+            return 1;
+        }
+        fprintf(trace, "# offset_s,x,y,payload\n");
+    }
+    return 0;
+}
+
+static void init_states(int count) {
+    num_states = count;
+    for (int i = 0; i < count; i++) {
+        states[i].index = i;
+        states[i].rng = (scenario.seed + 1) * 0x9E3779B97F4A7C15ULL + (uint64_t)i * 0xBF58476D1CE4E5B9ULL;
+        if (states[i].rng == 0) states[i].rng = 1;
+        states[i].generated = 0;
+        states[i].dropped = 0;
+        states[i].phase = 0;
+        states[i].phase_start = 0;
+        states[i].t = 0;
+    }
+}
+
+int start_workload(const char *path) {
+    if (prepare_workload(path) != 0) return 1;
+
+    // Simulated drones move on their own engine and are drawn and streamed
+    // with the real ones; they take no missions from the AI
+    if (scenario.fleet_drones > 0) {
+        if (fleet_init(&fleet, scenario.fleet_drones, map.width, map.height,
+                       scenario.fleet_threads, scenario.seed) != 0 ||
+            fleet_start(&fleet) != 0) {
+            printf("Failed to start simulated fleet\n");
+            fleet_free(&fleet);
+            return 1;
+        }
+        sim_fleet = &fleet;
+        printf("Simulating %d drones with %d thread(s)\n", fleet.count, fleet.num_workers);
+    }
+
+    scenario_start = sim_now_ns();
+    int replay = scenario.replay[0] != '\0';
+    init_states(scenario.num_phases == 0 && !replay ? 0 : replay ? 1 : scenario.threads);
+
+    for (int i = 0; i < num_states; i++) {
+        if (pthread_create(&threads[i], NULL, replay ? replay_thread : generator_thread, &states[i]) != 0) {
+            printf("Failed to create workload thread %d\n", i);
+            num_threads = i;
+            return 1;
+        }
+        num_threads = i + 1;
+    }
+    printf("Workload started from %s: %s, %d thread(s), %d phase(s), %d hotspot(s)\n",
+           path, replay ? "trace replay" : "generated", num_threads,
+           scenario.num_phases, scenario.num_hotspots);
+    return 0;
+}
+
+// Runs fn when the scenario clock reaches offset seconds
+static void schedule_at(double offset, SimEventFn fn, void *arg) {
+    uint64_t at = scenario_start + (uint64_t)(offset * 1e9);
+    uint64_t now = sim_now_ns();
+    sim_schedule(at > now ? at - now : 0, fn, arg);
+}
+
+// generator_thread's schedule as a state machine: moves state->t on to the
+// next arrival, crossing phase ends as needed. Returns 1 once the phases
+// have run out, or when a whole looped pass produces nothing.
+static int next_arrival(GeneratorState *state) {
+    int ended = 0;
+    while (1) {
+        if (state->phase == scenario.num_phases) {
+            if (!scenario.loop || ended > scenario.num_phases) return 1;
+            state->phase = 0;
+        }
+        const Phase *phase = &scenario.phases[state->phase];
+        double phase_end = state->phase_start + phase->duration;
+        double rate = phase->rate / scenario.threads;
+        int batch = phase->arrival == ARRIVAL_BURSTY ? phase->burst_size : 1;
+        double event_rate = rate / batch;
+        if (event_rate > 0) {
+            double t = state->t + (phase->arrival == ARRIVAL_CONSTANT ? 1.0 / event_rate
+                                                                       : random_exponential(&state->rng, event_rate));
+            if (t < phase_end) {
+                state->t = t;
+                return 0;
+            }
+        }
+        state->phase++;
+        state->phase_start = phase_end;
+        state->t = phase_end;
+        ended++;
+    }
+}
+
+static void arrival_event(void *arg) {
+    GeneratorState *state = (GeneratorState *)arg;
+    const Phase *phase = &scenario.phases[state->phase];
+    int batch = phase->arrival == ARRIVAL_BURSTY ? phase->burst_size : 1;
+    for (int i = 0; i < batch; i++) {
+        Coord c = sample_location(&state->rng, phase);
+        const char *payload = payload_types[next_random(&state->rng) % NUM_PAYLOAD_TYPES];
+        emit(state, state->t, c, payload);
+    }
+    if (next_arrival(state) == 0) schedule_at(state->t, arrival_event, state);
+}
+
+static void replay_event(void *arg) {
+    GeneratorState *state = (GeneratorState *)arg;
+    TraceRecord *r = &replay_records[replay_next++];
+    emit(state, r->offset, r->coord, r->payload);
+    if (replay_next < replay_count) {
+        schedule_at(replay_records[replay_next].offset, replay_event, state);
+    }
+}
+
+// Virtual-time counterpart of start_workload: the same arrivals, as events
+// on the simulation queue instead of generator threads. Each generator
+// keeps its own RNG stream, so a seed gives the same survivors in both
+// modes. A "fleet" section is ignored: its engine runs on its own threads.
+int schedule_workload(const char *path) {
+    if (prepare_workload(path) != 0) return 1;
+    if (scenario.fleet_drones > 0) {
+        printf("Simulated fleet in %s ignored in virtual time\n", path);
+    }
+
+    scenario_start = sim_now_ns();
+    int replay = scenario.replay[0] != '\0';
+    init_states(scenario.num_phases == 0 && !replay ? 0 : replay ? 1 : scenario.threads);
+
+    if (replay) {
+        replay_records = load_trace(&replay_count);
+        if (!replay_records) return 1;
+        replay_next = 0;
+        if (replay_count > 0) schedule_at(replay_records[0].offset, replay_event, &states[0]);
+    } else {
+        for (int i = 0; i < num_states; i++) {
+            if (next_arrival(&states[i]) == 0) schedule_at(states[i].t, arrival_event, &states[i]);
+        }
+    }
+    printf("Workload scheduled from %s: %s, %d generator(s), %d phase(s), %d hotspot(s)\n",
+           path, replay ? "trace replay" : "generated", num_states,
+           scenario.num_phases, scenario.num_hotspots);
+    return 0;
+}
+
+// Joins the generator threads (they exit once `running` drops or the
+// phases run out) and prints the totals
+void stop_workload() {
+    unsigned long generated = 0, dropped = 0;
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < num_states; i++) {
+        generated += states[i].generated;
+        dropped += states[i].dropped;
+    }
+    double elapsed = elapsed_seconds();
+    printf("Workload finished: %lu survivors in %.1fs (%.0f/s), %lu dropped (lists full)\n",
+           generated, elapsed, elapsed > 0 ? generated / elapsed : 0.0, dropped);
+    num_threads = 0;
+    num_states = 0;
+    free(replay_records);
+    replay_records = NULL;
+    if (sim_fleet) {
+        // Stop stepping but keep the states: the stream publisher may still
+        // be reading one until cleanup
+        fleet_stop(sim_fleet);
+        printf("Simulated fleet finished: %llu steps, %lu missions completed\n",
+               (unsigned long long)fleet.states[fleet.last].tick, fleet.missions_completed);
+    }
+    if (trace) {
+        fclose(trace);
+        trace = NULL;
+    }
+}